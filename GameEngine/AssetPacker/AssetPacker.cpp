@@ -0,0 +1,204 @@
+//Created by 16007006
+//Command line tool for asset packs.
+//		AssetPacker pack <output.pak> <folder>	Packs every .bmp and .wav in the folder
+//		AssetPacker list <pack>					Shows what is in a pack
+//		AssetPacker verify <pack>				Checks every entry against its checksum
+//Returns 0 on success and 1 on failure, so a build step stops if packing fails.
+//The GameEngine project runs "pack" after this tool is built.
+
+#include "../GameEngine/AssetPack.h"
+#include "../GameEngine/AssetDecoder.h"
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+// Asset names are plain ASCII, so widening each character is enough
+static std::wstring WideName(const std::string& name)
+{
+	return std::wstring(name.begin(), name.end());
+}
+
+// *******************************************************************
+
+// Returns the file names in a folder, without the folder
+static std::vector<std::string> ListFolder(const std::string& folder)
+{
+	std::vector<std::string> names;
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE hFind = FindFirstFileA((folder + "\\*").c_str(), &data);
+	if(hFind == INVALID_HANDLE_VALUE)
+		return names;
+	do
+	{
+		if(!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+			names.push_back(data.cFileName);
+	} while(FindNextFileA(hFind, &data));
+	FindClose(hFind);
+#else
+	DIR* pDir = opendir(folder.c_str());
+	if(!pDir)
+		return names;
+	while(dirent* pEntry = readdir(pDir))
+	{
+		if(pEntry->d_name[0] != '.')
+			names.push_back(pEntry->d_name);
+	}
+	closedir(pDir);
+#endif
+	return names;
+}
+
+// *******************************************************************
+
+// True if the name ends with the extension, ignoring case
+static bool HasExtension(const std::string& name, const char extension[])
+{
+	size_t length = strlen(extension);
+	if(name.size() <= length)
+		return false;
+	for(size_t i=0;i<length;i++)
+	{
+		if(tolower((unsigned char)name[name.size()-length+i]) != extension[i])
+			return false;
+	}
+	return true;
+}
+
+// *******************************************************************
+
+static int Pack(const std::string& output, const std::string& folder)
+{
+	AssetPackWriter writer;
+	int pictures = 0;
+	int sounds = 0;
+
+	std::vector<std::string> names = ListFolder(folder);
+	for(const std::string& name : names)
+	{
+		std::wstring path = WideName(folder + "/" + name);
+
+		if(HasExtension(name, ".bmp"))
+		{
+			int width, height;
+			std::vector<unsigned int> pixels;
+			if(AssetDecoder::DecodeBMP(path.c_str(), width, height, pixels) == FAILURE)
+			{
+				// Left out - the engine will still load it from its own file
+				printf("Skipped %s - not a supported BMP\n", name.c_str());
+				continue;
+			}
+			if(writer.AddPicture(name, width, height, pixels) == FAILURE)
+			{
+				printf("Could not add %s\n", name.c_str());
+				return 1;
+			}
+			pictures++;
+		}
+		else if(HasExtension(name, ".wav"))
+		{
+			int channels, samplesPerSec, bitsPerSample;
+			std::vector<unsigned char> samples;
+			if(AssetDecoder::DecodeWAV(path.c_str(), channels, samplesPerSec, bitsPerSample, samples) == FAILURE)
+			{
+				printf("Skipped %s - not a PCM WAV\n", name.c_str());
+				continue;
+			}
+			if(writer.AddSound(name, channels, samplesPerSec, bitsPerSample, samples) == FAILURE)
+			{
+				printf("Could not add %s\n", name.c_str());
+				return 1;
+			}
+			sounds++;
+		}
+	}
+
+	if(writer.Write(output) == FAILURE)
+	{
+		printf("Could not write %s\n", output.c_str());
+		return 1;
+	}
+	printf("Packed %d pictures and %d sounds into %s\n", pictures, sounds, output.c_str());
+	return 0;
+}
+
+// *******************************************************************
+
+static int List(const std::string& filename)
+{
+	AssetPack pack;
+	if(pack.Open(WideName(filename).c_str()) == FAILURE)
+	{
+		printf("Could not open %s\n", filename.c_str());
+		return 1;
+	}
+
+	for(unsigned int i=0;i<pack.GetNumEntries();i++)
+	{
+		const AssetPackEntry& entry = pack.GetEntry(i);
+		if(entry.m_Type == ASSET_PICTURE)
+			printf("%-32s picture %5u x %-5u", entry.m_Name, entry.m_Width, entry.m_Height);
+		else
+			printf("%-32s sound   %u ch %5u Hz %2u bit", entry.m_Name, entry.m_Channels, entry.m_SamplesPerSec, entry.m_BitsPerSample);
+		printf(" %10llu bytes at %llu\n", entry.m_Size, entry.m_Offset);
+	}
+	printf("%u entries\n", pack.GetNumEntries());
+	return 0;
+}
+
+// *******************************************************************
+
+static int Verify(const std::string& filename)
+{
+	// Opening checks the index
+	AssetPack pack;
+	if(pack.Open(WideName(filename).c_str()) == FAILURE)
+	{
+		printf("%s is missing or its index is damaged\n", filename.c_str());
+		return 1;
+	}
+
+	int bad = 0;
+	for(unsigned int i=0;i<pack.GetNumEntries();i++)
+	{
+		const AssetPackEntry& entry = pack.GetEntry(i);
+		if(pack.Verify(entry) == FAILURE)
+		{
+			printf("Checksum mismatch: %s\n", entry.m_Name);
+			bad++;
+		}
+	}
+
+	if(bad > 0)
+	{
+		printf("%d of %u entries damaged\n", bad, pack.GetNumEntries());
+		return 1;
+	}
+	printf("All %u entries OK\n", pack.GetNumEntries());
+	return 0;
+}
+
+// *******************************************************************
+
+int main(int argc, char* argv[])
+{
+	if(argc == 4 && strcmp(argv[1], "pack") == 0)
+		return Pack(argv[2], argv[3]);
+	if(argc == 3 && strcmp(argv[1], "list") == 0)
+		return List(argv[2]);
+	if(argc == 3 && strcmp(argv[1], "verify") == 0)
+		return Verify(argv[2]);
+
+	printf("Usage:\n");
+	printf("  AssetPacker pack <output.pak> <folder>\n");
+	printf("  AssetPacker list <pack>\n");
+	printf("  AssetPacker verify <pack>\n");
+	return 1;
+}
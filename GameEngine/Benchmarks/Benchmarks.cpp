@@ -0,0 +1,43 @@
+//Created by 16007006
+//Command line runner for the benchmarks.
+//		Benchmarks broadphase		Broadphase pair counts and timings
+//		Benchmarks components		The game's objects through UpdateAll, and the cost of a timer per component
+//		Benchmarks shapes			Shape pair tests through the type table and through casts
+//		Benchmarks narrowphase		Narrowphase chunks on a worker pool, on one thread and more
+//Returns 0 on success and 1 if the benchmark name is not known.
+
+#include "Benchmarks.h"
+#include <cstdio>
+#include <cstring>
+
+static void PrintUsage()
+{
+	printf("Usage:\n");
+	printf("  Benchmarks broadphase    Broadphase pair counts and timings\n");
+	printf("  Benchmarks components    The game's objects through UpdateAll, and the cost of a timer per component\n");
+	printf("  Benchmarks shapes        Shape pair tests through the type table and through casts\n");
+	printf("  Benchmarks narrowphase   Narrowphase chunks on a worker pool, on one thread and more\n");
+}
+
+// *******************************************************************
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if(strcmp(argv[1], "broadphase") == 0)
+		return BroadphaseBenchmark();
+	if(strcmp(argv[1], "components") == 0)
+		return ComponentBenchmark();
+	if(strcmp(argv[1], "shapes") == 0)
+		return ShapeBenchmark();
+	if(strcmp(argv[1], "narrowphase") == 0)
+		return NarrowphaseBenchmark();
+
+	PrintUsage();
+	return 1;
+}
@@ -0,0 +1,118 @@
+//Created by 16007006
+//Broadphase benchmark. Objects are squares the size of the game's rocks and UFO
+//(35 to 50 units across the radius), scattered either over one 3840x2160 area, or at
+//the game's density of about 50 objects per 1920x1080 screen. Every object drifts a
+//little each frame, so sweep and prune sees the frame-to-frame coherence it relies on.
+//The grid and sweep and prune are checked against each other every run.
+
+#include "Benchmarks.h"
+#include "../GameEngine/Broadphase.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+static const int FRAMES = 10;				// Frames timed for each case
+static const int ALLPAIRSLIMIT = 2000;		// Above this the all-pairs list is too big to build - it is only counted
+
+// Fills proxies with count objects spread over a width x height area
+static void MakeProxies(std::vector<BroadphaseProxy>& proxies, std::vector<float>& drift, int count, float width, float height)
+{
+	srand(1);
+	proxies.resize(count);
+	drift.resize(count);
+	for(int i=0;i<count;i++)
+	{
+		float radius = 35.0f + float(rand() % 16);
+		float x = float(rand()) / RAND_MAX * width;
+		float y = float(rand()) / RAND_MAX * height;
+		BroadphaseProxy& proxy = proxies[i];
+		proxy.minX = x - radius;
+		proxy.maxX = x + radius;
+		proxy.minY = y - radius;
+		proxy.maxY = y + radius;
+		proxy.layer = 1;
+		proxy.mask = 1;
+		proxy.pObject = nullptr;
+		proxy.slot = i;
+		drift[i] = float(rand() % 11 - 5);
+	}
+}
+
+// Moves every proxy along X by its drift
+static void Drift(std::vector<BroadphaseProxy>& proxies, const std::vector<float>& drift)
+{
+	for(size_t i=0;i<proxies.size();i++)
+	{
+		proxies[i].minX += drift[i];
+		proxies[i].maxX += drift[i];
+	}
+}
+
+// Runs FRAMES frames through broadphase, returning milliseconds per frame. pairs is left with the last frame's pairs.
+static double TimeBroadphase(IBroadphase& broadphase, std::vector<BroadphaseProxy> proxies, const std::vector<float>& drift, std::vector<BroadphasePair>& pairs)
+{
+	broadphase.FindPairs(proxies, pairs);		// First frame builds any persistent state - not timed
+	double total = 0.0;
+	for(int frame=0;frame<FRAMES;frame++)
+	{
+		Drift(proxies, drift);
+		double start = BenchmarkSeconds();
+		broadphase.FindPairs(proxies, pairs);
+		total += BenchmarkSeconds() - start;
+	}
+	return total * 1000.0 / FRAMES;
+}
+
+// *******************************************************************
+
+int BroadphaseBenchmark()
+{
+	const int counts[] = {1000, 10000, 50000};
+	const char* layouts[] = {"3840x2160", "game density"};
+	bool allMatch = true;
+
+	printf("%-7s %-13s %15s %12s %10s %12s %10s %12s\n", "objects", "layout", "all pairs", "grid pairs", "grid ms", "s&p pairs", "s&p ms", "all pairs ms");
+	for(int count : counts)
+	{
+		for(int layout=0;layout<2;layout++)
+		{
+			float width = 3840.0f, height = 2160.0f;
+			if(layout == 1)
+			{
+				float screens = std::sqrt(count / 50.0f);
+				width = 1920.0f * screens;
+				height = 1080.0f * screens;
+			}
+			std::vector<BroadphaseProxy> proxies;
+			std::vector<float> drift;
+			MakeProxies(proxies, drift, count, width, height);
+
+			UniformGridBroadphase grid;
+			SweepAndPruneBroadphase sweepAndPrune;
+			std::vector<BroadphasePair> gridPairs, sweepPairs;
+			double gridMs = TimeBroadphase(grid, proxies, drift, gridPairs);
+			double sweepMs = TimeBroadphase(sweepAndPrune, proxies, drift, sweepPairs);
+
+			bool match = gridPairs.size() == sweepPairs.size();
+			for(size_t i=0;match && i<gridPairs.size();i++)
+				match = gridPairs[i].first == sweepPairs[i].first && gridPairs[i].second == sweepPairs[i].second;
+			allMatch = allMatch && match;
+
+			long long allPairs = (long long)count * (count - 1) / 2;
+			char allPairsMs[32] = "-";
+			if(count <= ALLPAIRSLIMIT)
+			{
+				AllPairsBroadphase all;
+				std::vector<BroadphasePair> pairs;
+				snprintf(allPairsMs, sizeof(allPairsMs), "%.3f", TimeBroadphase(all, proxies, drift, pairs));
+			}
+
+			printf("%-7d %-13s %15lld %12zu %10.3f %12zu %10.3f %12s %s\n", count, layouts[layout], allPairs,
+				gridPairs.size(), gridMs, sweepPairs.size(), sweepMs, allPairsMs, match ? "" : "MISMATCH");
+		}
+	}
+
+	printf(allMatch ? "Grid and sweep and prune found the same pairs in every case\n" : "Grid and sweep and prune disagree\n");
+	return allMatch ? 0 : 1;
+}
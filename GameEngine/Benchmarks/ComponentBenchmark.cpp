@@ -0,0 +1,122 @@
+//Created by 16007006
+//Component update benchmark. Builds the object mix Game::StartOfGame spawns - the UFO,
+//50 rocks and 5 cows - with the real ObjectManager, and steps it as Game::Update does,
+//handing every component the same FrameContext. The mix is also run many times over,
+//as one copy takes too little time to measure well. Then times the real GameTimer::mark()
+//once per component, which is what the components cost when each timed the frame itself.
+//The draw and sound engines are started headless, so no window or sound card is needed.
+//Run it from the game's folder so the pictures and sounds are found - if they are not,
+//the loads fail and are logged, which does not change the update times.
+
+#include "Benchmarks.h"
+#include "../GameEngine/ObjectManager.h"
+#include "../GameEngine/GameObject.h"
+#include "../GameEngine/gametimer.h"
+#include "../GameEngine/mydrawengine.h"
+#include "../GameEngine/mysoundengine.h"
+#include "../GameEngine/AssetLoader.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static const int STEPS = 120;				// Steps in a round - two seconds of the game at 60Hz
+static const int ROUNDS = 10;				// Rounds timed for each size of mix, each from a fresh mix
+static const float STEPTIME = 1.0f / 60.0f;	// As Game's default simulationStep
+static const int COPIES[] = {1, 20};		// Sizes of mix, in copies of the game's objects
+
+// *******************************************************************
+
+// Spawns the objects Game::StartOfGame does, copies times over. Returns the number of components.
+static int CreateGameMix(ObjectManager& objectManager, int copies)
+{
+	int components = 0;
+	for(int copy=0;copy<copies;copy++)
+	{
+		components += objectManager.CreateUFO(Vector2D(-960, 0))->GetComponentCount();
+		for(int i=0;i<50;i++)
+		{
+			components += objectManager.CreateRock(Vector2D(rand() % 3840, rand() % 2160 - 1080),
+												   Vector2D(rand() % 200 - 600, 0.0f),
+												   (rand() % 200 - 100) * 0.01f)->GetComponentCount();
+		}
+		for(int i=0;i<5;i++)
+		{
+			components += objectManager.CreateCow(Vector2D(rand() % 3840, rand() % 2160 - 1080),
+												  Vector2D(rand() % 100 - 200, 0.0f),
+												  (rand() % 300 - 200) * 0.01f)->GetComponentCount();
+		}
+	}
+	return components;
+}
+
+// *******************************************************************
+
+int ComponentBenchmark()
+{
+	if(MyDrawEngine::StartHeadless(1920, 1080) == FAILURE || !MySoundEngine::StartHeadless() || AssetLoader::Start() == FAILURE)
+	{
+		printf("Could not start the headless engines\n");
+		return 1;
+	}
+
+	printf("The game's object mix, %d rounds of %d steps. Component pass as timed by UpdateAll.\n", ROUNDS, STEPS);
+	printf("%-8s %10s %10s %12s %12s %12s\n", "copies", "objects", "components", "ns/object", "us/pass", "ms/UpdateAll");
+
+	int mostComponents = 0;
+	for(int copies : COPIES)
+	{
+		srand(1);
+		ObjectManager objectManager;
+		int objects = 0, components = 0;
+		double componentSeconds = 0.0, stepSeconds = 0.0;
+		long long objectSteps = 0;
+		for(int round=0;round<ROUNDS;round++)
+		{
+			objectManager.DeleteAll();
+			components = CreateGameMix(objectManager, copies);
+			objects = objectManager.GetObjectCount();
+
+			// As the fixed step loop in Game::Update, with no keys held
+			FrameContext frame = FrameContext();
+			for(int step=0;step<STEPS;step++)
+			{
+				frame.frameTime = STEPTIME;
+				frame.gameTime += STEPTIME;
+				frame.frameNumber++;
+
+				double start = BenchmarkSeconds();
+				objectManager.DeleteInactive();
+				objectSteps += objectManager.GetObjectCount();
+				objectManager.UpdateAll(frame);
+				stepSeconds += BenchmarkSeconds() - start;
+				componentSeconds += objectManager.GetUpdateTime();
+			}
+		}
+		objectManager.DeleteAll();		// Components release their sounds while the engine is still there
+		if(components > mostComponents)
+			mostComponents = components;
+
+		int passes = ROUNDS * STEPS;
+		printf("%-8d %10d %10d %12.1f %12.2f %12.3f\n", copies, objects, components,
+			   componentSeconds * 1e9 / objectSteps, componentSeconds * 1e6 / passes, stepSeconds * 1000.0 / passes);
+	}
+
+	// What the same components cost when each held a GameTimer and marked it every update
+	std::vector<GameTimer> timers(mostComponents);
+	for(GameTimer& timer : timers)
+		timer.mark();
+	double start = BenchmarkSeconds();
+	for(int step=0;step<STEPS;step++)
+	{
+		for(GameTimer& timer : timers)
+			timer.mark();
+	}
+	double markNs = (BenchmarkSeconds() - start) * 1e9 / (double(STEPS) * mostComponents);
+	printf("\nOne GameTimer per component, as before FrameContext: %.1f ns/update for mark(), %d bytes each\n", markNs, int(sizeof(GameTimer)));
+	printf("%d components would add %.2f us to every pass\n", mostComponents, markNs * mostComponents / 1000.0);
+
+	AssetLoader::Terminate();
+	MyDrawEngine::Terminate();
+	MySoundEngine::Terminate();
+	return 0;
+}
@@ -0,0 +1,116 @@
+//Created by 16007006
+//Narrowphase benchmark. 20000 circles and boxes the size of the game's rocks and cows
+//are scattered over a 12000x6000 area, the grid finds the candidate pairs, and the pairs
+//are tested in chunks on a WorkerPool as ObjectManager::CheckAllCollisions does, on one
+//thread and then on more. The contacts must come back in the same order every time.
+
+#include "Benchmarks.h"
+#include "../GameEngine/Broadphase.h"
+#include "../GameEngine/Shapes.h"
+#include "../GameEngine/WorkerPool.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <thread>
+
+static const int OBJECTS = 20000;
+static const int PAIRSPERCHUNK = 256;		// As ObjectManager::PAIRSPERCHUNK
+static const int STEPS = 100;				// Steps timed for each thread count
+
+// As ObjectManager::ContactBuffer, holding the index of each pair found touching
+struct ChunkContacts
+{
+	std::vector<int> contacts;
+	char padding[64];
+};
+
+// *******************************************************************
+
+int NarrowphaseBenchmark()
+{
+	srand(7);
+	std::vector<std::unique_ptr<IShape2D>> shapes;
+	std::vector<BroadphaseProxy> proxies(OBJECTS);
+	for(int i=0;i<OBJECTS;i++)
+	{
+		float x = float(rand() % 12000);
+		float y = float(rand() % 6000);
+		float halfWidth = 50.0f, halfHeight = 50.0f;
+		if(i % 2)
+		{
+			shapes.push_back(std::unique_ptr<IShape2D>(new Circle2D(Vector2D(x, y), 50.0f)));
+		}
+		else
+		{
+			halfWidth = 35.0f;
+			halfHeight = 20.0f;
+			Rectangle2D* pRect = new Rectangle2D;
+			pRect->PlaceAt(Vector2D(x - halfWidth, y - halfHeight), Vector2D(x + halfWidth, y + halfHeight));
+			shapes.push_back(std::unique_ptr<IShape2D>(pRect));
+		}
+		BroadphaseProxy& proxy = proxies[i];
+		proxy.minX = x - halfWidth;
+		proxy.maxX = x + halfWidth;
+		proxy.minY = y - halfHeight;
+		proxy.maxY = y + halfHeight;
+		proxy.layer = 1;
+		proxy.mask = 1;
+		proxy.pObject = nullptr;
+		proxy.slot = i;
+		proxy.pShape = shapes.back().get();
+		proxy.continuous = false;
+	}
+
+	UniformGridBroadphase grid;
+	std::vector<BroadphasePair> pairs;
+	grid.FindPairs(proxies, pairs);
+	int numChunks = (int(pairs.size()) + PAIRSPERCHUNK - 1) / PAIRSPERCHUNK;
+	std::vector<ChunkContacts> buffers(numChunks);
+
+	std::function<void(int)> testChunk = [&](int chunk)
+	{
+		ChunkContacts& buffer = buffers[chunk];
+		buffer.contacts.clear();
+		int end = std::min(int(pairs.size()), (chunk + 1) * PAIRSPERCHUNK);
+		for(int i=chunk*PAIRSPERCHUNK;i<end;i++)
+		{
+			if(proxies[pairs[i].first].pShape->Intersects(*proxies[pairs[i].second].pShape))
+				buffer.contacts.push_back(i);
+		}
+	};
+
+	int cores = int(std::thread::hardware_concurrency());
+	printf("%d objects, %d candidate pairs, %d chunks, %d cores\n", OBJECTS, int(pairs.size()), numChunks, cores);
+	printf("%-8s %10s %10s %10s\n", "threads", "ms/step", "speedup", "contacts");
+
+	bool sameOrder = true;
+	std::vector<int> firstOrder;
+	double oneThread = 0.0;
+	int maxThreads = std::max(4, cores);
+	for(int threads=1;threads<=maxThreads;threads*=2)
+	{
+		WorkerPool pool(threads);
+		pool.Run(numChunks, testChunk);		// Starts the threads - not timed
+
+		double start = BenchmarkSeconds();
+		for(int step=0;step<STEPS;step++)
+			pool.Run(numChunks, testChunk);
+		double ms = (BenchmarkSeconds() - start) * 1000.0 / STEPS;
+		if(threads == 1)
+			oneThread = ms;
+
+		// Read back in chunk order, as CheckAllCollisions does
+		std::vector<int> order;
+		for(const ChunkContacts& buffer : buffers)
+			order.insert(order.end(), buffer.contacts.begin(), buffer.contacts.end());
+		if(threads == 1)
+			firstOrder = order;
+		else if(order != firstOrder)
+			sameOrder = false;
+
+		printf("%-8d %10.3f %9.2fx %10d%s\n", threads, ms, oneThread / ms, int(order.size()), order == firstOrder ? "" : "  ORDER DIFFERS");
+	}
+	return sameOrder ? 0 : 1;
+}
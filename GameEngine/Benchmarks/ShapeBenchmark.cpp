@@ -0,0 +1,162 @@
+//Created by 16007006
+//Shape intersection benchmark. Runs the pair tests through IShape2D::Intersects, which
+//finds the test from the type-tag table, against the dynamic_cast chain it replaced.
+//Both must report the same hits for every pair of shape types.
+
+#include "Benchmarks.h"
+#include "../GameEngine/Shapes.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+static const int SHAPESPERTYPE = 1024;		// A power of two, so the other shape can be picked with a mask
+static const int ROUNDS = 2000;
+
+static const char* const shapeNames[NUMSHAPETYPES] = {"Point", "Segment", "Circle", "Rect"};
+
+// *******************************************************************
+
+// The old IShape2D::Intersects of the first shape - the other shape is tried
+// against each concrete type in turn, and asked to test against the first
+template <class FIRST>
+static bool CastChain(const FIRST& first, const IShape2D& other)
+{
+	const Rectangle2D* pRect = dynamic_cast<const Rectangle2D*>(&other);
+	if(pRect)
+		return pRect->Intersects(first);
+	const Circle2D* pCirc = dynamic_cast<const Circle2D*>(&other);
+	if(pCirc)
+		return pCirc->Intersects(first);
+	const Segment2D* pSeg = dynamic_cast<const Segment2D*>(&other);
+	if(pSeg)
+		return pSeg->Intersects(first);
+	const Point2D* pPoint = dynamic_cast<const Point2D*>(&other);
+	if(pPoint)
+		return pPoint->Intersects(first);
+	return false;
+}
+
+// The old test used a virtual call to reach the first shape's chain. The tag
+// stands in for it here, which if anything flatters the old way.
+static bool CastIntersects(const IShape2D& first, const IShape2D& second)
+{
+	switch(first.GetType())
+	{
+	case SHAPE_POINT:
+		return CastChain(static_cast<const Point2D&>(first), second);
+	case SHAPE_SEGMENT:
+		return CastChain(static_cast<const Segment2D&>(first), second);
+	case SHAPE_CIRCLE:
+		return CastChain(static_cast<const Circle2D&>(first), second);
+	default:
+		return CastChain(static_cast<const Rectangle2D&>(first), second);
+	}
+}
+
+// *******************************************************************
+
+// A coordinate somewhere in a 100 by 100 area
+static float RandomCoordinate()
+{
+	return float(rand() % 1000) / 10.0f;
+}
+
+static IShape2D* MakeShape(ShapeType type)
+{
+	switch(type)
+	{
+	case SHAPE_POINT:
+		return new Point2D(RandomCoordinate(), RandomCoordinate());
+	case SHAPE_SEGMENT:
+	{
+		Segment2D* pSegment = new Segment2D;
+		pSegment->PlaceAt(Vector2D(RandomCoordinate(), RandomCoordinate()), Vector2D(RandomCoordinate(), RandomCoordinate()));
+		return pSegment;
+	}
+	case SHAPE_CIRCLE:
+		return new Circle2D(Vector2D(RandomCoordinate(), RandomCoordinate()), RandomCoordinate() / 4);
+	default:
+	{
+		Rectangle2D* pRect = new Rectangle2D;
+		float x = RandomCoordinate();
+		float y = RandomCoordinate();
+		pRect->PlaceAt(Vector2D(x, y), Vector2D(x + RandomCoordinate() / 4, y + RandomCoordinate() / 4));
+		return pRect;
+	}
+	}
+}
+
+// Runs rounds passes over firsts, each shape tested against one from seconds picked by the round.
+// Returns the number of hits, and sets rate to millions of tests per second.
+template <bool (*TEST)(const IShape2D&, const IShape2D&)>
+static long long TimePairs(const std::vector<const IShape2D*>& firsts, const std::vector<const IShape2D*>& seconds, int rounds, double& rate)
+{
+	long long hits = 0;
+	size_t count = firsts.size();
+	double start = BenchmarkSeconds();
+	for(int round=0;round<rounds;round++)
+	{
+		for(size_t i=0;i<count;i++)
+		{
+			if(TEST(*firsts[i], *seconds[(i * 7 + round) % count]))
+				hits++;
+		}
+	}
+	rate = double(rounds) * count / (BenchmarkSeconds() - start) / 1e6;
+	return hits;
+}
+
+static bool TableIntersects(const IShape2D& first, const IShape2D& second)
+{
+	return first.Intersects(second);
+}
+
+// *******************************************************************
+
+int ShapeBenchmark()
+{
+	srand(1);
+	std::vector<std::unique_ptr<IShape2D>> owned;
+	std::vector<const IShape2D*> shapes[NUMSHAPETYPES];
+	std::vector<const IShape2D*> mixed;
+	for(int type=0;type<NUMSHAPETYPES;type++)
+	{
+		for(int i=0;i<SHAPESPERTYPE;i++)
+		{
+			owned.push_back(std::unique_ptr<IShape2D>(MakeShape(ShapeType(type))));
+			shapes[type].push_back(owned.back().get());
+			mixed.push_back(owned.back().get());
+		}
+	}
+	// So the branch predictor cannot learn the order of the types
+	for(size_t i=mixed.size()-1;i>0;i--)
+		std::swap(mixed[i], mixed[rand() % (i + 1)]);
+
+	printf("%d shapes of each type, %d rounds. Millions of tests per second.\n", SHAPESPERTYPE, ROUNDS);
+	printf("%-20s %10s %10s %10s\n", "", "casts", "table", "hits");
+
+	bool agree = true;
+	for(int first=0;first<NUMSHAPETYPES;first++)
+	{
+		for(int second=0;second<NUMSHAPETYPES;second++)
+		{
+			double castRate, tableRate;
+			long long castHits = TimePairs<CastIntersects>(shapes[first], shapes[second], ROUNDS, castRate);
+			long long tableHits = TimePairs<TableIntersects>(shapes[first], shapes[second], ROUNDS, tableRate);
+			char name[32];
+			snprintf(name, sizeof(name), "%s x %s", shapeNames[first], shapeNames[second]);
+			printf("%-20s %10.1f %10.1f %10lld%s\n", name, castRate, tableRate, tableHits, castHits == tableHits ? "" : "  MISMATCH");
+			agree = agree && castHits == tableHits;
+		}
+	}
+
+	double castRate, tableRate;
+	long long castHits = TimePairs<CastIntersects>(mixed, mixed, ROUNDS / NUMSHAPETYPES, castRate);
+	long long tableHits = TimePairs<TableIntersects>(mixed, mixed, ROUNDS / NUMSHAPETYPES, tableRate);
+	printf("%-20s %10.1f %10.1f %10lld%s\n", "Shuffled mix", castRate, tableRate, tableHits, castHits == tableHits ? "" : "  MISMATCH");
+	agree = agree && castHits == tableHits;
+
+	return agree ? 0 : 1;
+}
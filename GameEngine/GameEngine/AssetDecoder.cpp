@@ -0,0 +1,226 @@
+//Created by 16007006
+//BMP decoding moved here from SoftwareBackend, so the AssetPacker tool can share it.
+//WAV files are read chunk by chunk, as mmioDescend does in MySoundEngine::LoadWav.
+
+#include "AssetDecoder.h"
+#include <fstream>
+#include <cstdlib>
+
+std::string AssetDecoder::NarrowName(const wchar_t filename[])
+{
+	std::string narrowName;
+	for(const wchar_t* p = filename; *p; p++)
+		narrowName += char(*p);
+	return narrowName;
+}
+
+// *******************************************************************
+
+// Reads a little-endian integer from a byte buffer
+static unsigned int ReadLE(const std::vector<unsigned char>& data, size_t offset, int bytes)
+{
+	unsigned int value = 0;
+	for(int i=bytes-1;i>=0;i--)
+		value = (value << 8) | data[offset+i];
+	return value;
+}
+
+// *******************************************************************
+
+ErrorType AssetDecoder::DecodeBMP(const wchar_t filename[], int& width, int& height, std::vector<unsigned int>& pixels)
+{
+	std::ifstream file(NarrowName(filename).c_str(), std::ios::binary);
+	if(!file)
+		return FAILURE;
+	std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	// File header and the start of the info header
+	if(data.size() < 54 || data[0] != 'B' || data[1] != 'M')
+		return FAILURE;
+	unsigned int pixelOffset = ReadLE(data, 10, 4);
+	unsigned int infoSize = ReadLE(data, 14, 4);
+	width = int(ReadLE(data, 18, 4));
+	height = int(ReadLE(data, 22, 4));
+	int bitCount = int(ReadLE(data, 28, 2));
+	unsigned int compression = ReadLE(data, 30, 4);
+	unsigned int coloursUsed = ReadLE(data, 46, 4);
+
+	// Negative height means the rows are stored top first
+	bool topDown = height < 0;
+	if(topDown)
+		height = -height;
+
+	// Only uncompressed files. Bitfields are accepted for 32-bit files, assuming BGRA order.
+	if(width <= 0 || height <= 0 || !(compression == 0 || (compression == 3 && bitCount == 32)))
+		return FAILURE;
+	if(bitCount != 8 && bitCount != 24 && bitCount != 32)
+		return FAILURE;
+
+	size_t stride = ((size_t(width) * bitCount + 31) / 32) * 4;
+	if(pixelOffset + stride * height > data.size())
+		return FAILURE;
+
+	// Palette for 8-bit files follows the info header
+	size_t paletteOffset = 14 + infoSize;
+	if(bitCount == 8 && coloursUsed == 0)
+		coloursUsed = 256;
+
+	pixels.resize(size_t(width) * height);
+
+	bool anyAlpha = false;
+	for(int y=0;y<height;y++)
+	{
+		size_t rowOffset = pixelOffset + stride * (topDown ? y : height-1-y);
+		unsigned int* out = &pixels[size_t(y) * width];
+		for(int x=0;x<width;x++)
+		{
+			unsigned int pixel;
+			if(bitCount == 32)
+			{
+				pixel = ReadLE(data, rowOffset + x*4, 4);
+				anyAlpha = anyAlpha || (pixel >> 24) != 0;
+			}
+			else if(bitCount == 24)
+			{
+				pixel = 0xFF000000 | ReadLE(data, rowOffset + x*3, 3);
+			}
+			else
+			{
+				unsigned int index = data[rowOffset + x];
+				size_t entry = paletteOffset + 4 * index;
+				pixel = (index < coloursUsed && entry + 3 < data.size()) ? (0xFF000000 | ReadLE(data, entry, 3)) : 0xFF000000;
+			}
+			out[x] = pixel;
+		}
+	}
+
+	// 32-bit files with nothing in the alpha channel are meant to be opaque
+	if(bitCount == 32 && !anyAlpha)
+	{
+		for(unsigned int& pixel : pixels)
+			pixel |= 0xFF000000;
+	}
+
+	// Colour key - opaque black becomes transparent, as D3DXCreateTextureFromFileEx does
+	for(unsigned int& pixel : pixels)
+	{
+		if(pixel == 0xFF000000)
+			pixel = 0;
+	}
+
+	return SUCCESS;
+}	// DecodeBMP
+
+// *******************************************************************
+
+// Reads just the file header and the start of the info header
+ErrorType AssetDecoder::ReadBMPSize(const wchar_t filename[], int& width, int& height)
+{
+	std::ifstream file(NarrowName(filename).c_str(), std::ios::binary);
+	std::vector<unsigned char> data(26);
+	if(!file.read((char*)data.data(), data.size()) || data[0] != 'B' || data[1] != 'M')
+		return FAILURE;
+
+	width = int(ReadLE(data, 18, 4));
+	height = std::abs(int(ReadLE(data, 22, 4)));
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType AssetDecoder::DecodeWAV(const wchar_t filename[], int& channels, int& samplesPerSec, int& bitsPerSample, std::vector<unsigned char>& samples)
+{
+	std::ifstream file(NarrowName(filename).c_str(), std::ios::binary);
+	if(!file)
+		return FAILURE;
+	std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	// RIFF header, then a list of chunks
+	if(data.size() < 12 || data[0] != 'R' || data[1] != 'I' || data[2] != 'F' || data[3] != 'F'
+		|| data[8] != 'W' || data[9] != 'A' || data[10] != 'V' || data[11] != 'E')
+		return FAILURE;
+
+	bool foundFormat = false;
+	size_t offset = 12;
+	while(offset + 8 <= data.size())
+	{
+		const unsigned char* id = &data[offset];
+		size_t chunkSize = ReadLE(data, offset + 4, 4);
+		size_t chunkStart = offset + 8;
+		if(chunkStart + chunkSize > data.size())
+			chunkSize = data.size() - chunkStart;		// Some files claim more data than they hold
+
+		if(id[0] == 'f' && id[1] == 'm' && id[2] == 't' && id[3] == ' ')
+		{
+			// Only PCM, the same as LoadWav
+			if(chunkSize < 16 || ReadLE(data, chunkStart, 2) != 1)
+				return FAILURE;
+			channels = int(ReadLE(data, chunkStart + 2, 2));
+			samplesPerSec = int(ReadLE(data, chunkStart + 4, 4));
+			bitsPerSample = int(ReadLE(data, chunkStart + 14, 2));
+			foundFormat = true;
+		}
+		else if(id[0] == 'd' && id[1] == 'a' && id[2] == 't' && id[3] == 'a')
+		{
+			if(!foundFormat)
+				return FAILURE;
+			samples.assign(data.begin() + chunkStart, data.begin() + chunkStart + chunkSize);
+			return SUCCESS;
+		}
+
+		// Chunks are padded to an even size
+		offset = chunkStart + chunkSize + (chunkSize & 1);
+	}
+	return FAILURE;
+}	// DecodeWAV
+
+// *******************************************************************
+
+// As DecodeWAV, but seeks past each chunk instead of reading the whole file
+ErrorType AssetDecoder::ReadWAVFormat(const wchar_t filename[], int& channels, int& samplesPerSec, int& bitsPerSample,
+	size_t& dataOffset, size_t& dataSize)
+{
+	std::ifstream file(NarrowName(filename).c_str(), std::ios::binary);
+	std::vector<unsigned char> header(12);
+	if(!file.read((char*)header.data(), header.size()) || header[0] != 'R' || header[1] != 'I' || header[2] != 'F' || header[3] != 'F'
+		|| header[8] != 'W' || header[9] != 'A' || header[10] != 'V' || header[11] != 'E')
+		return FAILURE;
+
+	file.seekg(0, std::ios::end);
+	size_t fileSize = size_t(file.tellg());
+
+	bool foundFormat = false;
+	size_t offset = 12;
+	std::vector<unsigned char> chunk(16);
+	while(offset + 8 <= fileSize)
+	{
+		file.seekg(std::streamoff(offset));
+		if(!file.read((char*)chunk.data(), 8))
+			return FAILURE;
+		size_t chunkSize = ReadLE(chunk, 4, 4);
+		size_t chunkStart = offset + 8;
+		if(chunkStart + chunkSize > fileSize)
+			chunkSize = fileSize - chunkStart;
+
+		if(chunk[0] == 'f' && chunk[1] == 'm' && chunk[2] == 't' && chunk[3] == ' ')
+		{
+			if(chunkSize < 16 || !file.read((char*)chunk.data(), 16) || ReadLE(chunk, 0, 2) != 1)
+				return FAILURE;
+			channels = int(ReadLE(chunk, 2, 2));
+			samplesPerSec = int(ReadLE(chunk, 4, 4));
+			bitsPerSample = int(ReadLE(chunk, 14, 2));
+			foundFormat = true;
+		}
+		else if(chunk[0] == 'd' && chunk[1] == 'a' && chunk[2] == 't' && chunk[3] == 'a')
+		{
+			if(!foundFormat)
+				return FAILURE;
+			dataOffset = chunkStart;
+			dataSize = chunkSize;
+			return SUCCESS;
+		}
+
+		offset = chunkStart + chunkSize + (chunkSize & 1);
+	}
+	return FAILURE;
+}	// ReadWAVFormat
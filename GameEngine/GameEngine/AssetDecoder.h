@@ -0,0 +1,37 @@
+//Created by 16007006
+//Reads the engine's image and sound files into plain memory, without DirectX.
+//Used by the software renderer and by the AssetPacker tool. Does not depend on Windows.
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include "errortype.h"
+
+class AssetDecoder
+{
+public:
+	// Postcondition:	An uncompressed 8, 24 or 32-bit BMP file has been read into pixels,
+	//					width*height ARGB values row by row from the top. Opaque black is made
+	//					transparent, the same colour key MyDrawEngine has always used.
+	// Returns:			SUCCESS, or FAILURE if the file could not be read or is not supported
+	static ErrorType DecodeBMP(const wchar_t filename[], int& width, int& height, std::vector<unsigned int>& pixels);
+
+	// Postcondition:	width and height are set from the BMP header. The pixels are not read.
+	static ErrorType ReadBMPSize(const wchar_t filename[], int& width, int& height);
+
+	// Postcondition:	The PCM samples in a WAV file have been read into samples, and the
+	//					format into channels, samplesPerSec and bitsPerSample.
+	// Returns:			SUCCESS, or FAILURE if the file could not be read or is not PCM
+	static ErrorType DecodeWAV(const wchar_t filename[], int& channels, int& samplesPerSec, int& bitsPerSample, std::vector<unsigned char>& samples);
+
+	// Postcondition:	channels, samplesPerSec and bitsPerSample are set from the WAV header, and
+	//					dataOffset and dataSize to where the samples are in the file. The samples are not read.
+	// Returns:			SUCCESS, or FAILURE if the file could not be read or is not PCM
+	static ErrorType ReadWAVFormat(const wchar_t filename[], int& channels, int& samplesPerSec, int& bitsPerSample,
+		size_t& dataOffset, size_t& dataSize);
+
+	// Returns the file name as a narrow string. Asset names are plain ASCII,
+	// and the standard streams only take narrow names outside MSVC.
+	static std::string NarrowName(const wchar_t filename[]);
+};
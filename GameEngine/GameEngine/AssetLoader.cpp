@@ -0,0 +1,168 @@
+//Created by 16007006
+//A fixed pool of worker threads sharing one queue. Workers only decode into memory -
+//textures and sound buffers are created by the engines in Publish(), on the main thread,
+//so neither Direct3D nor DirectSound is used from more than one thread.
+
+#include "AssetLoader.h"
+#include "AssetDecoder.h"
+#include <algorithm>
+
+AssetLoader* AssetLoader::instance = nullptr;
+
+AssetLoader::AssetLoader(int numThreads)
+{
+	m_Busy = 0;
+	m_Stopping = false;
+
+	for(int i=0;i<numThreads;i++)
+		m_Workers.push_back(std::thread(&AssetLoader::WorkerLoop, this));
+}
+
+// *******************************************************************
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Stopping = true;
+	}
+	m_WorkReady.notify_all();
+
+	for(std::thread& worker : m_Workers)
+		worker.join();
+}
+
+// *******************************************************************
+
+ErrorType AssetLoader::Start(int numThreads)
+{
+	if(instance)
+		return FAILURE;
+
+	// Leave a core for the main thread
+	if(numThreads <= 0)
+		numThreads = std::max(1, int(std::thread::hardware_concurrency()) - 1);
+
+	instance = new AssetLoader(numThreads);
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+AssetLoader* AssetLoader::GetInstance()
+{
+	return instance;
+}
+
+// *******************************************************************
+
+ErrorType AssetLoader::Terminate()
+{
+	if(!instance)
+		return FAILURE;
+
+	delete instance;
+	instance = nullptr;
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+void AssetLoader::Queue(AssetType type, const wchar_t filename[], LoadFinisher finish)
+{
+	std::unique_ptr<Job> pJob(new Job);
+	pJob->m_Asset.m_Type = type;
+	pJob->m_Asset.m_Filename = filename;
+	pJob->m_Asset.m_Result = FAILURE;
+	pJob->m_Asset.m_Width = 0;
+	pJob->m_Asset.m_Height = 0;
+	pJob->m_Asset.m_Channels = 0;
+	pJob->m_Asset.m_SamplesPerSec = 0;
+	pJob->m_Asset.m_BitsPerSample = 0;
+	pJob->m_Finish = finish;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Waiting.push_back(std::move(pJob));
+	}
+	m_WorkReady.notify_one();
+}
+
+// *******************************************************************
+
+void AssetLoader::Publish()
+{
+	// Take the finished jobs, then run the finishers without the lock, so
+	// the workers can carry on while textures and buffers are created
+	std::deque<std::unique_ptr<Job>> finished;
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		finished.swap(m_Finished);
+	}
+
+	for(std::unique_ptr<Job>& pJob : finished)
+		pJob->m_Finish(pJob->m_Asset);
+}
+
+// *******************************************************************
+
+void AssetLoader::WaitForAll()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_Lock);
+		m_WorkDone.wait(lock, [this]()
+		{
+			return m_Waiting.empty() && m_Busy == 0;
+		});
+	}
+	Publish();
+}
+
+// *******************************************************************
+
+int AssetLoader::GetNumPending()
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+	return int(m_Waiting.size() + m_Finished.size()) + m_Busy;
+}
+
+// *******************************************************************
+
+void AssetLoader::WorkerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_Lock);
+	while(true)
+	{
+		m_WorkReady.wait(lock, [this]()
+		{
+			return m_Stopping || !m_Waiting.empty();
+		});
+		if(m_Stopping)
+			return;
+
+		std::unique_ptr<Job> pJob = std::move(m_Waiting.front());
+		m_Waiting.pop_front();
+		m_Busy++;
+
+		// Decode without holding the lock
+		lock.unlock();
+		Decode(pJob->m_Asset);
+		lock.lock();
+
+		m_Finished.push_back(std::move(pJob));
+		m_Busy--;
+		m_WorkDone.notify_all();
+	}
+}
+
+// *******************************************************************
+
+void AssetLoader::Decode(LoadedAsset& asset)
+{
+	if(asset.m_Type == ASSET_PICTURE)
+		asset.m_Result = AssetDecoder::DecodeBMP(asset.m_Filename.c_str(), asset.m_Width, asset.m_Height, asset.m_Pixels);
+	else if(asset.m_Type == ASSET_SOUND)
+		asset.m_Result = AssetDecoder::DecodeWAV(asset.m_Filename.c_str(), asset.m_Channels, asset.m_SamplesPerSec, asset.m_BitsPerSample, asset.m_Samples);
+	else
+		asset.m_Result = FAILURE;
+}
@@ -0,0 +1,102 @@
+//Created by 16007006
+//Decodes picture and sound files on a pool of worker threads, so loading an asset
+//does not stall the frame. The engines hand out a handle straight away, and the
+//decoded data is given back to them on the main thread by Publish(), which the
+//game calls once per frame. Does not depend on Windows.
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "errortype.h"
+#include "AssetPack.h"
+
+// An asset decoded by a worker thread
+struct LoadedAsset
+{
+	AssetType m_Type;
+	std::wstring m_Filename;
+	ErrorType m_Result;						// FAILURE if the file could not be decoded
+	int m_Width;							// Pictures: as AssetDecoder::DecodeBMP
+	int m_Height;
+	std::vector<unsigned int> m_Pixels;
+	int m_Channels;							// Sounds: as AssetDecoder::DecodeWAV
+	int m_SamplesPerSec;
+	int m_BitsPerSample;
+	std::vector<unsigned char> m_Samples;
+};
+
+// Called on the main thread by Publish() with the decoded asset
+typedef std::function<void(const LoadedAsset&)> LoadFinisher;
+
+// Singleton, started by the game after the engines
+class AssetLoader
+{
+private:
+	static AssetLoader* instance;
+
+	struct Job
+	{
+		LoadedAsset m_Asset;
+		LoadFinisher m_Finish;
+	};
+
+	std::vector<std::thread> m_Workers;
+	std::mutex m_Lock;								// Guards everything below
+	std::condition_variable m_WorkReady;			// Signalled when a job is queued, or on Terminate
+	std::condition_variable m_WorkDone;				// Signalled when a worker finishes a job
+	std::deque<std::unique_ptr<Job>> m_Waiting;		// Queued, not yet picked up by a worker
+	std::deque<std::unique_ptr<Job>> m_Finished;	// Decoded, waiting for Publish()
+	int m_Busy;										// Jobs being decoded right now
+	bool m_Stopping;
+
+	// Starts the worker threads
+	AssetLoader(int numThreads);
+
+	// Stops the worker threads. Jobs not yet published are dropped.
+	~AssetLoader();
+
+	// Each worker thread runs this until the loader is terminated
+	void WorkerLoop();
+
+	// Decodes the job's file. Runs on a worker thread, so must not touch the engines
+	// or the error log.
+	static void Decode(LoadedAsset& asset);
+
+public:
+	// Postcondition:	The loader has been started with the given number of worker threads.
+	//					If numThreads is zero, one fewer than the number of cores is used (at least one).
+	// Returns:			SUCCESS, or FAILURE if it was already started.
+	static ErrorType Start(int numThreads = 0);
+
+	// Returns the loader, or nullptr if it has not been started.
+	// The engines load synchronously when there is no loader.
+	static AssetLoader* GetInstance();
+
+	// Postcondition:	The worker threads have stopped and the loader has been deleted.
+	//					Jobs not yet published are dropped without calling their finishers.
+	// Returns:			SUCCESS, or FAILURE if the loader had not been started.
+	static ErrorType Terminate();
+
+	// Postcondition:	The file has been queued to be decoded on a worker thread. finish is
+	//					called with the result by a later Publish(), on the calling thread.
+	void Queue(AssetType type, const wchar_t filename[], LoadFinisher finish);
+
+	// Postcondition:	Every job decoded since the last Publish() has been handed to its finisher,
+	//					in the order the workers finished them.
+	// Call once per frame, at a point where the engines can safely be changed.
+	void Publish();
+
+	// Postcondition:	Every queued job has been decoded and published.
+	// Blocks the calling thread - use while loading, not during play.
+	void WaitForAll();
+
+	// Returns the number of jobs queued or decoded but not yet published
+	int GetNumPending();
+};
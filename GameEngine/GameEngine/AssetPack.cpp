@@ -0,0 +1,388 @@
+//Created by 16007006
+//Mapping uses CreateFileMapping on Windows and mmap elsewhere. Nothing is read
+//until it is used - the OS pages the file in as textures and sound buffers are filled.
+
+#include "AssetPack.h"
+#include "errorlogger.h"
+#include "AssetDecoder.h"
+#include <cstring>
+#include <cctype>
+#include <fstream>
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(AssetPackHeader) == 16, "AssetPackHeader is part of the file format");
+static_assert(sizeof(AssetPackEntry) == 120, "AssetPackEntry is part of the file format");
+
+AssetPack* AssetPack::instance = nullptr;
+
+// Every item of data starts on this boundary, so pixels can be read as unsigned ints in place
+static const size_t DATAALIGNMENT = 16;
+
+// Lower case, so names can be compared without caring how they were typed
+static std::string LowerName(const std::string& name)
+{
+	std::string lower = name;
+	for(char& c : lower)
+		c = char(tolower((unsigned char)c));
+	return lower;
+}
+
+// *************************************************************
+// Reading
+// *************************************************************
+
+AssetPack::AssetPack()
+{
+	m_pData = nullptr;
+	m_Size = 0;
+	m_pEntries = nullptr;
+	m_NumEntries = 0;
+#ifdef _WIN32
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = nullptr;
+#else
+	m_File = -1;
+#endif
+}
+
+// *******************************************************************
+
+AssetPack::~AssetPack()
+{
+	Close();
+}
+
+// *******************************************************************
+
+ErrorType AssetPack::Open(const wchar_t filename[])
+{
+	Close();
+
+#ifdef _WIN32
+	m_hFile = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	LARGE_INTEGER size;
+	if(m_hFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_hFile, &size) || size.QuadPart == 0)
+	{
+		ErrorLogger::Write(L"Could not open asset pack ");
+		ErrorLogger::Writeln(filename);
+		Close();
+		return FAILURE;
+	}
+	m_Size = size_t(size.QuadPart);
+
+	m_hMapping = CreateFileMappingW(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(m_hMapping)
+		m_pData = (const unsigned char*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	m_File = open(AssetDecoder::NarrowName(filename).c_str(), O_RDONLY);
+	struct stat info;
+	if(m_File < 0 || fstat(m_File, &info) != 0 || info.st_size == 0)
+	{
+		ErrorLogger::Write(L"Could not open asset pack ");
+		ErrorLogger::Writeln(filename);
+		Close();
+		return FAILURE;
+	}
+	m_Size = size_t(info.st_size);
+
+	void* pMapping = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_File, 0);
+	if(pMapping != MAP_FAILED)
+		m_pData = (const unsigned char*)pMapping;
+#endif
+
+	if(!m_pData)
+	{
+		ErrorLogger::Write(L"Could not map asset pack ");
+		ErrorLogger::Writeln(filename);
+		Close();
+		return FAILURE;
+	}
+
+	if(CheckIndex() == FAILURE)
+	{
+		ErrorLogger::Write(L"Asset pack is damaged or out of date: ");
+		ErrorLogger::Writeln(filename);
+		Close();
+		return FAILURE;
+	}
+
+	const AssetPackHeader* pHeader = (const AssetPackHeader*)m_pData;
+	m_NumEntries = pHeader->m_NumEntries;
+	m_pEntries = (const AssetPackEntry*)(m_pData + sizeof(AssetPackHeader));
+	return SUCCESS;
+}	// Open
+
+// *******************************************************************
+
+void AssetPack::Close()
+{
+#ifdef _WIN32
+	if(m_pData)
+		UnmapViewOfFile(m_pData);
+	if(m_hMapping)
+		CloseHandle(m_hMapping);
+	if(m_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(m_hFile);
+	m_hMapping = nullptr;
+	m_hFile = INVALID_HANDLE_VALUE;
+#else
+	if(m_pData)
+		munmap((void*)m_pData, m_Size);
+	if(m_File >= 0)
+		close(m_File);
+	m_File = -1;
+#endif
+	m_pData = nullptr;
+	m_Size = 0;
+	m_pEntries = nullptr;
+	m_NumEntries = 0;
+}	// Close
+
+// *******************************************************************
+
+ErrorType AssetPack::CheckIndex() const
+{
+	if(m_Size < sizeof(AssetPackHeader))
+		return FAILURE;
+
+	const AssetPackHeader* pHeader = (const AssetPackHeader*)m_pData;
+	if(memcmp(pHeader->m_Magic, "CPAK", 4) != 0 || pHeader->m_Version != VERSION)
+		return FAILURE;
+
+	if(pHeader->m_NumEntries > (m_Size - sizeof(AssetPackHeader)) / sizeof(AssetPackEntry))
+		return FAILURE;
+
+	const AssetPackEntry* pEntries = (const AssetPackEntry*)(m_pData + sizeof(AssetPackHeader));
+	for(unsigned int i=0;i<pHeader->m_NumEntries;i++)
+	{
+		const AssetPackEntry& entry = pEntries[i];
+
+		// Name must be terminated, and in order for Find
+		if(memchr(entry.m_Name, 0, sizeof(entry.m_Name)) == nullptr)
+			return FAILURE;
+		if(i > 0 && strcmp(pEntries[i-1].m_Name, entry.m_Name) >= 0)
+			return FAILURE;
+
+		// Data must be inside the file, and aligned
+		if(entry.m_Offset > m_Size || entry.m_Size > m_Size - entry.m_Offset || entry.m_Offset % DATAALIGNMENT != 0)
+			return FAILURE;
+
+		if(entry.m_Type == ASSET_PICTURE)
+		{
+			if((unsigned long long)entry.m_Width * entry.m_Height * 4 != entry.m_Size)
+				return FAILURE;
+		}
+		else if(entry.m_Type != ASSET_SOUND)
+			return FAILURE;
+	}
+	return SUCCESS;
+}	// CheckIndex
+
+// *******************************************************************
+
+ErrorType AssetPack::Start(const wchar_t filename[])
+{
+	if(instance)
+		Terminate();
+
+	instance = new AssetPack();
+	if(instance->Open(filename) == FAILURE)
+	{
+		delete instance;
+		instance = nullptr;
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+AssetPack* AssetPack::GetInstance()
+{
+	return instance;
+}
+
+// *******************************************************************
+
+ErrorType AssetPack::Terminate()
+{
+	if(!instance)
+		return FAILURE;
+
+	delete instance;
+	instance = nullptr;
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+// Binary search - the index is sorted by name
+const AssetPackEntry* AssetPack::Find(const wchar_t name[]) const
+{
+	std::string key = LowerName(AssetDecoder::NarrowName(name));
+
+	const AssetPackEntry* pEnd = m_pEntries + m_NumEntries;
+	const AssetPackEntry* pFound = std::lower_bound(m_pEntries, pEnd, key,
+		[](const AssetPackEntry& entry, const std::string& key)
+	{
+		return strcmp(entry.m_Name, key.c_str()) < 0;
+	});
+
+	if(pFound == pEnd || key != pFound->m_Name)
+		return nullptr;
+	return pFound;
+}	// Find
+
+// *******************************************************************
+
+const void* AssetPack::GetData(const AssetPackEntry& entry) const
+{
+	return m_pData + entry.m_Offset;
+}
+
+// *******************************************************************
+
+unsigned int AssetPack::GetNumEntries() const
+{
+	return m_NumEntries;
+}
+
+// *******************************************************************
+
+const AssetPackEntry& AssetPack::GetEntry(unsigned int index) const
+{
+	return m_pEntries[index];
+}
+
+// *******************************************************************
+
+ErrorType AssetPack::Verify(const AssetPackEntry& entry) const
+{
+	if(Checksum(GetData(entry), size_t(entry.m_Size)) != entry.m_Checksum)
+		return FAILURE;
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+unsigned long long AssetPack::Checksum(const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	unsigned long long hash = 14695981039346656037ULL;
+	for(size_t i=0;i<size;i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// *************************************************************
+// Writing
+// *************************************************************
+
+AssetPackWriter::Item& AssetPackWriter::AddItem(const std::string& name, AssetType type, const void* data, size_t size)
+{
+	Item item;
+	memset(&item.m_Entry, 0, sizeof(item.m_Entry));
+	std::string lower = LowerName(name);
+	memcpy(item.m_Entry.m_Name, lower.c_str(), lower.size());
+	item.m_Entry.m_Type = type;
+	item.m_Entry.m_Size = size;
+	item.m_Entry.m_Checksum = AssetPack::Checksum(data, size);
+	item.m_Data.assign((const unsigned char*)data, (const unsigned char*)data + size);
+
+	m_Items.push_back(item);
+	return m_Items.back();
+}
+
+// *******************************************************************
+
+ErrorType AssetPackWriter::AddPicture(const std::string& name, int width, int height, const std::vector<unsigned int>& pixels)
+{
+	// Room is needed for the terminator
+	if(name.size() >= sizeof(AssetPackEntry::m_Name))
+		return FAILURE;
+	for(const Item& item : m_Items)
+	{
+		if(LowerName(name) == item.m_Entry.m_Name)
+			return FAILURE;
+	}
+
+	Item& item = AddItem(name, ASSET_PICTURE, pixels.data(), pixels.size() * sizeof(unsigned int));
+	item.m_Entry.m_Width = width;
+	item.m_Entry.m_Height = height;
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType AssetPackWriter::AddSound(const std::string& name, int channels, int samplesPerSec, int bitsPerSample, const std::vector<unsigned char>& samples)
+{
+	if(name.size() >= sizeof(AssetPackEntry::m_Name))
+		return FAILURE;
+	for(const Item& item : m_Items)
+	{
+		if(LowerName(name) == item.m_Entry.m_Name)
+			return FAILURE;
+	}
+
+	Item& item = AddItem(name, ASSET_SOUND, samples.data(), samples.size());
+	item.m_Entry.m_Channels = channels;
+	item.m_Entry.m_SamplesPerSec = samplesPerSec;
+	item.m_Entry.m_BitsPerSample = bitsPerSample;
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType AssetPackWriter::Write(const std::string& filename)
+{
+	// Sorted, so the engine can binary search the index
+	std::sort(m_Items.begin(), m_Items.end(), [](const Item& a, const Item& b)
+	{
+		return strcmp(a.m_Entry.m_Name, b.m_Entry.m_Name) < 0;
+	});
+
+	// Lay out the data after the index
+	size_t offset = sizeof(AssetPackHeader) + m_Items.size() * sizeof(AssetPackEntry);
+	for(Item& item : m_Items)
+	{
+		offset = (offset + DATAALIGNMENT - 1) / DATAALIGNMENT * DATAALIGNMENT;
+		item.m_Entry.m_Offset = offset;
+		offset += item.m_Data.size();
+	}
+
+	std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+	if(!file)
+		return FAILURE;
+
+	AssetPackHeader header;
+	memcpy(header.m_Magic, "CPAK", 4);
+	header.m_Version = AssetPack::VERSION;
+	header.m_NumEntries = (unsigned int)m_Items.size();
+	header.m_Reserved = 0;
+	file.write((const char*)&header, sizeof(header));
+
+	for(const Item& item : m_Items)
+		file.write((const char*)&item.m_Entry, sizeof(item.m_Entry));
+
+	static const char padding[DATAALIGNMENT] = {0};
+	size_t position = sizeof(AssetPackHeader) + m_Items.size() * sizeof(AssetPackEntry);
+	for(const Item& item : m_Items)
+	{
+		file.write(padding, std::streamsize(item.m_Entry.m_Offset - position));
+		file.write((const char*)item.m_Data.data(), std::streamsize(item.m_Data.size()));
+		position = size_t(item.m_Entry.m_Offset) + item.m_Data.size();
+	}
+
+	return file ? SUCCESS : FAILURE;
+}	// Write
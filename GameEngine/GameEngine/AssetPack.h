@@ -0,0 +1,137 @@
+//Created by 16007006
+//One file holding every picture and sound, already decoded.
+//Built offline by the AssetPacker tool, then memory-mapped by the engine, so
+//LoadPicture and LoadWav copy straight from the file into textures and sound buffers
+//instead of opening and decoding each asset file.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <string>
+#include "errortype.h"
+
+// File layout:
+//		AssetPackHeader
+//		AssetPackEntry[m_NumEntries], sorted by name
+//		The data for each entry, each starting on a 16 byte boundary
+// Numbers are little-endian, as on every machine the engine runs on.
+
+enum AssetType{ASSET_PICTURE = 1, ASSET_SOUND = 2};
+
+struct AssetPackHeader
+{
+	char m_Magic[4];					// "CPAK"
+	unsigned int m_Version;				// AssetPack::VERSION
+	unsigned int m_NumEntries;
+	unsigned int m_Reserved;
+};
+
+struct AssetPackEntry
+{
+	char m_Name[64];					// File the asset was packed from, lower case, no folder. Zero padded.
+	unsigned int m_Type;				// An AssetType
+	unsigned int m_Width;				// Pictures: size in pixels. The data is m_Width*m_Height ARGB values
+	unsigned int m_Height;				//   row by row from the top, with black already made transparent.
+	unsigned int m_Channels;			// Sounds: PCM format. The data is the samples, ready for a sound buffer.
+	unsigned int m_SamplesPerSec;
+	unsigned int m_BitsPerSample;
+	unsigned int m_Reserved[2];
+	unsigned long long m_Offset;		// From the start of the file
+	unsigned long long m_Size;			// In bytes
+	unsigned long long m_Checksum;		// 64-bit FNV-1a of the data
+};
+
+// A read-only asset pack, mapped into memory.
+// The engine's pack is a singleton like the engines - see Start(). The AssetPacker
+// tool opens packs of its own with Open().
+class AssetPack
+{
+private:
+	static AssetPack* instance;
+
+	const unsigned char* m_pData;		// The whole file, mapped. nullptr if not open.
+	size_t m_Size;
+	const AssetPackEntry* m_pEntries;	// The index, inside the mapping
+	unsigned int m_NumEntries;
+#ifdef _WIN32
+	void* m_hFile;						// Windows HANDLEs, kept as void* to keep windows.h out of this header
+	void* m_hMapping;
+#else
+	int m_File;
+#endif
+
+	// Checks the header and that every entry lies inside the file
+	ErrorType CheckIndex() const;
+
+public:
+	static const unsigned int VERSION = 1;
+
+	AssetPack();
+
+	// Calls Close()
+	~AssetPack();
+
+	// Postcondition:	The pack file has been mapped into memory and its index checked.
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	ErrorType Open(const wchar_t filename[]);
+
+	// Postcondition:	The file has been unmapped. Pointers into it are no longer valid.
+	void Close();
+
+	// Postcondition:	The engine's pack has been opened. If a previous one was open, it is closed first.
+	// Returns:			SUCCESS, or FAILURE if the pack could not be opened. The engines
+	//					then load every asset from its own file, as before.
+	static ErrorType Start(const wchar_t filename[]);
+
+	// Returns the engine's pack, or nullptr if none is open
+	static AssetPack* GetInstance();
+
+	// Postcondition:	The engine's pack has been closed.
+	// Returns:			SUCCESS, or FAILURE if there was no pack open.
+	static ErrorType Terminate();
+
+	// Returns the entry packed from a file of this name, or nullptr if there is none.
+	// Names are compared ignoring case.
+	const AssetPackEntry* Find(const wchar_t name[]) const;
+
+	// Returns the data for an entry, inside the mapped file
+	const void* GetData(const AssetPackEntry& entry) const;
+
+	unsigned int GetNumEntries() const;
+	const AssetPackEntry& GetEntry(unsigned int index) const;
+
+	// Returns:			SUCCESS if the entry's data matches its checksum
+	ErrorType Verify(const AssetPackEntry& entry) const;
+
+	// 64-bit FNV-1a, as stored in m_Checksum
+	static unsigned long long Checksum(const void* data, size_t size);
+};
+
+// Builds an asset pack in memory and writes it out. Used by the AssetPacker tool.
+class AssetPackWriter
+{
+private:
+	struct Item
+	{
+		AssetPackEntry m_Entry;
+		std::vector<unsigned char> m_Data;
+	};
+	std::vector<Item> m_Items;
+
+	// Starts an entry with its name lower case and its checksum filled in
+	Item& AddItem(const std::string& name, AssetType type, const void* data, size_t size);
+
+public:
+	// Postcondition:	The picture has been added. pixels are width*height ARGB values.
+	// Returns:			FAILURE if the name is too long or already in the pack
+	ErrorType AddPicture(const std::string& name, int width, int height, const std::vector<unsigned int>& pixels);
+
+	// Postcondition:	The PCM sound has been added.
+	// Returns:			FAILURE if the name is too long or already in the pack
+	ErrorType AddSound(const std::string& name, int channels, int samplesPerSec, int bitsPerSample, const std::vector<unsigned char>& samples);
+
+	// Postcondition:	The pack has been written, sorted by name.
+	// Returns:			SUCCESS, or FAILURE if the file could not be written
+	ErrorType Write(const std::string& filename);
+};
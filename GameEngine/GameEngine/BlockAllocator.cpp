@@ -0,0 +1,111 @@
+//Created by 16007006
+//Small-block allocator used for components
+//Hands out fixed-size blocks carved from large pages. Freed blocks are kept in a
+//list for their size and reused, so once the pages exist, creating and deleting
+//components never goes back to the heap.
+
+#include "BlockAllocator.h"
+#include <new>
+
+BlockAllocator BlockAllocator::instance;
+
+BlockAllocator::BlockAllocator()
+{
+	for (size_t i = 0; i < NUMSIZECLASSES; i++)
+	{
+		freeLists[i] = nullptr;
+	}
+	pages = nullptr;
+	liveBlocks = 0;
+}
+
+BlockAllocator::~BlockAllocator()
+{
+	//Blocks still in use point into the pages, so they can only be released once everything has been freed
+	if (liveBlocks != 0)
+	{
+		return;
+	}
+	while (pages)
+	{
+		void* pNext = *static_cast<void**>(pages);
+		::operator delete(pages);
+		pages = pNext;
+	}
+	for (size_t i = 0; i < NUMSIZECLASSES; i++)
+	{
+		freeLists[i] = nullptr;
+	}
+}
+
+BlockAllocator* BlockAllocator::GetInstance()
+{
+	return &instance;
+}
+
+void BlockAllocator::AllocatePage(size_t sizeClass)
+{
+	size_t blockSize = (sizeClass + 1) * GRANULARITY;
+	char* pPage = static_cast<char*>(::operator new(PAGESIZE));
+
+	//Link the page in so it can be released later
+	*reinterpret_cast<void**>(pPage) = pages;
+	pages = pPage;
+
+	//Push every block in the page onto the free list
+	for (size_t offset = PAGEHEADER; offset + blockSize <= PAGESIZE; offset += blockSize)
+	{
+		void* pBlock = pPage + offset;
+		*static_cast<void**>(pBlock) = freeLists[sizeClass];
+		freeLists[sizeClass] = pBlock;
+	}
+}
+
+void* BlockAllocator::Allocate(size_t size)
+{
+	if (size == 0)
+	{
+		size = 1;
+	}
+	if (size > MAXBLOCKSIZE)
+	{
+		return ::operator new(size);
+	}
+
+	size_t sizeClass = (size - 1) / GRANULARITY;
+	if (!freeLists[sizeClass])
+	{
+		AllocatePage(sizeClass);
+	}
+	void* pBlock = freeLists[sizeClass];
+	freeLists[sizeClass] = *static_cast<void**>(pBlock);
+	liveBlocks++;
+	return pBlock;
+}
+
+void BlockAllocator::Free(void* pBlock, size_t size)
+{
+	if (!pBlock)
+	{
+		return;
+	}
+	if (size == 0)
+	{
+		size = 1;
+	}
+	if (size > MAXBLOCKSIZE)
+	{
+		::operator delete(pBlock);
+		return;
+	}
+
+	size_t sizeClass = (size - 1) / GRANULARITY;
+	*static_cast<void**>(pBlock) = freeLists[sizeClass];
+	freeLists[sizeClass] = pBlock;
+	liveBlocks--;
+}
+
+int BlockAllocator::GetLiveBlocks() const
+{
+	return liveBlocks;
+}
@@ -0,0 +1,36 @@
+//Created by 16007006
+//Small-block allocator used for components
+//Hands out fixed-size blocks carved from large pages. Freed blocks are kept in a
+//list for their size and reused, so once the pages exist, creating and deleting
+//components never goes back to the heap.
+
+#pragma once
+#include <cstddef>
+
+class BlockAllocator
+{
+private:
+	static const size_t GRANULARITY    = 16;                        //Block sizes are rounded up to a multiple of this
+	static const size_t MAXBLOCKSIZE   = 256;                       //Larger requests go straight to the heap
+	static const size_t NUMSIZECLASSES = MAXBLOCKSIZE / GRANULARITY;
+	static const size_t PAGESIZE       = 16384;                     //Bytes taken from the heap at a time
+	static const size_t PAGEHEADER     = 16;                        //Start of each page links to the next, kept aligned
+
+	//Each list links free blocks through their first bytes.
+	//  Only plain pointers are used, so the allocator is still safe to call if
+	//  another static object outlives it during shutdown.
+	void* freeLists[NUMSIZECLASSES];
+	void* pages;      //Every page allocated, linked through their headers
+	int liveBlocks;   //Blocks currently handed out
+
+	static BlockAllocator instance;
+
+	BlockAllocator();  //Constructor
+	~BlockAllocator(); //Destructor - releases the pages if nothing is still using them
+	void AllocatePage(size_t sizeClass); //Carves a new page into blocks for one size class
+public:
+	static BlockAllocator* GetInstance();
+	void* Allocate(size_t size);          //Returns a block of at least size bytes
+	void Free(void* pBlock, size_t size); //Returns a block. size must match the size it was allocated with.
+	int GetLiveBlocks() const;            //Returns the number of blocks currently in use
+};
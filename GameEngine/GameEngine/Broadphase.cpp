@@ -0,0 +1,319 @@
+//Created by 16007006
+//Broadphase collision culling for the ObjectManager
+//Discards pairs of objects whose collision bounds cannot overlap, so that only
+//nearby objects are handed to IShape2D::Intersects
+//Each broadphase checks the layers of a pair before its bounds, as that is a single bit test
+
+#include "Broadphase.h"
+#include <algorithm>
+#include <cmath>
+
+//Returns true if either proxy reacts to the other's collision layer
+static bool LayersInteract(const BroadphaseProxy& a, const BroadphaseProxy& b)
+{
+	return ((a.mask & b.layer) | (b.mask & a.layer)) != 0;
+}
+
+//Returns true if the bounds of both proxies overlap
+//  Edges touching counts as overlapping, the narrowphase makes the final decision
+static bool BoundsOverlap(const BroadphaseProxy& a, const BroadphaseProxy& b)
+{
+	return a.minX <= b.maxX && b.minX <= a.maxX
+		&& a.minY <= b.maxY && b.minY <= a.maxY;
+}
+
+//Orders pairs the same way the old nested list loop visited them
+static bool PairLess(const BroadphasePair& a, const BroadphasePair& b)
+{
+	return a.first < b.first || (a.first == b.first && a.second < b.second);
+}
+
+//Adds a pair, making sure first is the lower index
+static void AddPair(std::vector<BroadphasePair>& pairs, int a, int b)
+{
+	BroadphasePair pair;
+	pair.first  = std::min(a, b);
+	pair.second = std::max(a, b);
+	pairs.push_back(pair);
+}
+
+/**************************************************
+ * BROADPHASE INTERFACE ***************************
+ **************************************************/
+
+IBroadphase::~IBroadphase() {/*Nothing*/}
+
+/**************************************************
+ * ALL PAIRS **************************************
+ **************************************************/
+
+AllPairsBroadphase::AllPairsBroadphase() {/*Nothing*/}
+AllPairsBroadphase::~AllPairsBroadphase() {/*Nothing*/}
+
+void AllPairsBroadphase::FindPairs(const std::vector<BroadphaseProxy>& proxies, std::vector<BroadphasePair>& pairs)
+{
+	pairs.clear();
+	for (int i = 0; i < (int)proxies.size(); i++)
+	{
+		for (int j = i + 1; j < (int)proxies.size(); j++)
+		{
+			if (LayersInteract(proxies[i], proxies[j]))
+			{
+				AddPair(pairs, i, j);
+			}
+		}
+	}
+}
+
+/**************************************************
+ * UNIFORM GRID ***********************************
+ **************************************************/
+
+UniformGridBroadphase::UniformGridBroadphase(float cellSize)
+{
+	//Cells must have a positive size, otherwise every proxy would cover infinitely many cells
+	this->cellSize = (cellSize > 1.0f) ? cellSize : 1.0f;
+}
+
+UniformGridBroadphase::~UniformGridBroadphase() {/*Nothing*/}
+
+int UniformGridBroadphase::CellCoord(float value) const
+{
+	return (int)std::floor(value / cellSize);
+}
+
+void UniformGridBroadphase::FindPairs(const std::vector<BroadphaseProxy>& proxies, std::vector<BroadphasePair>& pairs)
+{
+	pairs.clear();
+	entries.clear();
+	largeProxies.clear();
+	firstCellX.resize(proxies.size());
+	firstCellY.resize(proxies.size());
+
+	// *********************************************************************
+	// Bucket every proxy into each cell it covers *************************
+	for (int i = 0; i < (int)proxies.size(); i++)
+	{
+		const BroadphaseProxy& proxy = proxies[i];
+		int left   = CellCoord(proxy.minX);
+		int bottom = CellCoord(proxy.minY);
+		int right  = CellCoord(proxy.maxX);
+		int top    = CellCoord(proxy.maxY);
+		firstCellX[i] = left;
+		firstCellY[i] = bottom;
+
+		//Very large shapes would flood the grid - keep them aside and test them against everything
+		if ((long long)(right - left + 1) * (top - bottom + 1) > MAXCELLSPERPROXY)
+		{
+			largeProxies.push_back(i);
+			continue;
+		}
+
+		for (int y = bottom; y <= top; y++)
+		{
+			for (int x = left; x <= right; x++)
+			{
+				CellEntry entry;
+				entry.cell  = ((long long)y << 32) | (unsigned int)x;
+				entry.proxy = i;
+				entries.push_back(entry);
+			}
+		}
+	}
+
+	//Sort so that all entries in the same cell sit next to each other.
+	//  Ties are broken by proxy so the result never depends on the sort implementation.
+	std::sort(entries.begin(), entries.end(), [](const CellEntry& a, const CellEntry& b)
+	{
+		return a.cell < b.cell || (a.cell == b.cell && a.proxy < b.proxy);
+	});
+
+	// *********************************************************************
+	// Pair up proxies sharing a cell **************************************
+	size_t start = 0;
+	while (start < entries.size())
+	{
+		//Find the end of this cell's run of entries
+		size_t end = start + 1;
+		while (end < entries.size() && entries[end].cell == entries[start].cell)
+		{
+			end++;
+		}
+
+		int cellX = (int)(unsigned int)(entries[start].cell & 0xFFFFFFFF);
+		int cellY = (int)(entries[start].cell >> 32);
+
+		for (size_t i = start; i < end; i++)
+		{
+			int a = entries[i].proxy;
+			for (size_t j = i + 1; j < end; j++)
+			{
+				int b = entries[j].proxy;
+				//Two proxies can share several cells. Only report the pair from the
+				//first cell they share, i.e. the cell at the larger of their bottom left corners
+				if (cellX != std::max(firstCellX[a], firstCellX[b]) ||
+				    cellY != std::max(firstCellY[a], firstCellY[b]))
+				{
+					continue;
+				}
+				if (LayersInteract(proxies[a], proxies[b]) && BoundsOverlap(proxies[a], proxies[b]))
+				{
+					AddPair(pairs, a, b);
+				}
+			}
+		}
+		start = end;
+	}
+
+	// *********************************************************************
+	// Large proxies are tested against every other proxy ******************
+	for (size_t i = 0; i < largeProxies.size(); i++)
+	{
+		int a = largeProxies[i];
+		for (int b = 0; b < (int)proxies.size(); b++)
+		{
+			//Skip itself, and only report large-against-large pairs once
+			if (b == a) continue;
+			bool bIsLarge = std::binary_search(largeProxies.begin(), largeProxies.end(), b);
+			if (bIsLarge && b < a) continue;
+
+			if (LayersInteract(proxies[a], proxies[b]) && BoundsOverlap(proxies[a], proxies[b]))
+			{
+				AddPair(pairs, a, b);
+			}
+		}
+	}
+
+	std::sort(pairs.begin(), pairs.end(), PairLess);
+}
+
+/**************************************************
+ * SWEEP AND PRUNE ********************************
+ **************************************************/
+
+SweepAndPruneBroadphase::SweepAndPruneBroadphase()
+{
+	swaps = 0;
+}
+
+SweepAndPruneBroadphase::~SweepAndPruneBroadphase() {/*Nothing*/}
+
+void SweepAndPruneBroadphase::SortEndpoints()
+{
+	swaps = 0;
+	for (size_t i = 1; i < endpoints.size(); i++)
+	{
+		Endpoint current = endpoints[i];
+		size_t j = i;
+		//Where two endpoints share a value, starts go before ends so touching intervals still overlap
+		while (j > 0 && (endpoints[j - 1].value > current.value ||
+		                (endpoints[j - 1].value == current.value && !endpoints[j - 1].isMin && current.isMin)))
+		{
+			endpoints[j] = endpoints[j - 1];
+			j--;
+			swaps++;
+		}
+		endpoints[j] = current;
+	}
+}
+
+void SweepAndPruneBroadphase::FindPairs(const std::vector<BroadphaseProxy>& proxies, std::vector<BroadphasePair>& pairs)
+{
+	pairs.clear();
+
+	// *********************************************************************
+	// Match last frame's endpoints to this frame's proxies ****************
+	//A flat table indexed by slot, which keeps its capacity from one frame to the next
+	int numSlots = 0;
+	for (int i = 0; i < (int)proxies.size(); i++)
+	{
+		numSlots = std::max(numSlots, proxies[i].slot + 1);
+	}
+	proxyOfSlot.assign(numSlots, -1);
+	for (int i = 0; i < (int)proxies.size(); i++)
+	{
+		proxyOfSlot[proxies[i].slot] = i;
+	}
+	tracked.assign(proxies.size(), false);
+
+	//Refresh endpoints of objects which still exist, and drop those of objects which have gone.
+	//  Dropping keeps the remaining endpoints in order, so the array stays nearly sorted.
+	//  An object which reuses a slot takes over the endpoints of the one before - its
+	//  values are refreshed here, and the sort moves them into place.
+	size_t kept = 0;
+	for (size_t i = 0; i < endpoints.size(); i++)
+	{
+		int slot = endpoints[i].slot;
+		int proxy = (slot < numSlots) ? proxyOfSlot[slot] : -1;
+		if (proxy < 0)
+		{
+			continue;
+		}
+		Endpoint& endpoint = endpoints[kept++];
+		endpoint = endpoints[i];
+		endpoint.proxy = proxy;
+		endpoint.value = endpoint.isMin ? proxies[proxy].minX : proxies[proxy].maxX;
+		tracked[proxy] = true;
+	}
+	endpoints.resize(kept);
+
+	//New objects are added at the end - the sort will move them into place
+	for (int i = 0; i < (int)proxies.size(); i++)
+	{
+		if (!tracked[i])
+		{
+			Endpoint endpoint;
+			endpoint.slot    = proxies[i].slot;
+			endpoint.proxy   = i;
+			endpoint.value   = proxies[i].minX;
+			endpoint.isMin   = true;
+			endpoints.push_back(endpoint);
+			endpoint.value   = proxies[i].maxX;
+			endpoint.isMin   = false;
+			endpoints.push_back(endpoint);
+		}
+	}
+
+	SortEndpoints();
+
+	// *********************************************************************
+	// Sweep along X *******************************************************
+	//  When an interval starts, every interval still open overlaps it on X,
+	//  so only the Y axis needs checking.
+	active.clear();
+	activeSlot.assign(proxies.size(), -1);
+	for (const Endpoint& endpoint : endpoints)
+	{
+		int current = endpoint.proxy;
+		if (endpoint.isMin)
+		{
+			for (int other : active)
+			{
+				if (LayersInteract(proxies[current], proxies[other]) &&
+				    proxies[current].minY <= proxies[other].maxY && proxies[other].minY <= proxies[current].maxY)
+				{
+					AddPair(pairs, current, other);
+				}
+			}
+			activeSlot[current] = (int)active.size();
+			active.push_back(current);
+		}
+		else
+		{
+			//Swap the last active proxy into this one's place
+			int slot = activeSlot[current];
+			int last = active.back();
+			active[slot] = last;
+			activeSlot[last] = slot;
+			active.pop_back();
+			activeSlot[current] = -1;
+		}
+	}
+
+	std::sort(pairs.begin(), pairs.end(), PairLess);
+}
+
+int SweepAndPruneBroadphase::GetSwapCount() const
+{
+	return swaps;
+}
@@ -0,0 +1,131 @@
+//Created by 16007006
+//Broadphase collision culling for the ObjectManager
+//Discards pairs of objects whose collision bounds cannot overlap, so that only
+//nearby objects are handed to IShape2D::Intersects
+//Pairs where neither object reacts to the other's collision layer are never reported,
+//whatever their bounds
+
+#pragma once
+#include <vector>
+
+//Forward declare - only referenced, never used
+class GameObject;
+class IShape2D;
+
+//World-space bounding box of an object's collision shape
+struct BroadphaseProxy
+{
+	float minX, minY;     //Bottom left
+	float maxX, maxY;     //Top right
+	unsigned int layer;   //Bit of the collision layer the object is on
+	unsigned int mask;    //Bits of the collision layers the object reacts to
+	GameObject* pObject;  //Object the bounds belong to
+	int slot;             //The object's slot in the ObjectManager's pool - identifies it from one frame to the next
+	const IShape2D* pShape; //Object's collision shape, already placed for this step
+	bool continuous;      //If true, the object is given the swept test
+};
+
+//A pair of proxies which may be colliding, stored as indices into the proxy list
+//  first is always smaller than second
+struct BroadphasePair
+{
+	int first;
+	int second;
+};
+
+/**************************************************
+ * BROADPHASE INTERFACE ***************************
+ **************************************************/
+
+class IBroadphase
+{
+public:
+	virtual ~IBroadphase();
+	//Fills pairs with every pair of proxies whose bounds overlap, and where
+	//  at least one reacts to the other's layer.
+	//  Each pair is reported once, and pairs are sorted by first, then second,
+	//  so they are processed in the same order as the ObjectManager's list.
+	virtual void FindPairs(const std::vector<BroadphaseProxy>& proxies, std::vector<BroadphasePair>& pairs) = 0;
+};
+
+/**************************************************
+ * ALL PAIRS **************************************
+ **************************************************/
+
+//Reports every pair whose layers interact, without looking at the bounds at all.
+//  This is what the original nested list loop did, and is kept so
+//  the other broadphases can be compared against it.
+class AllPairsBroadphase : public IBroadphase
+{
+public:
+	AllPairsBroadphase();  //Constructor
+	~AllPairsBroadphase(); //Destructor
+	void FindPairs(const std::vector<BroadphaseProxy>& proxies, std::vector<BroadphasePair>& pairs) override;
+};
+
+/**************************************************
+ * UNIFORM GRID ***********************************
+ **************************************************/
+
+//Buckets every proxy into the square cells its bounds cover, then only pairs up
+//proxies that share a cell. The grid is rebuilt from scratch every frame, so it
+//copes with objects being created, recycled and deleted without any bookkeeping.
+class UniformGridBroadphase : public IBroadphase
+{
+private:
+	//A proxy's entry in one grid cell
+	struct CellEntry
+	{
+		long long cell; //Packed cell coordinates - used as the sort key
+		int proxy;      //Index into the proxy list
+	};
+	static const int MAXCELLSPERPROXY = 64; //Proxies covering more cells than this are tested against everything instead
+
+	float cellSize;                   //Width and height of each cell in world units
+	std::vector<CellEntry> entries;   //Kept between frames to avoid reallocating every frame
+	std::vector<int> firstCellX;      //Bottom left cell of each proxy, used to report shared pairs only once
+	std::vector<int> firstCellY;
+	std::vector<int> largeProxies;    //Proxies too large to bucket
+
+	int CellCoord(float value) const; //Converts a world coordinate into a cell coordinate
+public:
+	UniformGridBroadphase(float cellSize = 128.0f); //Constructor
+	~UniformGridBroadphase();                       //Destructor
+	void FindPairs(const std::vector<BroadphaseProxy>& proxies, std::vector<BroadphasePair>& pairs) override;
+};
+
+/**************************************************
+ * SWEEP AND PRUNE ********************************
+ **************************************************/
+
+//Keeps the start and end of every proxy's X interval in one sorted array, which
+//is then swept left to right - any intervals open at the same time overlap on X.
+//  The array is kept between frames and re-sorted with an insertion sort. Objects
+//  in this game mostly scroll horizontally at similar speeds, so the order barely
+//  changes from one frame to the next and the sort is close to linear.
+class SweepAndPruneBroadphase : public IBroadphase
+{
+private:
+	//One end of a proxy's interval along X
+	struct Endpoint
+	{
+		float value;         //minX or maxX of the proxy
+		int slot;            //Identifies the proxy from one frame to the next
+		int proxy;           //Index into this frame's proxy list
+		bool isMin;          //true for the start of the interval, false for the end
+	};
+
+	std::vector<Endpoint> endpoints;                //Sorted by value - persistent between frames
+	std::vector<int> proxyOfSlot;                   //This frame's proxy index for each slot, or -1 if it has none
+	std::vector<bool> tracked;                      //Whether each proxy already has endpoints in the array
+	std::vector<int> active;                        //Proxies whose interval is open during the sweep
+	std::vector<int> activeSlot;                    //Position of each proxy in active, for quick removal
+	int swaps;                                      //Endpoint swaps made by the last sort
+
+	void SortEndpoints(); //Insertion sort - cheap when the array is nearly sorted already
+public:
+	SweepAndPruneBroadphase();  //Constructor
+	~SweepAndPruneBroadphase(); //Destructor
+	void FindPairs(const std::vector<BroadphaseProxy>& proxies, std::vector<BroadphasePair>& pairs) override;
+	int GetSwapCount() const;   //Returns the number of swaps the last sort needed - a measure of frame-to-frame coherence
+};
@@ -0,0 +1,46 @@
+//Created by 16007006
+//Collision layers, and the matrix of which layers react to which
+//Every collision component sits on one layer. The broadphase only reports a pair if
+//at least one of the two reacts to the other's layer, so pairs nobody cares about
+//(rock against rock, cow against rock) never reach IShape2D::Intersects.
+
+#pragma once
+
+enum CollisionLayer{LAYER_PLAYER, LAYER_ROCK, LAYER_COW, LAYER_BULLET, NUMLAYERS};
+
+//Returns the bit standing for layer in a mask
+inline unsigned int LayerBit(CollisionLayer layer)
+{
+	return 1u << layer;
+}
+
+class CollisionMatrix
+{
+private:
+	unsigned int reactsTo[NUMLAYERS]; //For each layer, the bits of the layers it reacts to
+public:
+	//Starts with no layer reacting to anything
+	CollisionMatrix()
+	{
+		for (int i = 0; i < NUMLAYERS; i++)
+		{
+			reactsTo[i] = 0;
+		}
+	}
+
+	//Sets whether objects on layer have ProcessCollision called when they hit objects on other.
+	//  One-sided - other's reaction to layer is set separately.
+	void SetReaction(CollisionLayer layer, CollisionLayer other, bool reacts)
+	{
+		if (reacts)
+			reactsTo[layer] |= LayerBit(other);
+		else
+			reactsTo[layer] &= ~LayerBit(other);
+	}
+
+	//Returns the bits of every layer that layer reacts to
+	unsigned int GetMask(CollisionLayer layer) const
+	{
+		return reactsTo[layer];
+	}
+};
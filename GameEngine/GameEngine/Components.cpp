@@ -8,6 +8,7 @@
 #include "GameObject.h"
 #include "mysoundengine.h"
 #include "ObjectManager.h"
+#include "BlockAllocator.h"
 
 /**************
  * COMPONENTS *
@@ -27,6 +28,17 @@ Component::~Component()
 	pOwner = nullptr;
 }
 
+void* Component::operator new(size_t size)
+{
+	return BlockAllocator::GetInstance()->Allocate(size);
+}
+
+//size is the size of the actual component being deleted, as the destructor is virtual
+void Component::operator delete(void* pMemory, size_t size)
+{
+	BlockAllocator::GetInstance()->Free(pMemory, size);
+}
+
 /**************************************************
  * INPUT COMPONENT ********************************
  **************************************************/
@@ -37,24 +49,32 @@ InputComponent::InputComponent(GameObject* pOwner, float speed) : Component(pOwn
 
 	//This could be moved to a SoundComponent, but not important for assignment
 	MySoundEngine* pSE = MySoundEngine::GetInstance();
-	moveSound = pSE->LoadWav(L"thrustloop2.wav");
-	shootSound = pSE->LoadWav(L"photon2.wav");
+	//Loaded in the background, so spawning does not wait for the files
+	moveSound = pSE->LoadWavAsync(L"thrustloop2.wav");
+	shootSound = pSE->LoadWavAsync(L"photon2.wav");
 
 	pSE = nullptr;
 }
 
-InputComponent::~InputComponent() {}
+InputComponent::~InputComponent()
+{
+	//Sounds are shared between every InputComponent, and released once the last one has gone
+	MySoundEngine* pSE = MySoundEngine::GetInstance();
+	if (pSE)
+	{
+		pSE->Unload(moveSound);
+		pSE->Unload(shootSound);
+	}
+}
 
-void InputComponent::Update()
+void InputComponent::Update(const FrameContext& frame)
 {
-	timer.mark();
-	float frameTime = timer.mdFrameTime; //Conversion required for vector calculations
+	float frameTime = frame.frameTime;
 
 	// *********************************************************************
 	// Engine Inits	********************************************************
-	// KB Controls
-	MyInputs* pInputs = MyInputs::GetInstance();
-	pInputs->SampleKeyboard();
+	// KB Controls - sampled once for the frame by the game
+	const InputSnapshot* pInputs = &frame.input;
 	//Sound
 	MySoundEngine* pSE = MySoundEngine::GetInstance();
 
@@ -78,7 +98,7 @@ void InputComponent::Update()
 		pSE->Stop(moveSound);
 	}
 	
-	pOwner->velocity = velocity;
+	pOwner->SetVelocity(velocity);
 
 	// *********************************************************************
 	//Rotation *************************************************************
@@ -96,13 +116,13 @@ void InputComponent::Update()
 		//Q = shoot bullet left
 		if (pInputs->KeyPressed(DIK_Q))
 		{
-			bulletPosition = Vector2D(pOwner->position.XValue - 40.0f, pOwner->position.YValue);
+			bulletPosition = pOwner->GetPosition() + Vector2D(-40.0f, 0.0f);
 			bulletVelocity = Vector2D(-speed * 2, 0.0f);
 		}
 		//E = shoot bullet right
 		else if (pInputs->KeyPressed(DIK_E))
 		{
-			bulletPosition = Vector2D(pOwner->position.XValue + 40.0f, pOwner->position.YValue);
+			bulletPosition = pOwner->GetPosition() + Vector2D(40.0f, 0.0f);
 			bulletVelocity = Vector2D(speed * 2, 0.0f);
 		}
 
@@ -123,20 +143,13 @@ void InputComponent::Update()
 
 PhysicsComponent::PhysicsComponent(GameObject* pOwner, float rotation) : Component(pOwner)
 {
-	this->rotation = rotation;
-	timer.mark();
+	pOwner->SetAngularVelocity(rotation);
+	pOwner->SetSimulated(true);
 }
 
 PhysicsComponent::~PhysicsComponent(){}
 
-void PhysicsComponent::Update()
-{
-	timer.mark();
-	float frameTime = timer.mdFrameTime;
-
-	pOwner->position += pOwner->velocity * frameTime;
-	pOwner->angle    += this->rotation * frameTime;
-}
+void PhysicsComponent::Update(const FrameContext& frame) {/*Movement is integrated by ObjectManager::IntegrateAll*/}
 
 
 /**************************************************
@@ -148,18 +161,22 @@ RenderComponent::RenderComponent(GameObject* pOwner, wchar_t* filename, float sc
 	this->scale = scale;
 	this->transparency = transparency;
 	MyDrawEngine* pDE = MyDrawEngine::GetInstance();
-	img = pDE->LoadPicture(filename);
+	img = pDE->LoadPictureAsync(filename); //Nothing is drawn until it has loaded
 }
 
 RenderComponent::~RenderComponent() {/*Nothing yet*/}
 
-void RenderComponent::Update()
+//Drawing is done once per rendered frame by ObjectManager::RenderAll,
+//which may run between simulation steps
+void RenderComponent::Update(const FrameContext& frame) {/*Nothing*/}
+
+void RenderComponent::Draw(const Vector2D& position, float angle)
 {
 	//If visible, draw
 	if (pOwner->active)
 	{
 		MyDrawEngine* pDE = MyDrawEngine::GetInstance();
-		pDE->DrawAt(pOwner->position, img, scale, pOwner->angle, transparency);
+		pDE->DrawAt(position, img, scale, angle, transparency);
 	}
 	//else, don't draw
 }
@@ -168,7 +185,7 @@ void RenderComponent::Update()
 void RenderComponent::LoadImg(wchar_t* filename)
 {
 	MyDrawEngine* pDE = MyDrawEngine::GetInstance();
-	img = pDE->LoadPicture(filename);
+	img = pDE->LoadPictureAsync(filename);
 }
 
 //Retrieve object scale
@@ -183,60 +200,96 @@ float RenderComponent::GetScale()
 
 //CollisionComponent is the root for all collision components
 //  By default, it will destroy the owner GameObject regardless of what they have collided with.
-CollisionComponent::CollisionComponent(GameObject* pOwner) : Component(pOwner) {/*Nothing*/}
+CollisionComponent::CollisionComponent(GameObject* pOwner, CollisionLayer layer) : Component(pOwner)
+{
+	this->layer = layer;
+	this->continuous = false;
+}
 CollisionComponent::~CollisionComponent() {/*Nothing*/}
 void CollisionComponent::ProcessCollision(GameObject* otherObject)
 {
 	pOwner->active = false;
 }
+CollisionLayer CollisionComponent::GetLayer() const
+{
+	return layer;
+}
+void CollisionComponent::SetContinuous(bool continuous)
+{
+	this->continuous = continuous;
+}
+bool CollisionComponent::IsContinuous() const
+{
+	return continuous;
+}
 
 /****************************************
  * Shape-Specific Collision Components *
  ****************************************/
 
 //BoxCollisionComponent will destroy the owner GameObject regardless of what they have collided with.
-BoxCollisionComponent::BoxCollisionComponent(GameObject* pOwner, float width, float height) : CollisionComponent(pOwner)
+BoxCollisionComponent::BoxCollisionComponent(GameObject* pOwner, float width, float height, CollisionLayer layer) : CollisionComponent(pOwner, layer)
 {
 	this->width  = width;
 	this->height = height;
 }
 BoxCollisionComponent::~BoxCollisionComponent() {/*Nothing*/}
 IShape2D* BoxCollisionComponent::GetShape()
+{
+	return (&shape); //Return reference
+}
+
+const Rectangle2D& BoxCollisionComponent::GetBounds() const
+{
+	return shape;
+}
+
+void BoxCollisionComponent::UpdateShape()
 {
 	//Rescale collision shape relative to object
 	float scale = pOwner->GetRender()->GetScale();
-	
-	//Force-update shape position
-	shape.PlaceAt(pOwner->position.YValue + (scale * height), //Top
-				  pOwner->position.XValue - (scale * width),  //Left
-				  pOwner->position.YValue - (scale * height), //Bottom
-				  pOwner->position.XValue + (scale * width)); //Right
-	return (&shape); //Return reference
+
+	Vector2D position = pOwner->GetPosition();
+	shape.PlaceAt(position.YValue + (scale * height), //Top
+				  position.XValue - (scale * width),  //Left
+				  position.YValue - (scale * height), //Bottom
+				  position.XValue + (scale * width)); //Right
 }
 
 
 //DEBUG ONLY - Visualises collision shape
-void BoxCollisionComponent::Update()
+void BoxCollisionComponent::Update(const FrameContext& frame)
 {
-	//MyDrawEngine::GetInstance()->FillRect(this->shape, MyDrawEngine::YELLOW, pOwner->angle);
+	//MyDrawEngine::GetInstance()->FillRect(this->shape, MyDrawEngine::YELLOW, pOwner->GetAngle());
 }
 
 //CircleCollisionComponent will destroy the owner GameObject regardless of what they have collided with.
-CircleCollisionComponent::CircleCollisionComponent(GameObject* pOwner, float radius) : CollisionComponent(pOwner)
+CircleCollisionComponent::CircleCollisionComponent(GameObject* pOwner, float radius, CollisionLayer layer) : CollisionComponent(pOwner, layer)
 {
 	this->radius = radius;
 }
 CircleCollisionComponent::~CircleCollisionComponent() {/*Nothing*/} 
 IShape2D* CircleCollisionComponent::GetShape()
 {
-	shape.PlaceAt(pOwner->position, pOwner->GetRender()->GetScale() * radius); //Force-update shape position
-	return (&shape);                                        //before returning reference
+	return (&shape); //Return reference
+}
+
+const Rectangle2D& CircleCollisionComponent::GetBounds() const
+{
+	return bounds;
+}
+
+void CircleCollisionComponent::UpdateShape()
+{
+	shape.PlaceAt(pOwner->GetPosition(), pOwner->GetRender()->GetScale() * radius);
+	Vector2D extent(shape.GetRadius(), shape.GetRadius());
+	bounds.PlaceAt(shape.GetCentre() - extent, shape.GetCentre() + extent);
 }
 
 //DEBUG ONLY - Visualises collision shape
-void CircleCollisionComponent::Update()
+void CircleCollisionComponent::Update(const FrameContext& frame)
 {
-	//MyDrawEngine::GetInstance()->FillCircle(pOwner->position, this->radius, MyDrawEngine::YELLOW);
+	//MyDrawEngine::GetInstance()->FillCircle(pOwner->GetPosition(), this->radius, MyDrawEngine::YELLOW);
 }
 
 /****************************************
@@ -244,44 +297,39 @@ void CircleCollisionComponent::Update()
  ****************************************/
 
 //Rocks are indestructible, and therefore override the ProcesCollision function to do nothing
-RockCollisionComponent::RockCollisionComponent(GameObject* pOwner, float radius) : CircleCollisionComponent(pOwner, radius){/*Nothing*/}
+RockCollisionComponent::RockCollisionComponent(GameObject* pOwner, float radius) : CircleCollisionComponent(pOwner, radius, LAYER_ROCK){/*Nothing*/}
 RockCollisionComponent::~RockCollisionComponent() {/*Nothing*/}
 void RockCollisionComponent::ProcessCollision(GameObject* otherObject){/*Rocks are indestructible*/}
 
 //The UFO is destroyed by everything, except cows
-UFOCollisionComponent::UFOCollisionComponent(GameObject* pOwner, float radius) : CircleCollisionComponent(pOwner, radius) {/*Nothing*/ }
+//  The player layer does not react to cows, so anything reaching here kills the UFO
+UFOCollisionComponent::UFOCollisionComponent(GameObject* pOwner, float radius) : CircleCollisionComponent(pOwner, radius, LAYER_PLAYER) {/*Nothing*/ }
 UFOCollisionComponent::~UFOCollisionComponent() {/*Nothing*/ }
 void UFOCollisionComponent::ProcessCollision(GameObject* otherObject)
 {
-	//The only object that doesn't kill the player is cows
-	if (typeid(*otherObject->GetCollision()) != typeid(CowCollisionComponent))
-	{
-		pOwner->active = false;
-	}
+	pOwner->active = false;
 }
 
 //Bullets may award points for hitting certain objects, i.e. cows are worth 100points
-BulletCollisionComponent::BulletCollisionComponent(GameObject* pOwner, float width, float height) : BoxCollisionComponent(pOwner, width, height) {/*Nothing*/ }
+BulletCollisionComponent::BulletCollisionComponent(GameObject* pOwner, float width, float height) : BoxCollisionComponent(pOwner, width, height, LAYER_BULLET) {/*Nothing*/ }
 BulletCollisionComponent::~BulletCollisionComponent() {/*Nothing*/ }
 void BulletCollisionComponent::ProcessCollision(GameObject* otherObject)
 {
-	if (typeid(*otherObject->GetCollision()) == typeid(CowCollisionComponent))
+	if (otherObject->GetCollision()->GetLayer() == LAYER_COW)
 	{
-		Game::GetInstance()->AddPoints(100.0f); //Award player 100 points
+		pOwner->GetOM()->AddPoints(100.0f); //Award player 100 points
 	}
 	pOwner->active = false; //Destroy bullet
 }
 
 //Bullets may award points for hitting certain objects, i.e. cows are worth 100points
-CowCollisionComponent::CowCollisionComponent(GameObject* pOwner, float width, float height) : BoxCollisionComponent(pOwner, width, height) {/*Nothing*/ }
+//  The cow layer only reacts to bullets, so anything reaching here has shot the cow
+CowCollisionComponent::CowCollisionComponent(GameObject* pOwner, float width, float height) : BoxCollisionComponent(pOwner, width, height, LAYER_COW) {/*Nothing*/ }
 CowCollisionComponent::~CowCollisionComponent() {/*Nothing*/ }
 void CowCollisionComponent::ProcessCollision(GameObject* otherObject)
 {
 	//If a cow is shot, it will be destroyed
-	if (typeid(*otherObject->GetCollision()) == typeid(BulletCollisionComponent))
-	{
-		pOwner->active = false;
-	}
+	pOwner->active = false;
 }
 
 /**************************************************
@@ -294,11 +342,12 @@ ExpirationComponent::ExpirationComponent(GameObject* pOwner, bool recyclable) :
 }
 ExpirationComponent::~ExpirationComponent() {/*Nothing*/}
 
-void ExpirationComponent::Update()
+void ExpirationComponent::Update(const FrameContext& frame)
 {
 	//If object has gone out of bounds (expired)
-	if (pOwner->position.XValue < -1920 ||  pOwner->position.XValue >  1920 
-	||  pOwner->position.YValue < -1080 ||  pOwner->position.YValue >  1080)
+	Vector2D position = pOwner->GetPosition();
+	if (position.XValue < -1920 ||  position.XValue >  1920 
+	||  position.YValue < -1080 ||  position.YValue >  1080)
 	{
 		//If object is recyclable, recycle. Otherwise, deactivate
 		this->recyclable ? Recycle() : pOwner->active = false;
@@ -307,5 +356,6 @@ void ExpirationComponent::Update()
 
 void ExpirationComponent::Recycle()
 {
-	pOwner->position = Vector2D((rand() % 1920) + 1920.0f, rand() % 2160 - 1080.0f);
+	pOwner->SetPosition(Vector2D((rand() % 1920) + 1920.0f, rand() % 2160 - 1080.0f));
+	pOwner->SnapTransform();
 } 
\ No newline at end of file
@@ -0,0 +1,723 @@
+//Created by 16007006
+//Direct3D 9 implementation of DrawBackend
+//The device handling is Chris Rook's, moved here from MyDrawEngine
+
+#ifdef _WIN32
+
+#include "D3D9Backend.h"
+#include "errorlogger.h"
+
+// *************************************************************
+// Construction and device management
+// *************************************************************
+
+D3D9Backend::D3D9Backend(HWND hwnd)
+{
+	// Set pointers to NULL
+	m_lpD3D = nullptr;
+	m_lpD3DDevice = nullptr;
+	m_lpSprite = nullptr;
+	m_lpPrimitiveBuffer = nullptr;
+	m_PrimitiveBufferPos = 0;
+
+	m_Hwnd = hwnd;				   // Remember the window handle
+
+	// Handles start at 1, so zero is never valid
+	m_NextPicture = 1;
+	m_NextFont = 1;
+}		// Constructor
+
+// *******************************************************************
+
+D3D9Backend::~D3D9Backend()
+{
+	ReleaseResources();
+
+	// The pages are managed, so ReleaseResources leaves them
+	for(std::map<int, LPDIRECT3DTEXTURE9>::iterator it = m_PageList.begin(); it!=m_PageList.end(); it++)
+	{
+		if(it->second)
+			it->second->Release();
+	}
+	m_PageList.clear();
+
+	// Release Direct3D interface
+	if(m_lpD3D)
+	{
+		m_lpD3D->Release();
+		m_lpD3D = nullptr;
+	}
+
+	// Release the graphics device
+	if(m_lpD3DDevice)
+	{
+		m_lpD3DDevice->Release();
+		m_lpD3DDevice = nullptr;
+	}
+}	// Destructor
+
+// *******************************************************************
+
+void D3D9Backend::SetPresentParameters(D3DPRESENT_PARAMETERS& d3dpp, int width, int height, bool fullScreen) const
+{
+	ZeroMemory(&d3dpp, sizeof(d3dpp));	      // Set it all to zero
+
+	d3dpp.Windowed = !fullScreen;			   // Whatever the user requested
+	d3dpp.SwapEffect = D3DSWAPEFFECT_FLIP;	   // Slightly slower, but allows access to previous back buffer if ever needed.
+	d3dpp.hDeviceWindow = m_Hwnd;			      // Handle to the window
+	d3dpp.BackBufferWidth = width;	         // Requested screen width
+	d3dpp.BackBufferHeight = height;        // Requested screen height
+	d3dpp.BackBufferFormat = D3DFMT_X8R8G8B8; // Back buffer formattaed to 32 bit XRGB
+}
+
+// *******************************************************************
+
+// Connects to Direct3D and creates the device
+ErrorType D3D9Backend::Start(int width, int height, bool fullScreen)
+{
+	// Connect to direct 3D 9
+	m_lpD3D=Direct3DCreate9(D3D_SDK_VERSION);
+	if (m_lpD3D == nullptr)
+	{
+		ErrorLogger::Writeln(L"Could not connect to Direct3D");
+		return FAILURE;		            // No point going any further
+	}
+
+	// Set the presentation parameters options
+	D3DPRESENT_PARAMETERS d3dpp;		         // Order form for options
+	SetPresentParameters(d3dpp, width, height, fullScreen);
+
+	// Create the device
+	HRESULT err;			// To store the error result
+	err=m_lpD3D->CreateDevice(D3DADAPTER_DEFAULT,		// Default graphics adapter
+                      D3DDEVTYPE_HAL,			// Requesting hardware abstraction layer
+                      m_Hwnd,					   // Handle to the window. Again.
+                      D3DCREATE_MIXED_VERTEXPROCESSING,	// Process vertices in software !!!!!!
+                      &d3dpp,					   // The presentation parameters
+                      &m_lpD3DDevice);			// Pointer to the device
+
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Failed to create the device");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		m_lpD3D->Release();
+		m_lpD3D=nullptr;
+		return FAILURE;		// No point going any further
+	}
+
+	err = D3DXCreateSprite(m_lpD3DDevice, &m_lpSprite );
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Failed to create sprite");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+
+		m_lpD3D->Release();
+		m_lpD3D=nullptr;
+		m_lpD3DDevice->Release();
+		m_lpD3DDevice = nullptr;
+		return FAILURE;		// No point going any further
+	}
+
+	if(CreatePrimitiveBuffer() == FAILURE)
+	{
+		m_lpSprite->Release();
+		m_lpSprite = nullptr;
+		m_lpD3D->Release();
+		m_lpD3D=nullptr;
+		m_lpD3DDevice->Release();
+		m_lpD3DDevice = nullptr;
+		return FAILURE;		// No point going any further
+	}
+
+	// Start the first scene
+	m_lpD3DDevice->BeginScene();
+
+	return SUCCESS;
+}		// Start
+
+// *******************************************************************
+
+// Resets the device if it goes FUBAR or when switching fullscreen/windowed
+ErrorType D3D9Backend::Reset(int width, int height, bool fullScreen)
+{
+	// Set the presentation parameters options
+	D3DPRESENT_PARAMETERS d3dpp;			      // Order form
+	SetPresentParameters(d3dpp, width, height, fullScreen);
+
+	// Need to release everything in the default pool
+	ReleaseResources();
+
+	// Reset the device
+	HRESULT err = m_lpD3DDevice->Reset(&d3dpp);
+
+	// Did it work?
+	if(FAILED(err))
+	{
+		// Big trouble.
+		ErrorLogger::Writeln(L"Failed to reset device.");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+	}
+
+	// Now can reload the bitmaps and fonts.
+	ReloadResources();
+
+	// Position the window in case needed
+    SetWindowPos(m_Hwnd, HWND_NOTOPMOST,
+                     0, 0,
+                     width,
+                     height,
+                     SWP_SHOWWINDOW);
+
+	if(FAILED(err))
+		return FAILURE;
+	else
+		return SUCCESS;
+}		// Reset
+
+// *******************************************************************
+
+void D3D9Backend::GetNativeResolution(int& width, int& height) const
+{
+	width = GetSystemMetrics(SM_CXSCREEN);
+	height = GetSystemMetrics(SM_CYSCREEN);
+}
+
+// *******************************************************************
+
+// Releases fonts, the sprite and the vertex buffer.
+// Does not delete them from the maps!
+// The atlas pages are in the managed pool, so Direct3D restores them itself.
+void D3D9Backend::ReleaseResources()
+{
+	// Loop through all fonts
+	for(std::map<int, MyFont>::iterator fit = m_FontList.begin(); fit!=m_FontList.end(); fit++)
+	{
+		if(fit->second.m_pFont)
+			fit->second.m_pFont->Release();
+		fit->second.m_pFont = nullptr;
+	}
+
+	if(m_lpSprite)
+		m_lpSprite->Release();
+	m_lpSprite = nullptr;
+
+	if(m_lpPrimitiveBuffer)
+		m_lpPrimitiveBuffer->Release();
+	m_lpPrimitiveBuffer = nullptr;
+}	// ReleaseResources
+
+// *******************************************************************
+
+// Reload everything. Needed after resetting the device
+void D3D9Backend::ReloadResources()
+{
+	for(std::map<int, MyFont>::iterator fit = m_FontList.begin(); fit!=m_FontList.end(); fit++)
+		CreateD3DFont(fit->second);
+
+	HRESULT err = D3DXCreateSprite(m_lpD3DDevice, &m_lpSprite );
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Failed to create sprite on device reset");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+	}
+
+	CreatePrimitiveBuffer();
+}	// ReloadResources
+
+// *******************************************************************
+
+//Clears the back buffer
+ErrorType D3D9Backend::Clear()
+{
+	HRESULT err = m_lpD3DDevice->Clear(0, NULL, D3DCLEAR_TARGET, 0,1.0f,0);
+
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Could not clear the back buffer.");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+	return SUCCESS;
+}	// Clear
+
+// *******************************************************************
+
+// Presents the Back Buffer and starts new scene
+ErrorType D3D9Backend::Present()
+{
+	HRESULT err;		// To store error result
+
+	// End the scene
+	m_lpD3DDevice->EndScene();
+	// Present
+	err= m_lpD3DDevice->Present(NULL, NULL, NULL, NULL);
+
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Could not flip.");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+
+	// Start the next one
+	err = m_lpD3DDevice->BeginScene();
+
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Could not start new scene after flip.");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+	return SUCCESS;
+}	// Present
+
+// *******************************************************************
+
+unsigned long long D3D9Backend::GetFrameChecksum() const
+{
+	return 0;
+}
+
+// *************************************************************
+// Textures
+// *************************************************************
+
+// Pages are managed, so they can be written to and survive a reset.
+// Direct3D may round the size up if the card needs powers of two.
+ErrorType D3D9Backend::CreatePage(int page, int width, int height)
+{
+	LPDIRECT3DTEXTURE9 lpPage = nullptr;
+	HRESULT err = D3DXCreateTexture(m_lpD3DDevice, width, height, 1, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &lpPage);
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Failed to create an atlas page");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+
+	// Clear it, so the padding between pictures is transparent
+	D3DSURFACE_DESC desc;
+	lpPage->GetLevelDesc(0, &desc);
+	D3DLOCKED_RECT locked;
+	err = lpPage->LockRect(0, &locked, NULL, 0);
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Failed to lock a new atlas page");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		lpPage->Release();
+		return FAILURE;
+	}
+	for(UINT y=0;y<desc.Height;y++)
+		memset((BYTE*)locked.pBits + y*locked.Pitch, 0, desc.Width*4);
+	lpPage->UnlockRect(0);
+
+	m_PageList[page] = lpPage;
+	return SUCCESS;
+}	// CreatePage
+
+// *******************************************************************
+
+// Finds room in the atlas, starting a page if needed
+ErrorType D3D9Backend::AddToAtlas(int width, int height, DrawRegion& region)
+{
+	int pageWidth, pageHeight;
+	m_Atlas.Insert(width, height, region, pageWidth, pageHeight);
+	if(pageWidth > 0 && CreatePage(region.texture, pageWidth, pageHeight) == FAILURE)
+	{
+		m_Atlas.Remove(region.texture);
+		return FAILURE;
+	}
+	return SUCCESS;
+}	// AddToAtlas
+
+// *******************************************************************
+
+void D3D9Backend::RemoveFromAtlas(const DrawRegion& region)
+{
+	if(!m_Atlas.Remove(region.texture))
+		return;
+
+	// Nothing left on the page
+	std::map<int, LPDIRECT3DTEXTURE9>::iterator it = m_PageList.find(region.texture);
+	if(it==m_PageList.end())
+		return;
+	if(it->second)
+		it->second->Release();
+	m_PageList.erase(it);
+}	// RemoveFromAtlas
+
+// *******************************************************************
+
+ErrorType D3D9Backend::GetPictureSize(const wchar_t filename[], int& width, int& height)
+{
+	D3DXIMAGE_INFO info;
+	HRESULT err = D3DXGetImageInfoFromFile(filename, &info);
+	if(FAILED(err))
+		return FAILURE;
+
+	width = info.Width;
+	height = info.Height;
+	return SUCCESS;
+}	// GetPictureSize
+
+// *******************************************************************
+
+ErrorType D3D9Backend::LoadPicture(const wchar_t filename[], int& picture, DrawRegion& region)
+{
+	int width, height;
+	if(GetPictureSize(filename, width, height) == FAILURE)		// Probably a bad filename
+	{
+		ErrorLogger::Write(L"Failed to read image file: ");
+		ErrorLogger::Writeln(filename);
+		return FAILURE;
+	}
+
+	if(AddToAtlas(width, height, region) == FAILURE)
+		return FAILURE;
+
+	// Load the picture straight into its place on the page
+	LPDIRECT3DSURFACE9 lpSurface = nullptr;
+	m_PageList[region.texture]->GetSurfaceLevel(0, &lpSurface);
+	RECT destination;
+	destination.left = region.left;
+	destination.top = region.top;
+	destination.right = region.left + width;
+	destination.bottom = region.top + height;
+	HRESULT err = D3DXLoadSurfaceFromFile(lpSurface, NULL, &destination, filename, NULL,
+		D3DX_FILTER_NONE,
+		0xff000000,				// Colour key is black
+		NULL);
+	lpSurface->Release();
+
+	if(FAILED(err))
+	{
+		ErrorLogger::Write(L"Failed to create texture from file: ");
+		ErrorLogger::Writeln(filename);
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		RemoveFromAtlas(region);
+		return FAILURE;
+	}
+
+	picture = m_NextPicture++;
+	m_PictureList.insert(std::pair<int, DrawRegion>(picture, region));
+	return SUCCESS;
+}	// LoadPicture
+
+// *******************************************************************
+
+// The pixels are already in the page format, so D3DX only has to copy them
+ErrorType D3D9Backend::LoadPictureData(const unsigned int pixels[], int width, int height, int& picture, DrawRegion& region)
+{
+	if(AddToAtlas(width, height, region) == FAILURE)
+		return FAILURE;
+
+	LPDIRECT3DSURFACE9 lpSurface = nullptr;
+	m_PageList[region.texture]->GetSurfaceLevel(0, &lpSurface);
+	RECT source;
+	source.left = 0;
+	source.top = 0;
+	source.right = width;
+	source.bottom = height;
+	RECT destination;
+	destination.left = region.left;
+	destination.top = region.top;
+	destination.right = region.left + width;
+	destination.bottom = region.top + height;
+	HRESULT err = D3DXLoadSurfaceFromMemory(lpSurface, NULL, &destination, pixels, D3DFMT_A8R8G8B8,
+		width*4, NULL, &source,
+		D3DX_FILTER_NONE,
+		0);						// Transparency is already in the alpha channel
+	lpSurface->Release();
+
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Failed to copy a picture into the atlas");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		RemoveFromAtlas(region);
+		return FAILURE;
+	}
+
+	picture = m_NextPicture++;
+	m_PictureList.insert(std::pair<int, DrawRegion>(picture, region));
+	return SUCCESS;
+}	// LoadPictureData
+
+// *******************************************************************
+
+void D3D9Backend::ReleasePicture(int picture)
+{
+	std::map<int, DrawRegion>::iterator picit = m_PictureList.find(picture);
+	if(picit==m_PictureList.end())
+		return;
+
+	RemoveFromAtlas(picit->second);
+	m_PictureList.erase(picit);
+}	// ReleasePicture
+
+// *************************************************************
+// Drawing
+// *************************************************************
+
+// Draws sorted sprites between a single Begin/End
+ErrorType D3D9Backend::DrawSprites(const DrawSprite sprites[], unsigned int numSprites)
+{
+	if(!m_lpSprite)
+		return FAILURE;
+
+	HRESULT err = m_lpSprite->Begin(D3DXSPRITE_ALPHABLEND);		// Alpha Blending requested
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Failed to begin sprite render in DrawSprites");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+
+	ErrorType result = SUCCESS;
+	int currentHandle = 0;
+	LPDIRECT3DTEXTURE9 lpCurrentTexture = nullptr;
+	for(unsigned int i=0;i<numSprites;i++)
+	{
+		const DrawSprite& sprite = sprites[i];
+
+		// Sprites are sorted, so the page only needs looking up when it changes
+		if(sprite.source.texture != currentHandle)
+		{
+			currentHandle = sprite.source.texture;
+			std::map<int, LPDIRECT3DTEXTURE9>::iterator it = m_PageList.find(currentHandle);
+			lpCurrentTexture = (it==m_PageList.end()) ? nullptr : it->second;
+		}
+		if(!lpCurrentTexture)
+			continue;
+
+		// Set the transformation matrix
+		D3DXMATRIX transform;
+		D3DXMatrixIdentity(&transform);
+		transform._11 = sprite.m11;
+		transform._12 = sprite.m12;
+		transform._21 = sprite.m21;
+		transform._22 = sprite.m22;
+		transform._41 = sprite.dx;
+		transform._42 = sprite.dy;
+		m_lpSprite->SetTransform(&transform);
+
+		// The part of the page holding the picture
+		RECT source;
+		source.left = sprite.source.left;
+		source.top = sprite.source.top;
+		source.right = sprite.source.left + sprite.source.width;
+		source.bottom = sprite.source.top + sprite.source.height;
+
+		// Draw the sprite. D3DX submits consecutive sprites with the same texture as a single batch
+		err = m_lpSprite->Draw(lpCurrentTexture, &source, NULL, NULL, sprite.colour);
+		if(FAILED(err) && result == SUCCESS)
+		{
+			ErrorLogger::Writeln(L"Failed to draw sprite in DrawSprites");
+			ErrorLogger::Writeln(ERRORSTRING(err));
+			result = FAILURE;
+		}
+	}
+
+	// Complete the sprites
+	m_lpSprite->End();
+	return result;
+}	// DrawSprites
+
+// *******************************************************************
+
+// Creates the vertex buffer that all primitives are drawn from.
+// It is dynamic, so it lives in the default pool and must be recreated after a reset.
+ErrorType D3D9Backend::CreatePrimitiveBuffer()
+{
+	HRESULT err = m_lpD3DDevice->CreateVertexBuffer(PRIMITIVEBUFFERSIZE*sizeof(DrawVertex),
+							   D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY,
+							   MYFVF,
+							   D3DPOOL_DEFAULT,
+							   &m_lpPrimitiveBuffer,
+							   NULL);
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Failed to create the primitive vertex buffer");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		m_lpPrimitiveBuffer = nullptr;
+		return FAILURE;
+	}
+
+	// Start at the end, so the first lock discards
+	m_PrimitiveBufferPos = PRIMITIVEBUFFERSIZE;
+	return SUCCESS;
+}	// CreatePrimitiveBuffer
+
+// *******************************************************************
+
+// Copies the vertices into the dynamic buffer and draws them
+ErrorType D3D9Backend::DrawPrimitives(DrawPrimitiveType type, bool blend, const DrawVertex vertices[], unsigned int numVertices, int& drawCalls)
+{
+	if(!m_lpPrimitiveBuffer)
+		return FAILURE;
+
+	D3DPRIMITIVETYPE d3dType = D3DPT_TRIANGLELIST;
+	unsigned int verticesPerPrimitive = 3;
+	if(type == DRAW_POINTLIST)
+	{
+		d3dType = D3DPT_POINTLIST;
+		verticesPerPrimitive = 1;
+	}
+	else if(type == DRAW_LINELIST)
+	{
+		d3dType = D3DPT_LINELIST;
+		verticesPerPrimitive = 2;
+	}
+
+	// Set my vertex format and the persistent buffer as the stream source
+	m_lpD3DDevice->SetFVF(MYFVF);
+	m_lpD3DDevice->SetStreamSource(0, m_lpPrimitiveBuffer, 0, sizeof(DrawVertex));
+
+	m_lpD3DDevice->SetRenderState(D3DRS_ALPHABLENDENABLE, blend ? TRUE : FALSE);
+	if(blend)
+	{
+		m_lpD3DDevice->SetRenderState(D3DRS_BLENDOP, D3DBLENDOP_ADD);
+		m_lpD3DDevice->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
+		m_lpD3DDevice->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
+	}
+
+	// A run that stops part way through a primitive is malformed - draw the whole primitives in it
+	if(numVertices % verticesPerPrimitive != 0)
+	{
+		ErrorLogger::Writeln(L"Vertex count is not a whole number of primitives in DrawPrimitives");
+		numVertices -= numVertices % verticesPerPrimitive;
+	}
+
+	ErrorType result = SUCCESS;
+
+	// More vertices than the space left in the buffer are drawn in several pieces
+	unsigned int done = 0;
+	while(done < numVertices)
+	{
+		// Append after what the GPU may still be reading, or wrap to the start and discard the lot
+		DWORD lockFlags = D3DLOCK_NOOVERWRITE;
+		if(m_PrimitiveBufferPos + verticesPerPrimitive > PRIMITIVEBUFFERSIZE)
+		{
+			m_PrimitiveBufferPos = 0;
+			lockFlags = D3DLOCK_DISCARD;
+		}
+
+		// Whole primitives only
+		unsigned int count = numVertices - done;
+		if(count > PRIMITIVEBUFFERSIZE - m_PrimitiveBufferPos)
+			count = PRIMITIVEBUFFERSIZE - m_PrimitiveBufferPos;
+		count -= count % verticesPerPrimitive;
+		if(count == 0)
+			break;			// Only if the buffer is smaller than one primitive
+
+		VOID* pBuff;		// Pointer to the locked part of the buffer
+		HRESULT err = m_lpPrimitiveBuffer->Lock(m_PrimitiveBufferPos*sizeof(DrawVertex), count*sizeof(DrawVertex), (void**)&pBuff, lockFlags);
+		if(FAILED(err))
+		{
+			ErrorLogger::Writeln(L"Failed to lock the primitive vertex buffer in DrawPrimitives");
+			ErrorLogger::Writeln(ERRORSTRING(err));
+			result = FAILURE;
+			break;
+		}
+
+		// Copy vertices into the buffer
+		memcpy(pBuff, &vertices[done], count*sizeof(DrawVertex));
+		m_lpPrimitiveBuffer->Unlock();
+
+		err = m_lpD3DDevice->DrawPrimitive(d3dType, m_PrimitiveBufferPos, count/verticesPerPrimitive);
+		if(FAILED(err) && result == SUCCESS)
+		{
+			ErrorLogger::Writeln(L"Failed to draw primitive in DrawPrimitives");
+			ErrorLogger::Writeln(ERRORSTRING(err));
+			result = FAILURE;
+		}
+		drawCalls++;
+
+		m_PrimitiveBufferPos += count;
+		done += count;
+	}
+
+	// Leave blending off, which is the device default
+	if(blend)
+		m_lpD3DDevice->SetRenderState(D3DRS_ALPHABLENDENABLE, FALSE);
+
+	return result;
+}	// DrawPrimitives
+
+// *************************************************************
+// Fonts and text
+// *************************************************************
+
+ErrorType D3D9Backend::CreateD3DFont(MyFont& font)
+{
+	// Set up the value of "THICKNESS" needed in D3DXCreateFont
+	UINT boldness =FW_MEDIUM;
+	if(font.m_bold == true)
+		boldness = FW_BOLD;
+
+	// Create the font, as requested
+	HRESULT err = D3DXCreateFont(m_lpD3DDevice, font.m_height, 0, boldness, 0, font.m_italic,
+		DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, DEFAULT_QUALITY,
+		DEFAULT_PITCH | FF_DONTCARE, font.m_fontName.c_str(), &font.m_pFont );
+
+	if(FAILED(err))
+	{
+		ErrorLogger::Write(L"Failed to create font ");
+		ErrorLogger::Writeln(font.m_fontName.c_str());
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		if(font.m_pFont)
+			font.m_pFont->Release();
+		font.m_pFont = nullptr;
+		return FAILURE;
+	}
+	return SUCCESS;
+}	// CreateD3DFont
+
+// *******************************************************************
+
+ErrorType D3D9Backend::LoadFont(const wchar_t fontName[], int height, bool bold, bool italic, int& font)
+{
+	MyFont temp;			// To hold the font being created
+	temp.m_pFont = nullptr;
+	temp.m_bold = bold;
+	temp.m_fontName = fontName;
+	temp.m_height = height;
+	temp.m_italic = italic;
+
+	if(CreateD3DFont(temp) == FAILURE)
+		return FAILURE;
+
+	font = m_NextFont++;
+	m_FontList.insert(std::pair<int, MyFont>(font, temp));
+	return SUCCESS;
+}	// LoadFont
+
+// *******************************************************************
+
+ErrorType D3D9Backend::WriteText(int font, int x, int y, const wchar_t text[], unsigned int colour)
+{
+	std::map<int, MyFont>::iterator fit = m_FontList.find(font);
+	if(fit == m_FontList.end() || !fit->second.m_pFont)
+		return FAILURE;
+
+	// Rect to draw the text inside
+	RECT rect;
+	rect.left =x;
+	rect.top = y;
+	rect.right =x+50;		// Will get expanded when the rect is calculated
+	rect.bottom = y+50;
+
+	// Nonna-Raymond call to DrawText. Calculates the rect, but does not draw
+	fit->second.m_pFont->DrawText(NULL, text, -1, &rect, DT_CALCRECT , colour);
+
+	// Now make the real call.
+	HRESULT err = fit->second.m_pFont->DrawText(NULL, text, -1, &rect, 0 , colour);
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"WriteText failed to draw text.");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+	return SUCCESS;
+}	// WriteText
+
+#endif
@@ -0,0 +1,105 @@
+//Created by 16007006
+//Direct3D 9 implementation of DrawBackend
+//Holds the device, the textures, the fonts, the D3DX sprite and the dynamic vertex
+//buffer that used to live directly in MyDrawEngine. Windows only.
+//Pictures are packed into atlas pages in the managed pool, so they survive a reset.
+
+#pragma once
+
+#ifdef _WIN32
+
+#pragma comment(lib, "d3d9.lib")
+#pragma comment(lib, "d3dx9.lib")
+#pragma comment(lib, "dxguid.lib")
+#include <d3d9.h>		// directX draw
+#include <d3dx9.h>		// extra directX draw stuff
+#include <map>
+#include <string>
+#include "DrawBackend.h"
+#include "TextureAtlas.h"
+
+class D3D9Backend : public DrawBackend
+{
+private:
+#define MYFVF (D3DFVF_XYZRHW|D3DFVF_DIFFUSE)
+
+	// Size of the dynamic vertex buffer, in vertices. Bigger submissions are drawn in several pieces.
+	static const unsigned int PRIMITIVEBUFFERSIZE = 16384;
+
+	// Inner struct to store each font, so it can be recreated after a reset
+	struct MyFont
+	{
+		LPD3DXFONT m_pFont;		      // Pointer to the font
+		std::wstring m_fontName;		// Name of the font
+		int m_height;			         // Height of the font
+		bool m_bold;			         // If true, font will be bold
+		bool m_italic;			         // If true, font will be italicised
+	};
+
+	HWND m_Hwnd;								// The handle to the window
+	IDirect3D9* m_lpD3D;					   // Pointer to direct draw
+	IDirect3DDevice9* m_lpD3DDevice;		// Pointer to the D3D device
+	LPD3DXSPRITE m_lpSprite;				// Sprite to draw pictures
+
+	TextureAtlas m_Atlas;						// Where each picture goes in the pages
+	std::map<int, LPDIRECT3DTEXTURE9> m_PageList;	// Atlas pages, by texture handle
+	std::map<int, DrawRegion> m_PictureList;	// Loaded pictures, by handle
+	std::map<int, MyFont> m_FontList;			// Loaded fonts, by handle
+	int m_NextPicture;						// Handle of the next picture to be loaded
+	int m_NextFont;							// Handle of the next font to be loaded
+
+	LPDIRECT3DVERTEXBUFFER9 m_lpPrimitiveBuffer;	// Dynamic vertex buffer used as a ring by DrawPrimitives
+	unsigned int m_PrimitiveBufferPos;		// Next free vertex in m_lpPrimitiveBuffer
+
+	// Fills in the presentation parameters for the requested size and mode
+	void SetPresentParameters(D3DPRESENT_PARAMETERS& d3dpp, int width, int height, bool fullScreen) const;
+
+	// Creates an empty, transparent atlas page of the given size
+	ErrorType CreatePage(int page, int width, int height);
+
+	// Finds room in the atlas for a picture, creating a new page if needed
+	ErrorType AddToAtlas(int width, int height, DrawRegion& region);
+
+	// Releases a picture's space in the atlas, and its page if nothing else is on it
+	void RemoveFromAtlas(const DrawRegion& region);
+
+	// Creates the font. Used on loading and after resetting the device.
+	ErrorType CreateD3DFont(MyFont& font);
+
+	// Creates the dynamic vertex buffer used for primitives. Used on startup and after resetting the device.
+	ErrorType CreatePrimitiveBuffer();
+
+	// Releases everything in the default pool - fonts, sprite and the vertex buffer.
+	// Used when resetting the device or on destruction.
+	void ReleaseResources();
+
+	// Recreates everything released by ReleaseResources. Used after resetting the device.
+	void ReloadResources();
+
+public:
+	// Parameters:
+	//		hwnd		The handle to the application's window.
+	D3D9Backend(HWND hwnd);
+
+	// Releases everything, including the device
+	~D3D9Backend();
+
+	ErrorType Start(int width, int height, bool fullScreen) override;
+	ErrorType Reset(int width, int height, bool fullScreen) override;
+	void GetNativeResolution(int& width, int& height) const override;
+	ErrorType Clear() override;
+	ErrorType Present() override;
+	ErrorType GetPictureSize(const wchar_t filename[], int& width, int& height) override;
+	ErrorType LoadPicture(const wchar_t filename[], int& picture, DrawRegion& region) override;
+	ErrorType LoadPictureData(const unsigned int pixels[], int width, int height, int& picture, DrawRegion& region) override;
+	void ReleasePicture(int picture) override;
+	ErrorType DrawSprites(const DrawSprite sprites[], unsigned int numSprites) override;
+	ErrorType DrawPrimitives(DrawPrimitiveType type, bool blend, const DrawVertex vertices[], unsigned int numVertices, int& drawCalls) override;
+	ErrorType LoadFont(const wchar_t fontName[], int height, bool bold, bool italic, int& font) override;
+	ErrorType WriteText(int font, int x, int y, const wchar_t text[], unsigned int colour) override;
+
+	// The back buffer is not read back, so there is no checksum. Returns zero.
+	unsigned long long GetFrameChecksum() const override;
+};
+
+#endif
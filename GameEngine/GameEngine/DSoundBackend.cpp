@@ -0,0 +1,696 @@
+//Created by 16007006
+//DirectSound 8 implementation of SoundBackend
+//The DirectSound and wave file handling is Chris Rook's, moved here from MySoundEngine
+
+#ifdef _WIN32
+
+#define DSBCAPS_CTRLDEFAULT 0x000000E0
+
+#include "DSoundBackend.h"
+#include "WavStream.h"
+#include "errorlogger.h"
+#include <vector>
+
+// *************************************************************
+// Construction
+// *************************************************************
+
+DSoundBackend::DSoundBackend(HWND hwnd)
+{
+	m_Hwnd = hwnd;
+	lpds = nullptr;
+
+	// Handles start at 1, so zero is never valid
+	m_NextBuffer = 1;
+}		// Constructor
+
+// *******************************************************************
+
+DSoundBackend::~DSoundBackend()
+{
+	for(std::pair<const int, DSoundStream>& item : m_StreamList)
+	{
+		item.second.lpSoundBuffer->Release();
+		delete item.second.m_pSource;
+	}
+	m_StreamList.clear();
+
+	for(std::pair<const int, LPDIRECTSOUNDBUFFER>& item : m_BufferList)
+	{
+		item.second->Release();
+	}
+	m_BufferList.clear();
+
+	if (lpds)			// If not already null
+	{
+		lpds->Release();
+		lpds=nullptr;
+	}
+}		// Destructor
+
+// *******************************************************************
+
+ErrorType DSoundBackend::Start()
+{
+	// Initialise dsound
+	HRESULT err = DirectSoundCreate8(&DSDEVID_DefaultPlayback, &lpds, NULL);
+	if (FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Failed to create sound player");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		lpds=nullptr;
+		return FAILURE;
+	}
+
+	// Set cooperative level and check for error
+	err=lpds->SetCooperativeLevel(m_Hwnd, DSSCL_NORMAL);
+
+	if (FAILED(err))	// If failed to set cooperative level
+	{
+		ErrorLogger::Writeln(L"Failed to set cooperative level\n");
+		lpds->Release();
+		lpds=nullptr;
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+	return SUCCESS;
+}		// Start
+
+// *************************************************************
+// Buffers
+// *************************************************************
+
+LPDIRECTSOUNDBUFFER DSoundBackend::FindBuffer(int buffer) const
+{
+	std::map<int, LPDIRECTSOUNDBUFFER>::const_iterator it = m_BufferList.find(buffer);
+	if(it == m_BufferList.end())
+	{
+		ErrorLogger::Writeln(L"Sound buffer not created.");
+		return nullptr;
+	}
+	return it->second;
+}
+
+// *******************************************************************
+
+ErrorType DSoundBackend::NewBuffer(const WAVEFORMATEX& format, DWORD size, DWORD flags, LPDIRECTSOUNDBUFFER& lpSoundBuffer)
+{
+	if(!lpds)
+	{
+		ErrorLogger::Writeln(L"Cannot load a sound wave - No pointer to DirectSound.");
+		return FAILURE;
+	}
+
+	WAVEFORMATEX formatdesc = format;
+	DSBUFFERDESC dsbd;			// "Order form" for the sound
+	memset(&dsbd,0,sizeof(dsbd));
+	dsbd.dwSize=sizeof(dsbd);
+	dsbd.dwFlags = flags;
+	dsbd.dwBufferBytes=size;						// Set bytes needed to store
+	dsbd.lpwfxFormat=&formatdesc;
+
+	HRESULT err = lpds->CreateSoundBuffer(&dsbd,&lpSoundBuffer,NULL);
+	if (FAILED(err))
+	{
+		lpSoundBuffer=nullptr;
+		ErrorLogger::Writeln(L"Could not create a sound buffer");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+	return SUCCESS;
+}	// NewBuffer
+
+// *******************************************************************
+
+ErrorType DSoundBackend::FillBuffer(LPDIRECTSOUNDBUFFER lpSoundBuffer, const unsigned char samples[], DWORD size)
+{
+	UCHAR *tempPtr1;		// Pointer to first part of sound buffer
+	UCHAR *tempPtr2;		// Pointer to second part of sound buffer
+	DWORD length1;			// Length of first part of sound buffer
+	DWORD length2;			// Length of second part of sound buffer
+
+	// Locking the Dsound buffer
+	HRESULT err = lpSoundBuffer->Lock(0, size, (void**) &tempPtr1,
+							&length1, (void**) &tempPtr2,
+							&length2, 0);
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Couldn't lock the sound buffer.");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+
+	// Copy the two bits of the buffer
+	memcpy(tempPtr1, samples, length1);
+	if(tempPtr2)
+		memcpy(tempPtr2, samples+length1, length2);
+
+	// Unlock the Dsound buffer
+	err = lpSoundBuffer->Unlock(tempPtr1, length1, tempPtr2, length2);
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Couldn't unlock the sound buffer.");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+	return SUCCESS;
+}	// FillBuffer
+
+// *******************************************************************
+
+ErrorType DSoundBackend::LoadWav(const wchar_t filename[], int& buffer)
+// CAUTION - Multiple early returns
+{
+	WAVEFORMATEX formatdesc;	// Description of the format
+	HMMIO hWaveFile;		// Handle to the wave file
+	MMCKINFO parent;		// A parent chunk (wav file data chunks)
+	MMCKINFO child;			// A child chunk (wav file data chunks)
+
+	// ***************************************************************
+	// Most of what follows is some fairly complicated bits that
+	// open a pcm wave file, and read the contents into the
+	// directX buffer.
+
+	// Chunk info initialised
+
+	parent.ckid			= (FOURCC)0;
+	parent.cksize		= 0;
+	parent.fccType		= (FOURCC)0;
+	parent.dwDataOffset	= 0;
+	parent.dwFlags		= 0;
+
+	child=parent;
+
+	// Open the wav file
+
+	hWaveFile = mmioOpen(const_cast<wchar_t*>(filename), NULL, MMIO_READ|MMIO_ALLOCBUF);
+
+	if (!hWaveFile)			// If file could not open
+	{
+		ErrorLogger::Write(L"Failed to open sound file ");
+		ErrorLogger::Writeln(filename);
+		return FAILURE;			// Early return  **
+	}
+
+	// Find the wave section
+	// What is it with sound engineers? Is is because they are musicians
+	// that they like using meaningless terms like "descend"?
+	parent.fccType=mmioFOURCC('W','A','V','E');
+
+	if (mmioDescend(hWaveFile, &parent, NULL, MMIO_FINDRIFF))
+	{
+		ErrorLogger::Write(L"Couldn't find wave section in wave file ");
+		ErrorLogger::Writeln(filename);
+
+		mmioClose(hWaveFile,0);			// Error - close the wave file
+		return FAILURE;			// Early return  **
+	}
+
+	// Find the format section
+	child.ckid=mmioFOURCC('f','m','t',' ');
+	if (mmioDescend(hWaveFile, &child,&parent, 0)!=MMSYSERR_NOERROR)
+	{
+		ErrorLogger::Write(L"Couldn't find format section in wave file ");
+		ErrorLogger::Writeln(filename);
+
+		mmioClose(hWaveFile,0);			// Error - close the wave file
+		return FAILURE;			// Early return  **
+	}
+
+	// Read out the format data
+	if (mmioRead(hWaveFile, (char *)&formatdesc, sizeof(formatdesc))!=sizeof(formatdesc))
+	{
+		ErrorLogger::Write(L"Error in wave format of ");
+		ErrorLogger::Writeln(filename);
+
+		mmioClose(hWaveFile,0);
+		return FAILURE;			// Early return  **
+	}
+
+	// Check this is a pcm format (a standard wav format)
+	if (formatdesc.wFormatTag!=WAVE_FORMAT_PCM)
+	{
+		ErrorLogger::Write(L"Error in wave format of ");
+		ErrorLogger::Writeln(filename);
+
+		mmioClose(hWaveFile,0);
+		return FAILURE;			// Early return  **
+	}
+
+	// Pop upstairs so we can then get down to data chunk
+	if (mmioAscend(hWaveFile, &child, 0)!=MMSYSERR_NOERROR )
+	{
+		ErrorLogger::Write(L"Couldn't ascend to data chunk of ");
+		ErrorLogger::Writeln(filename);
+
+		mmioClose(hWaveFile,0);
+		return FAILURE;			// Early return  **
+	}
+
+	// Now drop into data chunk
+	child.ckid=mmioFOURCC('d','a','t','a');
+
+	if (mmioDescend(hWaveFile, &child,&parent, MMIO_FINDCHUNK)!=MMSYSERR_NOERROR)
+	{
+		ErrorLogger::Write(L"Couldn't find data section in wave file ");
+		ErrorLogger::Writeln(filename);
+
+		mmioClose(hWaveFile,0);			// Error - close the wave file
+		return FAILURE;			// Early return  **
+	}
+
+	// *************************************************************
+	// Now that the info from the file has been stored, it is possible to
+	// Create a sound buffer ready to hold the data, so it back to directX
+
+	LPDIRECTSOUNDBUFFER lpSoundBuffer;
+	if(NewBuffer(formatdesc, child.cksize, DSBCAPS_CTRLDEFAULT, lpSoundBuffer) == FAILURE)
+	{
+		mmioClose(hWaveFile,0);
+		return FAILURE;			// Early return  **
+	}
+	buffer = m_NextBuffer++;
+	m_BufferList[buffer] = lpSoundBuffer;
+
+	// ************************************************************
+	// The file is open, the buffer is created. Now to read all the data in.
+
+	// Load data into a buffer
+	std::vector<unsigned char> tempBuffer(child.cksize);
+	mmioRead(hWaveFile, (char*)tempBuffer.data(), child.cksize);
+
+	// Close the file
+	mmioClose(hWaveFile,0);
+
+	if(FillBuffer(lpSoundBuffer, tempBuffer.data(), child.cksize) == FAILURE)
+	{
+		ReleaseBuffer(buffer);
+		return FAILURE;			// Early return  **
+	}
+
+	return SUCCESS;
+}	// LoadWav
+
+// *******************************************************************
+
+ErrorType DSoundBackend::CreateBuffer(int channels, int samplesPerSec, int bitsPerSample,
+	const unsigned char samples[], size_t size, int& buffer)
+{
+	WAVEFORMATEX formatdesc;
+	memset(&formatdesc,0,sizeof(formatdesc));
+	formatdesc.wFormatTag = WAVE_FORMAT_PCM;
+	formatdesc.nChannels = WORD(channels);
+	formatdesc.nSamplesPerSec = samplesPerSec;
+	formatdesc.wBitsPerSample = WORD(bitsPerSample);
+	formatdesc.nBlockAlign = formatdesc.nChannels * formatdesc.wBitsPerSample / 8;
+	formatdesc.nAvgBytesPerSec = formatdesc.nSamplesPerSec * formatdesc.nBlockAlign;
+
+	LPDIRECTSOUNDBUFFER lpSoundBuffer;
+	if(NewBuffer(formatdesc, DWORD(size), DSBCAPS_CTRLDEFAULT, lpSoundBuffer) == FAILURE)
+	{
+		return FAILURE;
+	}
+	buffer = m_NextBuffer++;
+	m_BufferList[buffer] = lpSoundBuffer;
+
+	if(FillBuffer(lpSoundBuffer, samples, DWORD(size)) == FAILURE)
+	{
+		ReleaseBuffer(buffer);
+		return FAILURE;
+	}
+	return SUCCESS;
+}	// CreateBuffer
+
+// *******************************************************************
+
+ErrorType DSoundBackend::DuplicateBuffer(int buffer, int& copy)
+{
+	LPDIRECTSOUNDBUFFER lpOriginal = FindBuffer(buffer);
+	if(!lpOriginal)
+	{
+		return FAILURE;
+	}
+
+	LPDIRECTSOUNDBUFFER lpCopy = nullptr;
+	HRESULT err = lpds->DuplicateSoundBuffer(lpOriginal, &lpCopy);
+	if(FAILED(err))
+	{
+		ErrorLogger::Writeln(L"Could not duplicate a sound buffer.");
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+
+	copy = m_NextBuffer++;
+	m_BufferList[copy] = lpCopy;
+	return SUCCESS;
+}	// DuplicateBuffer
+
+// *******************************************************************
+
+void DSoundBackend::ReleaseBuffer(int buffer)
+{
+	std::map<int, LPDIRECTSOUNDBUFFER>::iterator it = m_BufferList.find(buffer);
+	if(it != m_BufferList.end())
+	{
+		it->second->Stop();
+		it->second->Release();
+		m_BufferList.erase(it);
+	}
+}
+
+// *************************************************************
+// Playing
+// *************************************************************
+
+ErrorType DSoundBackend::Play(int buffer, bool looping)
+{
+	LPDIRECTSOUNDBUFFER lpSoundBuffer = FindBuffer(buffer);
+	if(!lpSoundBuffer)
+	{
+		return FAILURE;
+	}
+
+	// The first two numbers in the Play() function
+	// are always zero. The third controls whether to loop,
+	// or just play once.
+	HRESULT err = lpSoundBuffer->Play(0,0, looping ? DSBPLAY_LOOPING : 0);
+	if (FAILED(err))
+	{
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType DSoundBackend::Stop(int buffer)
+{
+	LPDIRECTSOUNDBUFFER lpSoundBuffer = FindBuffer(buffer);
+	if(!lpSoundBuffer)
+	{
+		return FAILURE;
+	}
+
+	HRESULT err = lpSoundBuffer->Stop();
+	if (FAILED(err))
+	{
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType DSoundBackend::Rewind(int buffer)
+{
+	LPDIRECTSOUNDBUFFER lpSoundBuffer = FindBuffer(buffer);
+	if(!lpSoundBuffer || FAILED(lpSoundBuffer->SetCurrentPosition(0)))
+	{
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+bool DSoundBackend::IsPlaying(int buffer) const
+{
+	std::map<int, LPDIRECTSOUNDBUFFER>::const_iterator it = m_BufferList.find(buffer);
+	if(it == m_BufferList.end())
+	{
+		return false;
+	}
+
+	DWORD status = 0;
+	if(FAILED(it->second->GetStatus(&status)))
+	{
+		return false;
+	}
+	return (status & DSBSTATUS_PLAYING) != 0;
+}
+
+// *******************************************************************
+
+ErrorType DSoundBackend::SetVolume(int buffer, int volume)
+{
+	LPDIRECTSOUNDBUFFER lpSoundBuffer = FindBuffer(buffer);
+	if(!lpSoundBuffer)
+	{
+		return FAILURE;
+	}
+
+	HRESULT err = lpSoundBuffer->SetVolume(volume);
+	if (FAILED(err))
+	{
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType DSoundBackend::SetPan(int buffer, int pan)
+{
+	LPDIRECTSOUNDBUFFER lpSoundBuffer = FindBuffer(buffer);
+	if(!lpSoundBuffer)
+	{
+		return FAILURE;
+	}
+
+	HRESULT err = lpSoundBuffer->SetPan(pan);
+	if (FAILED(err))
+	{
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType DSoundBackend::SetFrequency(int buffer, int frequency)
+{
+	LPDIRECTSOUNDBUFFER lpSoundBuffer = FindBuffer(buffer);
+	if(!lpSoundBuffer)
+	{
+		return FAILURE;
+	}
+
+	HRESULT err = lpSoundBuffer->SetFrequency(frequency);
+	if (FAILED(err))
+	{
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+// *************************************************************
+// Streams
+// *************************************************************
+
+ErrorType DSoundBackend::CreateStream(WavStream* pSource, int& stream)
+{
+	WAVEFORMATEX formatdesc;
+	memset(&formatdesc,0,sizeof(formatdesc));
+	formatdesc.wFormatTag = WAVE_FORMAT_PCM;
+	formatdesc.nChannels = WORD(pSource->GetChannels());
+	formatdesc.nSamplesPerSec = pSource->GetSamplesPerSec();
+	formatdesc.wBitsPerSample = WORD(pSource->GetBitsPerSample());
+	formatdesc.nBlockAlign = formatdesc.nChannels * formatdesc.wBitsPerSample / 8;
+	formatdesc.nAvgBytesPerSec = formatdesc.nSamplesPerSec * formatdesc.nBlockAlign;
+
+	DSoundStream newStream;
+	newStream.m_pSource = pSource;
+	newStream.m_HalfSize = formatdesc.nAvgBytesPerSec * STREAMHALFMS / 1000;
+	newStream.m_HalfSize -= newStream.m_HalfSize % formatdesc.nBlockAlign;
+	newStream.m_NextHalf = 0;
+	newStream.m_Playing = false;
+	newStream.m_Draining = false;
+
+	// GETCURRENTPOSITION2 gives the play cursor exactly, so the right half is refilled
+	if(NewBuffer(formatdesc, newStream.m_HalfSize * 2, DSBCAPS_CTRLDEFAULT | DSBCAPS_GETCURRENTPOSITION2,
+		newStream.lpSoundBuffer) == FAILURE)
+	{
+		delete pSource;
+		return FAILURE;
+	}
+
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	stream = m_NextBuffer++;
+	m_StreamList[stream] = newStream;
+	return SUCCESS;
+}	// CreateStream
+
+// *******************************************************************
+
+void DSoundBackend::ReleaseStream(int stream)
+{
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	std::map<int, DSoundStream>::iterator it = m_StreamList.find(stream);
+	if(it != m_StreamList.end())
+	{
+		it->second.lpSoundBuffer->Stop();
+		it->second.lpSoundBuffer->Release();
+		delete it->second.m_pSource;
+		m_StreamList.erase(it);
+	}
+}
+
+// *******************************************************************
+
+bool DSoundBackend::FillHalf(DSoundStream& stream, int half)
+{
+	UCHAR *tempPtr1;
+	UCHAR *tempPtr2;
+	DWORD length1;
+	DWORD length2;
+	if(FAILED(stream.lpSoundBuffer->Lock(half * stream.m_HalfSize, stream.m_HalfSize, (void**) &tempPtr1,
+		&length1, (void**) &tempPtr2, &length2, 0)))
+	{
+		return false;
+	}
+
+	// Read straight into the buffer, then pad with silence - 128 for 8-bit samples, else 0
+	size_t read = stream.m_pSource->Read(tempPtr1, length1);
+	memset(tempPtr1 + read, stream.m_pSource->GetBitsPerSample() == 8 ? 128 : 0, length1 - read);
+
+	stream.lpSoundBuffer->Unlock(tempPtr1, length1, tempPtr2, length2);
+	return read > 0;
+}	// FillHalf
+
+// *******************************************************************
+
+ErrorType DSoundBackend::PlayStream(int stream, bool looping)
+{
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	std::map<int, DSoundStream>::iterator it = m_StreamList.find(stream);
+	if(it == m_StreamList.end())
+	{
+		ErrorLogger::Writeln(L"Stream not created.");
+		return FAILURE;
+	}
+	DSoundStream& theStream = it->second;
+
+	theStream.lpSoundBuffer->Stop();
+	theStream.m_pSource->SetLooping(looping);
+	theStream.m_pSource->Rewind();
+
+	// Fill both halves before starting. A sound shorter than one half drains straight away.
+	FillHalf(theStream, 0);
+	theStream.m_Draining = !FillHalf(theStream, 1);
+	theStream.m_NextHalf = 0;
+
+	// The buffer always loops - the source decides whether the music does
+	theStream.lpSoundBuffer->SetCurrentPosition(0);
+	HRESULT err = theStream.lpSoundBuffer->Play(0, 0, DSBPLAY_LOOPING);
+	if (FAILED(err))
+	{
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		theStream.m_Playing = false;
+		return FAILURE;
+	}
+	theStream.m_Playing = true;
+	return SUCCESS;
+}	// PlayStream
+
+// *******************************************************************
+
+ErrorType DSoundBackend::StopStream(int stream)
+{
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	std::map<int, DSoundStream>::iterator it = m_StreamList.find(stream);
+	if(it == m_StreamList.end())
+	{
+		ErrorLogger::Writeln(L"Stream not created.");
+		return FAILURE;
+	}
+	it->second.lpSoundBuffer->Stop();
+	it->second.m_Playing = false;
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType DSoundBackend::SetStreamVolume(int stream, int volume)
+{
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	std::map<int, DSoundStream>::iterator it = m_StreamList.find(stream);
+	if(it == m_StreamList.end())
+	{
+		ErrorLogger::Writeln(L"Stream not created.");
+		return FAILURE;
+	}
+
+	HRESULT err = it->second.lpSoundBuffer->SetVolume(volume);
+	if (FAILED(err))
+	{
+		ErrorLogger::Writeln(ERRORSTRING(err));
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+bool DSoundBackend::IsStreamPlaying(int stream)
+{
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	std::map<int, DSoundStream>::iterator it = m_StreamList.find(stream);
+	return it != m_StreamList.end() && it->second.m_Playing;
+}
+
+// *******************************************************************
+
+// Runs on the audio thread - must not write to the log
+void DSoundBackend::UpdateStreams()
+{
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	for(std::pair<const int, DSoundStream>& item : m_StreamList)
+	{
+		DSoundStream& theStream = item.second;
+		if(!theStream.m_Playing)
+			continue;
+
+		DWORD playCursor, writeCursor;
+		if(FAILED(theStream.lpSoundBuffer->GetCurrentPosition(&playCursor, &writeCursor)))
+			continue;
+
+		// Still playing the half that would be refilled
+		int playingHalf = (playCursor < theStream.m_HalfSize) ? 0 : 1;
+		if(playingHalf == theStream.m_NextHalf)
+			continue;
+
+		if(!FillHalf(theStream, theStream.m_NextHalf))
+		{
+			// The half now playing was the last with any samples in it, and it has finished
+			if(theStream.m_Draining)
+			{
+				theStream.lpSoundBuffer->Stop();
+				theStream.m_Playing = false;
+				continue;
+			}
+			theStream.m_Draining = true;
+		}
+		theStream.m_NextHalf ^= 1;
+	}
+}	// UpdateStreams
+
+// *******************************************************************
+
+ErrorType DSoundBackend::Render(int /*numFrames*/)
+{
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+unsigned long long DSoundBackend::GetMixChecksum() const
+{
+	return 0;
+}
+
+#endif
@@ -0,0 +1,98 @@
+//Created by 16007006
+//DirectSound 8 implementation of SoundBackend
+//Holds the DirectSound object and the sound buffers that used to live directly in
+//MySoundEngine. DirectSound mixes in real time, so Render does nothing. Windows only.
+//A stream is a looping buffer split in two halves - while one half plays, UpdateStreams
+//refills the other from the WavStream.
+
+#pragma once
+
+#ifdef _WIN32
+
+#pragma comment(lib, "dsound.lib")
+#pragma comment(lib, "winmm.lib")
+#include <dsound.h>
+#include <map>
+#include <mutex>
+#include "SoundBackend.h"
+
+class DSoundBackend : public SoundBackend
+{
+private:
+	HWND m_Hwnd;											// The handle to the main window
+	IDirectSound8* lpds;
+	std::map<int, LPDIRECTSOUNDBUFFER> m_BufferList;		// Sound buffers, by handle
+	int m_NextBuffer;										// Handle of the next buffer or stream to be created
+
+	// Length of each half of a stream's buffer
+	static const int STREAMHALFMS = 250;
+
+	struct DSoundStream
+	{
+		LPDIRECTSOUNDBUFFER lpSoundBuffer;		// Both halves
+		WavStream* m_pSource;					// Owned by the stream
+		DWORD m_HalfSize;						// In bytes
+		int m_NextHalf;							// The half to refill once the other one is playing
+		bool m_Playing;
+		bool m_Draining;						// The source has run out. Stops when the last samples have played.
+	};
+	std::map<int, DSoundStream> m_StreamList;	// Streams, by handle
+	std::mutex m_StreamLock;					// Guards m_StreamList between the main thread and the audio thread
+
+	// Returns the buffer with this handle, or nullptr with a message in the log file
+	LPDIRECTSOUNDBUFFER FindBuffer(int buffer) const;
+
+	// Postcondition:	A buffer has been created for the format
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	ErrorType NewBuffer(const WAVEFORMATEX& format, DWORD size, DWORD flags, LPDIRECTSOUNDBUFFER& lpSoundBuffer);
+
+	// Postcondition:	The samples have been copied into the buffer
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	static ErrorType FillBuffer(LPDIRECTSOUNDBUFFER lpSoundBuffer, const unsigned char samples[], DWORD size);
+
+	// Postcondition:	One half of the stream's buffer has been refilled from its source,
+	//					and padded with silence if the source has run out.
+	// Returns:			true if any samples were read from the source
+	static bool FillHalf(DSoundStream& stream, int half);
+
+public:
+	// Parameters:
+	//		hwnd	The handle of the main window
+	DSoundBackend(HWND hwnd);
+
+	// Releases every buffer and stream, then DirectSound
+	~DSoundBackend();
+
+	ErrorType Start() override;
+	ErrorType LoadWav(const wchar_t filename[], int& buffer) override;
+	ErrorType CreateBuffer(int channels, int samplesPerSec, int bitsPerSample,
+		const unsigned char samples[], size_t size, int& buffer) override;
+
+	// Uses DuplicateSoundBuffer, so the copy shares the original's memory
+	ErrorType DuplicateBuffer(int buffer, int& copy) override;
+	void ReleaseBuffer(int buffer) override;
+	ErrorType Play(int buffer, bool looping) override;
+	ErrorType Stop(int buffer) override;
+	ErrorType Rewind(int buffer) override;
+	bool IsPlaying(int buffer) const override;
+	ErrorType SetVolume(int buffer, int volume) override;
+	ErrorType SetPan(int buffer, int pan) override;
+	ErrorType SetFrequency(int buffer, int frequency) override;
+	ErrorType CreateStream(WavStream* pSource, int& stream) override;
+	void ReleaseStream(int stream) override;
+	ErrorType PlayStream(int stream, bool looping) override;
+	ErrorType StopStream(int stream) override;
+	ErrorType SetStreamVolume(int stream, int volume) override;
+	bool IsStreamPlaying(int stream) override;
+
+	// Refills the half of each stream's buffer that has just finished playing
+	void UpdateStreams() override;
+
+	// DirectSound mixes by itself, so this does nothing
+	ErrorType Render(int numFrames) override;
+
+	// The output cannot be read back, so this is always zero
+	unsigned long long GetMixChecksum() const override;
+};
+
+#endif
@@ -0,0 +1,107 @@
+//Created by 16007006
+//The interface between MyDrawEngine and whatever actually puts pixels on the screen
+//MyDrawEngine does the camera transforms, queueing and bookkeeping. A backend only
+//sees screen-space sprites and vertices, so the engine can run on Direct3D 9 or
+//on the headless software rasterizer.
+
+#pragma once
+
+#include "errortype.h"
+
+// Vertex used for points, lines and filled shapes, in screen space.
+// Laid out to match the Direct3D 9 format D3DFVF_XYZRHW|D3DFVF_DIFFUSE, so the
+// D3D9 backend can copy it straight into a vertex buffer.
+struct DrawVertex
+{
+	float x, y, z, rhw;
+	unsigned int colour;
+};
+
+// The kinds of primitive MyDrawEngine submits. Everything is drawn as a list,
+// so consecutive calls can be joined together.
+enum DrawPrimitiveType{DRAW_POINTLIST, DRAW_LINELIST, DRAW_TRIANGLELIST};
+
+// Where a loaded picture is stored. Pictures are packed into shared textures
+// (atlas pages), so several pictures can have the same texture.
+struct DrawRegion
+{
+	int texture;                        // Texture handle - the sort key for sprites
+	int left, top;                      // Top left corner of the picture in the texture, in texels
+	int width, height;                  // Size of the picture, in texels
+};
+
+// A sprite ready to be drawn, in screen space.
+// A texel (u,v) of the picture, counted from its top left corner, lands on the screen at
+//   x = u*m11 + v*m21 + dx
+//   y = u*m12 + v*m22 + dy
+struct DrawSprite
+{
+	DrawRegion source;                  // The picture to draw. Its texture is the sort key.
+	float m11, m12, m21, m22;           // Scale and rotation
+	float dx, dy;                       // Translation
+	unsigned int colour;                // Colour modulation - carries the transparency
+};
+
+// Abstract drawing backend. One instance is owned by MyDrawEngine.
+class DrawBackend
+{
+public:
+	virtual ~DrawBackend() {}
+
+	// Postcondition:	The backend is ready to draw to a back buffer of the given size.
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	virtual ErrorType Start(int width, int height, bool fullScreen) = 0;
+
+	// Postcondition:	The back buffer has been recreated at the given size and mode.
+	//					Texture and font handles stay valid.
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	virtual ErrorType Reset(int width, int height, bool fullScreen) = 0;
+
+	// Sets width and height to the resolution the backend would like to use by default
+	virtual void GetNativeResolution(int& width, int& height) const = 0;
+
+	// Postcondition:	The back buffer is cleared to black.
+	virtual ErrorType Clear() = 0;
+
+	// Postcondition:	The finished back buffer has been shown and a new one started.
+	virtual ErrorType Present() = 0;
+
+	// Postcondition:	width and height are set to the size of the image in the file.
+	//					The image itself is not loaded.
+	// Returns:			SUCCESS, or FAILURE if the file could not be read
+	virtual ErrorType GetPictureSize(const wchar_t filename[], int& width, int& height) = 0;
+
+	// Postcondition:	The image file has been loaded into a texture atlas page. picture is
+	//					set to a handle greater than zero, and region to where it was put.
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	virtual ErrorType LoadPicture(const wchar_t filename[], int& picture, DrawRegion& region) = 0;
+
+	// Postcondition:	The picture has been copied into a texture atlas page from memory.
+	//					pixels are width*height ARGB values, row by row from the top, with
+	//					transparency already applied. picture and region are set as for LoadPicture.
+	virtual ErrorType LoadPictureData(const unsigned int pixels[], int width, int height, int& picture, DrawRegion& region) = 0;
+
+	// Postcondition:	The picture has been released. The handle is no longer valid.
+	//					Its page is released once no pictures on it are left.
+	virtual void ReleasePicture(int picture) = 0;
+
+	// Precondition:	The sprites are sorted by texture
+	// Postcondition:	The sprites have been drawn in order, alpha blended.
+	virtual ErrorType DrawSprites(const DrawSprite sprites[], unsigned int numSprites) = 0;
+
+	// Precondition:	numVertices is a whole number of primitives of the given type
+	// Postcondition:	The primitives have been drawn in order. If blend is true they are
+	//					alpha blended using the alpha in each colour, otherwise alpha is ignored.
+	//					drawCalls has been increased by the number of calls the backend needed.
+	virtual ErrorType DrawPrimitives(DrawPrimitiveType type, bool blend, const DrawVertex vertices[], unsigned int numVertices, int& drawCalls) = 0;
+
+	// Postcondition:	A font has been created and font is set to its handle.
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	virtual ErrorType LoadFont(const wchar_t fontName[], int height, bool bold, bool italic, int& font) = 0;
+
+	// Postcondition:	The text has been written with its top left corner at x,y.
+	virtual ErrorType WriteText(int font, int x, int y, const wchar_t text[], unsigned int colour) = 0;
+
+	// Returns a checksum of the last frame presented, or zero if the backend cannot read its frames back
+	virtual unsigned long long GetFrameChecksum() const = 0;
+};
@@ -1,3 +1,7 @@
+// Modified by 16007006
+// Builds without Windows, for the headless software renderer
+// Writes are locked, so the sound engine's audio thread can log too
+
 // Errorlogger.cpp
 // Shell engine version 2020
 // Chris Rook
@@ -5,16 +9,25 @@
 
 #include "errorlogger.h"
 #include <math.h>
+#include <mutex>
 
 const wchar_t ErrorLogger::Filename[]=L"error.log";
 ErrorLogger ErrorLogger::instance;
 int ErrorLogger::LineCount=0;
 
+// Held for a whole Writeln, so lines from different threads are not mixed up.
+// Recursive, as Writeln calls Write.
+static std::recursive_mutex LogLock;
+
 
 ErrorLogger::ErrorLogger()
 {
 #ifdef LOGGING
+#ifdef _WIN32
 	file.open(Filename);
+#else
+	file.open("error.log");		// Only MSVC can open a file from a wide string
+#endif
 #endif
 }
 
@@ -30,6 +43,7 @@ ErrorLogger::~ErrorLogger()
 // Will not write if LineCount < MAXLINES
 void ErrorLogger::Writeln(const wchar_t text[])
 {
+	std::lock_guard<std::recursive_mutex> lock(LogLock);
 	Write(text);
 	Write(L"\n");
 }
@@ -38,14 +52,19 @@ void ErrorLogger::Writeln(const wchar_t text[])
 // Will not write if LineCount < MAXLINES
 void ErrorLogger::Write(const wchar_t text[])
 {
+	std::lock_guard<std::recursive_mutex> lock(LogLock);
 #ifdef LOGGING
 	if(LineCount<MAXLINES)
 	{
+#ifdef _WIN32
 		OutputDebugString(text);
+#endif
 		instance.file << text;
 		if(++LineCount == MAXLINES)
 		{
+#ifdef _WIN32
 			OutputDebugString(L"\nErrorLogger limit reached. Who taught you to progam?");
+#endif
 			instance.file << L"\nErrorLogger limit reached. Who taught you to progam?";
 			instance.file.flush();
 		}
@@ -61,6 +80,7 @@ void ErrorLogger::Write(const wchar_t text[])
 // Will not write if LineCount < MAXLINES
 void ErrorLogger::Writeln(double num)
 {
+	std::lock_guard<std::recursive_mutex> lock(LogLock);
 	Write(num);
 	Write(L"\n");
 }
@@ -71,7 +91,7 @@ void ErrorLogger::Write(double num)
 {
 #ifdef LOGGING
 	wchar_t buffer[32];
-	swprintf_s( buffer,32, L"%.8g", num );
+	swprintf( buffer,32, L"%.8g", num );
 	Write(buffer);
 #endif
 }
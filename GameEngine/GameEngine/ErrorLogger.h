@@ -1,3 +1,6 @@
+// Modified by 16007006
+// Builds without Windows, for the headless software renderer
+
 // Errorlogger.h
 // Shell engine version 2020
 // Chris Rook
@@ -7,7 +10,9 @@
 #pragma once
 
 #include <fstream>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 //using namespace std;
 
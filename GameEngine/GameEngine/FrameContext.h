@@ -0,0 +1,15 @@
+//Created by 16007006
+//Per-frame information computed once by Game::Update and passed down to every component
+//Replaces each component timing the frame itself, so every object in a frame sees the same values.
+//Also carries the keyboard snapshot, so no component samples the keyboard itself.
+
+#pragma once
+#include "InputSnapshot.h"
+
+struct FrameContext
+{
+	float frameTime;          //Seconds simulated by this update - the fixed step, or the whole frame if the step is not fixed
+	double gameTime;          //Seconds of game time simulated since StartOfGame
+	unsigned int frameNumber; //Updates since StartOfGame, starting at 1 for the first
+	InputSnapshot input;      //Keys for this update. New presses are only seen by the first update after them.
+};
@@ -4,22 +4,28 @@
 
 #include "GameObject.h"
 #include "Shapes.h"
+#include "ErrorLogger.h"
 //#include <iostream>
 
 GameObject::GameObject(ObjectManager* pObjectManager = nullptr)
 {
 	this->active = false;
 	this->pObjectManager = pObjectManager;		
+	this->pRenderComponent = nullptr;
+	this->pCollisionComponent = nullptr;
+	this->numComponents = 0;
+	this->pTransforms = nullptr;
 }
 
 GameObject::~GameObject()
 {
-	//Destroy all connected components & flush list
-	for (Component* &pComponent : pComponentList)
+	//Destroy all connected components & flush array
+	for (int i = 0; i < numComponents; i++)
 	{
-		delete pComponent;
-		pComponent = nullptr;
+		delete pComponents[i];
+		pComponents[i] = nullptr;
 	}
+	numComponents = 0;
 }
 
 void GameObject::Initialise(RenderComponent* pRenderComponent, CollisionComponent* pCollisionComponent, Vector2D position, Vector2D velocity)
@@ -31,17 +37,18 @@ void GameObject::Initialise(RenderComponent* pRenderComponent, CollisionComponen
 	this->AddComponent(pCollisionComponent);
 	
 	//Initialise variables
-	this->position = position;	
-	this->velocity = velocity;	
-	this->angle    = velocity.angle();
+	this->SetPosition(position);
+	this->SetVelocity(velocity);
+	this->SetAngle(velocity.angle());
+	this->SnapTransform();
 	this->active   = true;
 }
 
-void GameObject::Update()
+void GameObject::Update(const FrameContext& frame)
 {
-	for (Component* pComponent : pComponentList)
+	for (int i = 0; i < numComponents; i++)
 	{
-		pComponent->Update();
+		pComponents[i]->Update(frame);
 	}
 }
 
@@ -52,7 +59,18 @@ bool GameObject::isActive()
 
 void GameObject::AddComponent(Component* newComponent)
 {
-	this->pComponentList.push_back(newComponent);
+	if (numComponents >= MAXCOMPONENTS)
+	{
+		ErrorLogger::Writeln(L"GameObject::AddComponent - too many components. Component discarded.");
+		delete newComponent;
+		return;
+	}
+	this->pComponents[numComponents++] = newComponent;
+}
+
+int GameObject::GetComponentCount() const
+{
+	return numComponents;
 }
 
 RenderComponent* GameObject::GetRender()
@@ -68,4 +86,59 @@ CollisionComponent* GameObject::GetCollision()
 ObjectManager* GameObject::GetOM()
 {
 	return this->pObjectManager;
+}
+
+SlotHandle GameObject::GetHandle()
+{
+	return this->handle;
+}
+
+Vector2D GameObject::GetPosition() const
+{
+	return Vector2D(pTransforms->GetX(handle.index), pTransforms->GetY(handle.index));
+}
+
+void GameObject::SetPosition(const Vector2D& position)
+{
+	pTransforms->SetPosition(handle.index, position.XValue, position.YValue);
+}
+
+Vector2D GameObject::GetVelocity() const
+{
+	return Vector2D(pTransforms->GetVelocityX(handle.index), pTransforms->GetVelocityY(handle.index));
+}
+
+void GameObject::SetVelocity(const Vector2D& velocity)
+{
+	pTransforms->SetVelocity(handle.index, velocity.XValue, velocity.YValue);
+}
+
+float GameObject::GetAngle() const
+{
+	return pTransforms->GetAngle(handle.index);
+}
+
+void GameObject::SetAngle(float angle)
+{
+	pTransforms->SetAngle(handle.index, angle);
+}
+
+float GameObject::GetAngularVelocity() const
+{
+	return pTransforms->GetAngularVelocity(handle.index);
+}
+
+void GameObject::SetAngularVelocity(float angularVelocity)
+{
+	pTransforms->SetAngularVelocity(handle.index, angularVelocity);
+}
+
+void GameObject::SetSimulated(bool simulated)
+{
+	pTransforms->SetSimulated(handle.index, simulated);
+}
+
+void GameObject::SnapTransform()
+{
+	pTransforms->SnapPrevious(handle.index);
 }
\ No newline at end of file
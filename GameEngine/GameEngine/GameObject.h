@@ -5,7 +5,8 @@
 #pragma once
 #include "myinputs.h"
 #include "components.h"
-#include <list>
+#include "SlotMap.h"
+#include "TransformTable.h"
 #include <string>
 
 //Forward declare - only referenced, never used.
@@ -13,6 +14,7 @@ class ObjectManager;
 
 class GameObject
 {
+	friend class ObjectManager; //Sets the handle when the GO is created
 private:
 	//Components
 	// Render and Collission are core components which need specific access permissions
@@ -21,24 +23,39 @@ private:
 	CollisionComponent* pCollisionComponent;
 	RenderComponent*    pRenderComponent;
 	ObjectManager*      pObjectManager;
+	SlotHandle          handle;         //Identifies this GO within its ObjectManager
+	TransformTable*     pTransforms;    //Holds this GO's position, velocity and angle, in row handle.index
 protected:	
-	std::list<Component*> pComponentList;
+	static const int MAXCOMPONENTS = 8;     //Most components any GO needs is 5
+	Component* pComponents[MAXCOMPONENTS];  //Attached components, updated in the order they were added
+	int numComponents;                      //Number of entries used in pComponents
 public:
 	//Variables	
 	bool     active;       //Is GO currently on screen
-	Vector2D position;     //Position of GO
-	float    angle;        //Angle of GO - Default is 0
-	Vector2D velocity;     //Velocity of GO - could be moved to PhysicsComponent
 	
 	//Functions
 	GameObject(ObjectManager* pObjectManager);// Constructor	
 	~GameObject();// Destructor
 	void Initialise(RenderComponent* pRenderComponent, CollisionComponent* pCollisionComponent, 
 					Vector2D position, Vector2D velocity);
-	void Update();
+	void Update(const FrameContext& frame); //Updates every component with the same frame information
 	bool isActive(); //Indicates if object is active. Keeps actual variable protected.
-	void AddComponent(Component* newComponent); //Adds component pointer to pComponentList
+	void AddComponent(Component* newComponent); //Adds component pointer to pComponents
+	int GetComponentCount() const; //Returns the number of components attached, which Update calls in turn
 	CollisionComponent* GetCollision(); //Returns a pointer to the GO's collision component
 	RenderComponent*    GetRender();    //Returns a pointer to the GO's render component
 	ObjectManager*      GetOM();        //Returns a pointer to the ObjectManager which created this GO
+	SlotHandle          GetHandle();    //Returns a handle which can be checked with ObjectManager::Find, even after the GO is deleted
+
+	//Transform - stored in the ObjectManager's TransformTable rather than in the GO
+	Vector2D GetPosition() const;
+	void     SetPosition(const Vector2D& position);
+	Vector2D GetVelocity() const;                       //Velocity in units per second
+	void     SetVelocity(const Vector2D& velocity);
+	float    GetAngle() const;                          //Angle of GO - Default is the angle of its initial velocity
+	void     SetAngle(float angle);
+	float    GetAngularVelocity() const;                //Rotation in radians per second
+	void     SetAngularVelocity(float angularVelocity);
+	void     SetSimulated(bool simulated);              //Whether the physics pass moves this GO
+	void     SnapTransform();                           //Stops the GO being drawn sliding from its last transform, e.g. after a teleport
 };
\ No newline at end of file
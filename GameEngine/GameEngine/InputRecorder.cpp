@@ -0,0 +1,199 @@
+//Created by 16007006
+//Runs of changed bytes with fewer than RUNGAP unchanged bytes between them are written
+//as one run, as a run's header costs more than the bytes it would skip.
+
+#include "InputRecorder.h"
+#include "AssetDecoder.h"
+#include "errorlogger.h"
+#include <cstring>
+
+// Unchanged bytes that end a run
+static const size_t RUNGAP = 4;
+
+static void WriteValue(std::ofstream& file, const void* pValue, size_t size)
+{
+	file.write((const char*)pValue, std::streamsize(size));
+}
+
+static bool ReadValue(std::ifstream& file, void* pValue, size_t size)
+{
+	return bool(file.read((char*)pValue, std::streamsize(size)));
+}
+
+// *******************************************************************
+
+InputRecorder::InputRecorder()
+{
+	m_Mode = IDLE;
+	m_Frames = 0;
+}
+
+// *******************************************************************
+
+InputRecorder::~InputRecorder()
+{
+	Stop();
+}
+
+// *******************************************************************
+
+ErrorType InputRecorder::StartRecording(const wchar_t filename[], size_t stateSize, unsigned int seed)
+{
+	Stop();
+	if(stateSize == 0 || stateSize > 0xFFFF)
+	{
+		ErrorLogger::Writeln(L"Input state is the wrong size to record");
+		return FAILURE;
+	}
+
+	m_Output.open(AssetDecoder::NarrowName(filename).c_str(), std::ios::binary | std::ios::trunc);
+	if(!m_Output)
+	{
+		ErrorLogger::Write(L"Could not create input recording ");
+		ErrorLogger::Writeln(filename);
+		return FAILURE;
+	}
+
+	unsigned int header[4] = {0, VERSION, (unsigned int)stateSize, seed};
+	memcpy(&header[0], "CMIR", 4);
+	WriteValue(m_Output, header, sizeof(header));
+
+	m_Previous.assign(stateSize, 0);
+	m_Frames = 0;
+	m_Mode = RECORDING;
+	return SUCCESS;
+}	// StartRecording
+
+// *******************************************************************
+
+ErrorType InputRecorder::StartReplay(const wchar_t filename[], size_t stateSize, unsigned int& seed)
+{
+	Stop();
+	m_Input.open(AssetDecoder::NarrowName(filename).c_str(), std::ios::binary);
+	if(!m_Input)
+	{
+		ErrorLogger::Write(L"Could not open input recording ");
+		ErrorLogger::Writeln(filename);
+		return FAILURE;
+	}
+
+	unsigned int header[4];
+	if(!ReadValue(m_Input, header, sizeof(header)) || memcmp(&header[0], "CMIR", 4) != 0 || header[1] != VERSION)
+	{
+		ErrorLogger::Write(L"Not an input recording: ");
+		ErrorLogger::Writeln(filename);
+		m_Input.close();
+		return FAILURE;
+	}
+	if(header[2] != stateSize)
+	{
+		ErrorLogger::Write(L"Input recording is from a different build: ");
+		ErrorLogger::Writeln(filename);
+		m_Input.close();
+		return FAILURE;
+	}
+
+	seed = header[3];
+	m_Previous.assign(stateSize, 0);
+	m_Frames = 0;
+	m_Mode = REPLAYING;
+	return SUCCESS;
+}	// StartReplay
+
+// *******************************************************************
+
+void InputRecorder::Stop()
+{
+	if(m_Output.is_open())
+		m_Output.close();
+	if(m_Input.is_open())
+		m_Input.close();
+	m_Mode = IDLE;
+}
+
+// *******************************************************************
+
+InputRecorder::Mode InputRecorder::GetMode() const
+{
+	return m_Mode;
+}
+
+// *******************************************************************
+
+unsigned int InputRecorder::GetFrameCount() const
+{
+	return m_Frames;
+}
+
+// *******************************************************************
+
+ErrorType InputRecorder::WriteFrame(const unsigned char state[], double frameTime)
+{
+	if(m_Mode != RECORDING)
+	{
+		return FAILURE;
+	}
+
+	// Encode the runs first, as their number comes before them
+	m_Encoded.clear();
+	unsigned short numRuns = 0;
+
+	const size_t size = m_Previous.size();
+	size_t i = 0;
+	while(i < size)
+	{
+		if(state[i] == m_Previous[i])
+		{
+			i++;
+			continue;
+		}
+		size_t end = i + 1;				// One past the last changed byte
+		for(size_t j = end; j < size && j < end + RUNGAP; j++)
+		{
+			if(state[j] != m_Previous[j])
+				end = j + 1;
+		}
+		unsigned short run[2] = {(unsigned short)i, (unsigned short)(end - i)};
+		m_Encoded.insert(m_Encoded.end(), (const unsigned char*)run, (const unsigned char*)run + sizeof(run));
+		m_Encoded.insert(m_Encoded.end(), state + i, state + end);
+		numRuns++;
+		i = end;
+	}
+
+	WriteValue(m_Output, &frameTime, sizeof(frameTime));
+	WriteValue(m_Output, &numRuns, sizeof(numRuns));
+	WriteValue(m_Output, m_Encoded.data(), m_Encoded.size());
+
+	memcpy(m_Previous.data(), state, size);
+	m_Frames++;
+	return SUCCESS;
+}	// WriteFrame
+
+// *******************************************************************
+
+ErrorType InputRecorder::ReadFrame(unsigned char state[], double& frameTime)
+{
+	if(m_Mode != REPLAYING)
+	{
+		return FAILURE;
+	}
+
+	unsigned short numRuns;
+	bool ok = ReadValue(m_Input, &frameTime, sizeof(frameTime)) && ReadValue(m_Input, &numRuns, sizeof(numRuns));
+	for(unsigned short r = 0; ok && r < numRuns; r++)
+	{
+		unsigned short run[2];
+		ok = ReadValue(m_Input, run, sizeof(run)) && run[0] < m_Previous.size() && size_t(run[0]) + run[1] <= m_Previous.size()
+			&& ReadValue(m_Input, &m_Previous[run[0]], run[1]);
+	}
+	if(!ok)
+	{
+		// The end, or a file cut short - either way there is nothing more to replay
+		Stop();
+		return FAILURE;
+	}
+
+	memcpy(state, m_Previous.data(), m_Previous.size());
+	m_Frames++;
+	return SUCCESS;
+}	// ReadFrame
@@ -0,0 +1,70 @@
+//Created by 16007006
+//Writes the input state of every frame to a file, and reads it back to replay the session.
+//Each frame is stored as the runs of bytes that changed since the frame before, so a frame
+//where nothing changed costs a few bytes. The state is just bytes to the recorder - MyInputs
+//decides what is in it. Does not depend on Windows.
+//
+//File layout, all little-endian:
+//	Header:	"CMIR", version, state size, random seed		(4 x 4 bytes)
+//	Frames:	frame time (8-byte double), number of runs (2 bytes),
+//			then for each run: offset (2), length (2), the bytes
+
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <vector>
+#include "errortype.h"
+
+class InputRecorder
+{
+public:
+	enum Mode{IDLE, RECORDING, REPLAYING};
+
+private:
+	static const unsigned int VERSION = 1;
+
+	Mode m_Mode;
+	std::ofstream m_Output;					// While recording
+	std::ifstream m_Input;					// While replaying
+	std::vector<unsigned char> m_Previous;	// The last frame written or read. Runs are against this.
+	std::vector<unsigned char> m_Encoded;	// The runs of the frame being written
+	unsigned int m_Frames;					// Frames written or read since the start
+
+public:
+	InputRecorder();
+
+	// Stops, finishing the file if recording
+	~InputRecorder();
+
+	// Postcondition:	The file has been created, and frames will be written to it.
+	//					The first frame is compared against a state of all zeros.
+	// Parameters:
+	//		stateSize	Bytes in every frame's state. At most 65535.
+	//		seed		Stored in the header, for the replay to seed its random numbers with
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	ErrorType StartRecording(const wchar_t filename[], size_t stateSize, unsigned int seed);
+
+	// Postcondition:	The recording has been opened, and ReadFrame will give its frames in order.
+	//					seed is set to the seed it was recorded with.
+	// Returns:			SUCCESS, or FAILURE with a message in the log file if the file cannot
+	//					be read or was recorded with a different state size.
+	ErrorType StartReplay(const wchar_t filename[], size_t stateSize, unsigned int& seed);
+
+	// Postcondition:	Recording or replaying has ended and the file is closed
+	void Stop();
+
+	Mode GetMode() const;
+
+	// Returns the number of frames written or read since the start
+	unsigned int GetFrameCount() const;
+
+	// Postcondition:	The state, of the size given to StartRecording, has been added to the file
+	// Returns:			SUCCESS, or FAILURE if not recording
+	ErrorType WriteFrame(const unsigned char state[], double frameTime);
+
+	// Postcondition:	state and frameTime are set to the next frame of the recording.
+	//					At the end of the recording, the replay stops.
+	// Returns:			SUCCESS, or FAILURE if not replaying or there are no frames left
+	ErrorType ReadFrame(unsigned char state[], double& frameTime);
+};
@@ -0,0 +1,80 @@
+//Created by 16007006
+//The keyboard as it was at the start of a frame, packed into bitsets
+//Taken once per frame by MyInputs::SampleKeyboard and handed read-only to everything that
+//reads input, so every reader in a frame sees the same keys, and a new press is only new
+//for the one frame it happened in. Key numbers are DirectInput's DIK_ codes.
+
+#pragma once
+
+struct InputSnapshot
+{
+	static const int NUMKEYS = 256;
+	static const int NUMWORDS = NUMKEYS / 64;
+
+	unsigned long long down[NUMWORDS];     //Keys held down at the sample
+	unsigned long long pressed[NUMWORDS];  //Keys down at the sample but up at the one before
+	unsigned long long released[NUMWORDS]; //Keys up at the sample but down at the one before
+
+	InputSnapshot()
+	{
+		for (int i = 0; i < NUMWORDS; i++)
+		{
+			down[i] = pressed[i] = released[i] = 0;
+		}
+	}
+
+	//Packs the keyboard state from DirectInput (0x80 set for each key down), and finds
+	//  the edges against the previous snapshot
+	void Set(const char keystate[NUMKEYS], const InputSnapshot& previous)
+	{
+		for (int i = 0; i < NUMWORDS; i++)
+		{
+			unsigned long long bits = 0;
+			for (int bit = 0; bit < 64; bit++)
+			{
+				bits |= (unsigned long long)((keystate[i * 64 + bit] & 0x80) != 0) << bit;
+			}
+			down[i] = bits;
+			pressed[i] = bits & ~previous.down[i];
+			released[i] = ~bits & previous.down[i];
+		}
+	}
+
+	//Adds edges from an earlier snapshot which nothing has acted on yet
+	void MergeEdges(const InputSnapshot& earlier)
+	{
+		for (int i = 0; i < NUMWORDS; i++)
+		{
+			pressed[i] |= earlier.pressed[i];
+			released[i] |= earlier.released[i];
+		}
+	}
+
+	//Forgets the edges, for the second and later simulation steps of a frame,
+	//  so a press is acted on once however many steps the frame runs
+	void ClearEdges()
+	{
+		for (int i = 0; i < NUMWORDS; i++)
+		{
+			pressed[i] = released[i] = 0;
+		}
+	}
+
+	//True if the key was down when the snapshot was taken
+	bool KeyPressed(unsigned char key) const
+	{
+		return ((down[key >> 6] >> (key & 63)) & 1) != 0;
+	}
+
+	//True if the key went down since the previous snapshot
+	bool NewKeyPressed(unsigned char key) const
+	{
+		return ((pressed[key >> 6] >> (key & 63)) & 1) != 0;
+	}
+
+	//True if the key came up since the previous snapshot
+	bool NewKeyReleased(unsigned char key) const
+	{
+		return ((released[key >> 6] >> (key & 63)) & 1) != 0;
+	}
+};
@@ -0,0 +1,714 @@
+//Created by 16007006
+//Software mixer implementation of SoundBackend
+//Each buffer is mixed a run at a time. A buffer playing at the output rate is added
+//straight from its samples; otherwise a run is first resampled into a scratch block.
+//The loops that add into the mix and convert it to 16-bit have no branches, so the
+//compiler can vectorise the part that touches every sample of every voice.
+
+#include "MixerBackend.h"
+#include "WavStream.h"
+#include "errorlogger.h"
+#include "AssetDecoder.h"
+#include <cmath>
+#include <algorithm>
+
+static const unsigned long long ONEFRAME = 1ULL << 32;		// One frame, in 32.32 fixed point
+
+// *************************************************************
+// Mixing loops
+// *************************************************************
+
+// Adds count samples, scaled by gain, into the mix
+static void MixSpan(float* __restrict mix, const float* __restrict source, int count, float gain)
+{
+	for(int i=0;i<count;i++)
+	{
+		mix[i] += source[i] * gain;
+	}
+}
+
+// Clips the mix and converts it to interleaved 16-bit stereo
+static void ConvertSpan(short* __restrict output, const float* __restrict left, const float* __restrict right, int count)
+{
+	for(int i=0;i<count;i++)
+	{
+		// Written as selects rather than std::min/max, which the compiler keeps as branches
+		float l = left[i] * 32767.0f;
+		float r = right[i] * 32767.0f;
+		l = l < -32767.0f ? -32767.0f : l;
+		l = l > 32767.0f ? 32767.0f : l;
+		r = r < -32767.0f ? -32767.0f : r;
+		r = r > 32767.0f ? 32767.0f : r;
+		output[i*2] = short(int(l));
+		output[i*2+1] = short(int(r));
+	}
+}
+
+// Fetches count samples starting at position and stepping by step (both 32.32),
+// blending between neighbouring samples
+static void ResampleSpan(float* __restrict output, const float* __restrict source, size_t length,
+	unsigned long long position, unsigned long long step, int count)
+{
+	const float fraction = 1.0f / float(ONEFRAME);
+	for(int i=0;i<count;i++)
+	{
+		size_t frame = size_t(position >> 32);
+		size_t next = std::min(frame + 1, length - 1);
+		float t = float(position & (ONEFRAME - 1)) * fraction;
+		output[i] = source[frame] + (source[next] - source[frame]) * t;
+		position += step;
+	}
+}
+
+// Converts numFrames frames of 8-bit unsigned or 16-bit signed little-endian PCM to float.
+// right is only written for stereo.
+static void ConvertSamples(const unsigned char samples[], size_t numFrames, int channels, int bitsPerSample,
+	float left[], float right[])
+{
+	size_t bytesPerFrame = size_t(channels * bitsPerSample / 8);
+	for(size_t i=0;i<numFrames;i++)
+	{
+		const unsigned char* pFrame = samples + i * bytesPerFrame;
+		for(int c=0;c<channels;c++)
+		{
+			float value;
+			if(bitsPerSample == 8)
+				value = (float(pFrame[c]) - 128.0f) / 128.0f;
+			else
+				value = float(short(pFrame[c*2] | (pFrame[c*2+1] << 8))) / 32768.0f;
+			(c == 0 ? left : right)[i] = value;
+		}
+	}
+}
+
+// *******************************************************************
+
+// Returns DirectSound's hundredths of a decibel as a gain
+static float DecibelsToGain(int hundredths)
+{
+	return float(pow(10.0, hundredths / 2000.0));
+}
+
+// *************************************************************
+// Construction
+// *************************************************************
+
+MixerBackend::MixerBackend(int samplesPerSec, const wchar_t outputFile[])
+{
+	m_SamplesPerSec = samplesPerSec;
+	if(outputFile)
+		m_OutputFilename = outputFile;
+
+	// Handles start at 1, so zero is never valid
+	m_NextBuffer = 1;
+
+	m_MixLeft.resize(BLOCKSIZE);
+	m_MixRight.resize(BLOCKSIZE);
+	m_Resampled.resize(BLOCKSIZE);
+	m_Output.resize(BLOCKSIZE * 2);
+
+	m_FramesMixed = 0;
+	m_MixChecksum = 14695981039346656037ULL;
+}		// Constructor
+
+// *******************************************************************
+
+MixerBackend::~MixerBackend()
+{
+	for(std::pair<const int, MixerStream>& item : m_StreamList)
+	{
+		delete item.second.m_pSource;
+	}
+
+	// Go back and fill in the sizes
+	if(m_OutputFile.is_open())
+	{
+		m_OutputFile.seekp(0);
+		WriteHeader();
+	}
+}		// Destructor
+
+// *******************************************************************
+
+ErrorType MixerBackend::Start()
+{
+	if(m_SamplesPerSec <= 0)
+	{
+		ErrorLogger::Writeln(L"Mixer output rate must be above zero");
+		return FAILURE;
+	}
+
+	if(!m_OutputFilename.empty())
+	{
+		m_OutputFile.open(AssetDecoder::NarrowName(m_OutputFilename.c_str()).c_str(), std::ios::binary | std::ios::trunc);
+		if(!m_OutputFile)
+		{
+			ErrorLogger::Write(L"Could not open mixer output file ");
+			ErrorLogger::Writeln(m_OutputFilename.c_str());
+			return FAILURE;
+		}
+		WriteHeader();
+	}
+	return SUCCESS;
+}		// Start
+
+// *******************************************************************
+
+void MixerBackend::WriteHeader()
+{
+	unsigned int dataSize = (unsigned int)(m_FramesMixed * 4);
+
+	// Little-endian, like the rest of the file
+	auto write32 = [this](unsigned int value)
+	{
+		char bytes[4] = {char(value), char(value >> 8), char(value >> 16), char(value >> 24)};
+		m_OutputFile.write(bytes, 4);
+	};
+	auto write16 = [this](unsigned int value)
+	{
+		char bytes[2] = {char(value), char(value >> 8)};
+		m_OutputFile.write(bytes, 2);
+	};
+
+	m_OutputFile.write("RIFF", 4);
+	write32(36 + dataSize);
+	m_OutputFile.write("WAVEfmt ", 8);
+	write32(16);							// Size of the format chunk
+	write16(1);								// PCM
+	write16(2);								// Stereo
+	write32(m_SamplesPerSec);
+	write32(m_SamplesPerSec * 4);			// Bytes per second
+	write16(4);								// Bytes per frame
+	write16(16);							// Bits per sample
+	m_OutputFile.write("data", 4);
+	write32(dataSize);
+}	// WriteHeader
+
+// *************************************************************
+// Buffers
+// *************************************************************
+
+MixerBackend::MixerBuffer* MixerBackend::FindBuffer(int buffer)
+{
+	std::map<int, MixerBuffer>::iterator it = m_BufferList.find(buffer);
+	if(it == m_BufferList.end())
+	{
+		ErrorLogger::Writeln(L"Sound buffer not created.");
+		return nullptr;
+	}
+	return &it->second;
+}
+
+// *******************************************************************
+
+void MixerBackend::UpdateGains(MixerBuffer& buffer)
+{
+	// Panning turns down the other side only, as DirectSound does
+	float volume = DecibelsToGain(buffer.m_Volume);
+	buffer.m_LeftGain = volume * (buffer.m_Pan > 0 ? DecibelsToGain(-buffer.m_Pan) : 1.0f);
+	buffer.m_RightGain = volume * (buffer.m_Pan < 0 ? DecibelsToGain(buffer.m_Pan) : 1.0f);
+}
+
+// *******************************************************************
+
+ErrorType MixerBackend::LoadWav(const wchar_t filename[], int& buffer)
+{
+	int channels, samplesPerSec, bitsPerSample;
+	std::vector<unsigned char> samples;
+	if(AssetDecoder::DecodeWAV(filename, channels, samplesPerSec, bitsPerSample, samples) == FAILURE)
+	{
+		ErrorLogger::Write(L"Failed to open sound file ");
+		ErrorLogger::Writeln(filename);
+		return FAILURE;
+	}
+	return CreateBuffer(channels, samplesPerSec, bitsPerSample, samples.data(), samples.size(), buffer);
+}	// LoadWav
+
+// *******************************************************************
+
+ErrorType MixerBackend::CreateBuffer(int channels, int samplesPerSec, int bitsPerSample,
+	const unsigned char samples[], size_t size, int& buffer)
+{
+	if((channels != 1 && channels != 2) || (bitsPerSample != 8 && bitsPerSample != 16) || samplesPerSec <= 0)
+	{
+		ErrorLogger::Writeln(L"The mixer only plays 8 or 16-bit mono or stereo sounds");
+		return FAILURE;
+	}
+
+	size_t bytesPerFrame = size_t(channels * bitsPerSample / 8);
+	size_t length = size / bytesPerFrame;
+	if(length == 0)
+	{
+		ErrorLogger::Writeln(L"Could not create a sound buffer with no samples");
+		return FAILURE;
+	}
+
+	std::shared_ptr<SampleData> pData(new SampleData);
+	pData->m_SamplesPerSec = samplesPerSec;
+	pData->m_Left.resize(length);
+	if(channels == 2)
+		pData->m_Right.resize(length);
+
+	ConvertSamples(samples, length, channels, bitsPerSample, pData->m_Left.data(), pData->m_Right.data());
+
+	MixerBuffer newBuffer;
+	newBuffer.m_pSamples = pData;
+	newBuffer.m_Position = 0;
+	newBuffer.m_Playing = false;
+	newBuffer.m_Looping = false;
+	newBuffer.m_Volume = 0;
+	newBuffer.m_Pan = 0;
+	newBuffer.m_Frequency = 0;
+	UpdateGains(newBuffer);
+
+	buffer = m_NextBuffer++;
+	m_BufferList[buffer] = newBuffer;
+	return SUCCESS;
+}	// CreateBuffer
+
+// *******************************************************************
+
+ErrorType MixerBackend::DuplicateBuffer(int buffer, int& copy)
+{
+	MixerBuffer* pOriginal = FindBuffer(buffer);
+	if(!pOriginal)
+	{
+		return FAILURE;
+	}
+
+	// Same samples and settings, but stopped at the start
+	MixerBuffer newBuffer = *pOriginal;
+	newBuffer.m_Position = 0;
+	newBuffer.m_Playing = false;
+	newBuffer.m_Looping = false;
+
+	copy = m_NextBuffer++;
+	m_BufferList[copy] = newBuffer;
+	return SUCCESS;
+}	// DuplicateBuffer
+
+// *******************************************************************
+
+void MixerBackend::ReleaseBuffer(int buffer)
+{
+	m_BufferList.erase(buffer);
+}
+
+// *************************************************************
+// Playing
+// *************************************************************
+
+ErrorType MixerBackend::Play(int buffer, bool looping)
+{
+	MixerBuffer* pBuffer = FindBuffer(buffer);
+	if(!pBuffer)
+	{
+		return FAILURE;
+	}
+	pBuffer->m_Playing = true;
+	pBuffer->m_Looping = looping;
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType MixerBackend::Stop(int buffer)
+{
+	MixerBuffer* pBuffer = FindBuffer(buffer);
+	if(!pBuffer)
+	{
+		return FAILURE;
+	}
+	pBuffer->m_Playing = false;
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType MixerBackend::Rewind(int buffer)
+{
+	MixerBuffer* pBuffer = FindBuffer(buffer);
+	if(!pBuffer)
+	{
+		return FAILURE;
+	}
+	pBuffer->m_Position = 0;
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+bool MixerBackend::IsPlaying(int buffer) const
+{
+	std::map<int, MixerBuffer>::const_iterator it = m_BufferList.find(buffer);
+	return it != m_BufferList.end() && it->second.m_Playing;
+}
+
+// *******************************************************************
+
+ErrorType MixerBackend::SetVolume(int buffer, int volume)
+{
+	MixerBuffer* pBuffer = FindBuffer(buffer);
+	if(!pBuffer)
+	{
+		return FAILURE;
+	}
+	pBuffer->m_Volume = std::min(std::max(volume, -10000), 0);
+	UpdateGains(*pBuffer);
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType MixerBackend::SetPan(int buffer, int pan)
+{
+	MixerBuffer* pBuffer = FindBuffer(buffer);
+	if(!pBuffer)
+	{
+		return FAILURE;
+	}
+	pBuffer->m_Pan = std::min(std::max(pan, -10000), 10000);
+	UpdateGains(*pBuffer);
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType MixerBackend::SetFrequency(int buffer, int frequency)
+{
+	MixerBuffer* pBuffer = FindBuffer(buffer);
+	if(!pBuffer)
+	{
+		return FAILURE;
+	}
+	pBuffer->m_Frequency = std::max(frequency, 0);
+	return SUCCESS;
+}
+
+// *************************************************************
+// Streams
+// *************************************************************
+
+ErrorType MixerBackend::CreateStream(WavStream* pSource, int& stream)
+{
+	int channels = pSource->GetChannels();
+	int bitsPerSample = pSource->GetBitsPerSample();
+	if((channels != 1 && channels != 2) || (bitsPerSample != 8 && bitsPerSample != 16) || pSource->GetSamplesPerSec() <= 0)
+	{
+		ErrorLogger::Writeln(L"The mixer only plays 8 or 16-bit mono or stereo sounds");
+		delete pSource;
+		return FAILURE;
+	}
+
+	MixerStream newStream;
+	newStream.m_pSource = pSource;
+	newStream.m_Left.resize(STREAMFRAMES);
+	if(channels == 2)
+		newStream.m_Right.resize(STREAMFRAMES);
+	newStream.m_Read = 0;
+	newStream.m_Count = 0;
+	newStream.m_Fraction = 0;
+	newStream.m_Playing = false;
+	newStream.m_Gain = 1.0f;
+
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	stream = m_NextBuffer++;
+	m_StreamList[stream] = std::move(newStream);
+	return SUCCESS;
+}	// CreateStream
+
+// *******************************************************************
+
+void MixerBackend::ReleaseStream(int stream)
+{
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	std::map<int, MixerStream>::iterator it = m_StreamList.find(stream);
+	if(it != m_StreamList.end())
+	{
+		delete it->second.m_pSource;
+		m_StreamList.erase(it);
+	}
+}
+
+// *******************************************************************
+
+ErrorType MixerBackend::PlayStream(int stream, bool looping)
+{
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	std::map<int, MixerStream>::iterator it = m_StreamList.find(stream);
+	if(it == m_StreamList.end())
+	{
+		ErrorLogger::Writeln(L"Stream not created.");
+		return FAILURE;
+	}
+	MixerStream& theStream = it->second;
+
+	theStream.m_pSource->SetLooping(looping);
+	theStream.m_pSource->Rewind();
+	theStream.m_Read = 0;
+	theStream.m_Count = 0;
+	theStream.m_Fraction = 0;
+	theStream.m_Playing = true;
+	RefillStream(theStream);
+	return SUCCESS;
+}	// PlayStream
+
+// *******************************************************************
+
+ErrorType MixerBackend::StopStream(int stream)
+{
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	std::map<int, MixerStream>::iterator it = m_StreamList.find(stream);
+	if(it == m_StreamList.end())
+	{
+		ErrorLogger::Writeln(L"Stream not created.");
+		return FAILURE;
+	}
+	it->second.m_Playing = false;
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType MixerBackend::SetStreamVolume(int stream, int volume)
+{
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	std::map<int, MixerStream>::iterator it = m_StreamList.find(stream);
+	if(it == m_StreamList.end())
+	{
+		ErrorLogger::Writeln(L"Stream not created.");
+		return FAILURE;
+	}
+	it->second.m_Gain = DecibelsToGain(std::min(std::max(volume, -10000), 0));
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+bool MixerBackend::IsStreamPlaying(int stream)
+{
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	std::map<int, MixerStream>::iterator it = m_StreamList.find(stream);
+	return it != m_StreamList.end() && it->second.m_Playing;
+}
+
+// *******************************************************************
+
+// Runs on the audio thread - must not write to the log
+void MixerBackend::UpdateStreams()
+{
+	std::lock_guard<std::mutex> lock(m_StreamLock);
+	for(std::pair<const int, MixerStream>& item : m_StreamList)
+	{
+		if(item.second.m_Playing)
+			RefillStream(item.second);
+	}
+}
+
+// *******************************************************************
+
+void MixerBackend::RefillStream(MixerStream& stream)
+{
+	const int channels = stream.m_pSource->GetChannels();
+	const int bitsPerSample = stream.m_pSource->GetBitsPerSample();
+	const size_t bytesPerFrame = size_t(channels * bitsPerSample / 8);
+	const bool stereo = !stream.m_Right.empty();
+
+	// Fill the free part of the ring, in up to two pieces either side of the wrap
+	while(stream.m_Count < STREAMFRAMES)
+	{
+		size_t write = (stream.m_Read + stream.m_Count) % STREAMFRAMES;
+		size_t wanted = std::min(STREAMFRAMES - stream.m_Count, STREAMFRAMES - write);
+
+		m_StreamBytes.resize(wanted * bytesPerFrame);
+		size_t frames = stream.m_pSource->Read(m_StreamBytes.data(), m_StreamBytes.size()) / bytesPerFrame;
+		if(frames == 0)
+			break;
+
+		ConvertSamples(m_StreamBytes.data(), frames, channels, bitsPerSample,
+			&stream.m_Left[write], stereo ? &stream.m_Right[write] : nullptr);
+		stream.m_Count += frames;
+	}
+}	// RefillStream
+
+// *******************************************************************
+
+void MixerBackend::MixStream(MixerStream& stream, int numFrames)
+{
+	const bool stereo = !stream.m_Right.empty();
+	unsigned long long step = ((unsigned long long)stream.m_pSource->GetSamplesPerSec() << 32) / (unsigned long long)m_SamplesPerSec;
+	if(step == 0)
+		step = 1;
+
+	int done = 0;
+	while(done < numFrames)
+	{
+		if(stream.m_Count == 0)
+		{
+			// Run dry. Only stop if there is nothing more to come.
+			if(stream.m_pSource->IsFinished())
+			{
+				stream.m_Playing = false;
+				stream.m_Fraction = 0;
+			}
+			return;
+		}
+
+		// As many output frames as the ring can supply, and the frames they need
+		unsigned long long available = (unsigned long long)stream.m_Count << 32;
+		int count = int(std::min<unsigned long long>(numFrames - done, (available - stream.m_Fraction - 1) / step + 1));
+		unsigned long long end = stream.m_Fraction + step * (unsigned long long)count;
+		size_t needed = std::min(size_t((end - step) >> 32) + 2, stream.m_Count);
+
+		// Take the run out of the ring so it can be resampled in one piece
+		m_StreamLeft.resize(needed);
+		m_StreamRight.resize(needed);
+		for(size_t i=0;i<needed;i++)
+		{
+			size_t frame = (stream.m_Read + i) % STREAMFRAMES;
+			m_StreamLeft[i] = stream.m_Left[frame];
+			m_StreamRight[i] = stereo ? stream.m_Right[frame] : m_StreamLeft[i];
+		}
+
+		ResampleSpan(m_Resampled.data(), m_StreamLeft.data(), needed, stream.m_Fraction, step, count);
+		MixSpan(&m_MixLeft[done], m_Resampled.data(), count, stream.m_Gain);
+		ResampleSpan(m_Resampled.data(), m_StreamRight.data(), needed, stream.m_Fraction, step, count);
+		MixSpan(&m_MixRight[done], m_Resampled.data(), count, stream.m_Gain);
+
+		size_t consumed = size_t(end >> 32);
+		stream.m_Read = (stream.m_Read + consumed) % STREAMFRAMES;
+		stream.m_Count -= consumed;
+		stream.m_Fraction = end & (ONEFRAME - 1);
+		done += count;
+	}
+}	// MixStream
+
+// *************************************************************
+// Mixing
+// *************************************************************
+
+void MixerBackend::MixBuffer(MixerBuffer& buffer, int numFrames)
+{
+	const SampleData& data = *buffer.m_pSamples;
+	const size_t length = data.m_Left.size();
+	const bool stereo = !data.m_Right.empty();
+
+	int rate = buffer.m_Frequency ? buffer.m_Frequency : data.m_SamplesPerSec;
+	unsigned long long step = ((unsigned long long)rate << 32) / (unsigned long long)m_SamplesPerSec;
+	if(step == 0)
+		step = 1;
+
+	int done = 0;
+	while(done < numFrames && buffer.m_Playing)
+	{
+		size_t frame = size_t(buffer.m_Position >> 32);
+		if(frame >= length)
+		{
+			if(buffer.m_Looping)
+			{
+				buffer.m_Position -= (unsigned long long)length << 32;
+				continue;
+			}
+			// Finished - stops and goes back to the start, as DirectSound does
+			buffer.m_Playing = false;
+			buffer.m_Position = 0;
+			break;
+		}
+
+		// Run up to the end of the block, or the end of the samples
+		unsigned long long remaining = ((unsigned long long)length << 32) - buffer.m_Position;
+		int count = int(std::min<unsigned long long>(numFrames - done, (remaining + step - 1) / step));
+
+		if(step == ONEFRAME)
+		{
+			// Playing at the output rate, so mix straight from the samples
+			const float* pLeft = &data.m_Left[frame];
+			const float* pRight = stereo ? &data.m_Right[frame] : pLeft;
+			MixSpan(&m_MixLeft[done], pLeft, count, buffer.m_LeftGain);
+			MixSpan(&m_MixRight[done], pRight, count, buffer.m_RightGain);
+		}
+		else
+		{
+			ResampleSpan(m_Resampled.data(), data.m_Left.data(), length, buffer.m_Position, step, count);
+			MixSpan(&m_MixLeft[done], m_Resampled.data(), count, buffer.m_LeftGain);
+			if(stereo)
+				ResampleSpan(m_Resampled.data(), data.m_Right.data(), length, buffer.m_Position, step, count);
+			MixSpan(&m_MixRight[done], m_Resampled.data(), count, buffer.m_RightGain);
+		}
+
+		buffer.m_Position += step * (unsigned long long)count;
+		done += count;
+	}
+}	// MixBuffer
+
+// *******************************************************************
+
+ErrorType MixerBackend::Render(int numFrames)
+{
+	while(numFrames > 0)
+	{
+		int block = std::min(numFrames, int(BLOCKSIZE));
+
+		std::fill(m_MixLeft.begin(), m_MixLeft.begin() + block, 0.0f);
+		std::fill(m_MixRight.begin(), m_MixRight.begin() + block, 0.0f);
+
+		for(std::pair<const int, MixerBuffer>& item : m_BufferList)
+		{
+			if(item.second.m_Playing)
+				MixBuffer(item.second, block);
+		}
+
+		// Top the rings up first, so a slow audio thread cannot change the output
+		{
+			std::lock_guard<std::mutex> lock(m_StreamLock);
+			for(std::pair<const int, MixerStream>& item : m_StreamList)
+			{
+				if(item.second.m_Playing)
+				{
+					RefillStream(item.second);
+					MixStream(item.second, block);
+				}
+			}
+		}
+
+		ConvertSpan(m_Output.data(), m_MixLeft.data(), m_MixRight.data(), block);
+
+		// Samples are little-endian in memory, as in the file
+		const unsigned char* bytes = (const unsigned char*)m_Output.data();
+		for(int i=0;i<block*4;i++)
+		{
+			m_MixChecksum = (m_MixChecksum ^ bytes[i]) * 1099511628211ULL;
+		}
+
+		if(m_OutputFile.is_open())
+		{
+			m_OutputFile.write((const char*)bytes, block*4);
+		}
+
+		m_FramesMixed += block;
+		numFrames -= block;
+	}
+
+	if(m_OutputFile.is_open() && !m_OutputFile)
+	{
+		ErrorLogger::Write(L"Could not write to mixer output file ");
+		ErrorLogger::Writeln(m_OutputFilename.c_str());
+		m_OutputFile.close();
+		return FAILURE;
+	}
+	return SUCCESS;
+}	// Render
+
+// *******************************************************************
+
+unsigned long long MixerBackend::GetMixChecksum() const
+{
+	return m_MixChecksum;
+}
+
+// *******************************************************************
+
+unsigned long long MixerBackend::GetFramesMixed() const
+{
+	return m_FramesMixed;
+}
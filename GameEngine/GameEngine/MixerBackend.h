@@ -0,0 +1,147 @@
+//Created by 16007006
+//Software mixer implementation of SoundBackend
+//Mixes every playing buffer itself, with volume, pan and frequency, into 16-bit stereo.
+//The output goes nowhere, or into a WAV file, and is checksummed - so sound can be
+//played, timed and checked without a sound card, e.g. on the Linux benchmark hosts.
+//Nothing is mixed until Render is called. Does not depend on Windows.
+//Streams keep a short ring of samples, topped up by UpdateStreams and again by Render
+//before it mixes, so the output is the same however the audio thread is scheduled.
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <mutex>
+#include "SoundBackend.h"
+
+class MixerBackend : public SoundBackend
+{
+private:
+	// Frames mixed at a time. Each block is mixed in float, then converted to 16-bit.
+	static const int BLOCKSIZE = 256;
+
+	// The samples of a loaded sound, converted to float (-1 to 1).
+	// Shared by a buffer and its duplicates.
+	struct SampleData
+	{
+		int m_SamplesPerSec;
+		std::vector<float> m_Left;			// Mono sounds only have this channel
+		std::vector<float> m_Right;			// Empty for mono sounds
+	};
+
+	struct MixerBuffer
+	{
+		std::shared_ptr<const SampleData> m_pSamples;
+		unsigned long long m_Position;		// Next frame to play, in 32.32 fixed point
+		bool m_Playing;
+		bool m_Looping;
+		int m_Volume;						// As set, in DirectSound's units
+		int m_Pan;
+		int m_Frequency;					// Zero for the sound's own rate
+		float m_LeftGain;					// Volume and pan combined
+		float m_RightGain;
+	};
+
+	// Frames each stream keeps ready
+	static const int STREAMFRAMES = 8192;
+
+	struct MixerStream
+	{
+		WavStream* m_pSource;				// Owned by the stream
+		std::vector<float> m_Left;			// Ring of STREAMFRAMES frames
+		std::vector<float> m_Right;			// Empty for mono sources
+		size_t m_Read;						// Next frame to play in the ring
+		size_t m_Count;						// Frames in the ring
+		unsigned long long m_Fraction;		// How far past m_Read playback is, in 32.32 fixed point
+		bool m_Playing;
+		float m_Gain;
+	};
+
+	int m_SamplesPerSec;						// Output rate
+	std::map<int, MixerBuffer> m_BufferList;	// Buffers, by handle
+	int m_NextBuffer;							// Handle of the next buffer or stream to be created
+	std::map<int, MixerStream> m_StreamList;	// Streams, by handle
+	std::mutex m_StreamLock;					// Guards m_StreamList and m_StreamBytes between the main and audio threads
+	std::vector<unsigned char> m_StreamBytes;	// Samples read from a source before conversion
+	std::vector<float> m_StreamLeft;			// A run taken out of a ring to be resampled
+	std::vector<float> m_StreamRight;
+
+	std::vector<float> m_MixLeft;				// The block being mixed
+	std::vector<float> m_MixRight;
+	std::vector<float> m_Resampled;				// One channel of a buffer fetched at the output rate
+	std::vector<short> m_Output;				// The block converted to 16-bit, interleaved
+
+	std::wstring m_OutputFilename;				// Empty if the output is thrown away
+	std::ofstream m_OutputFile;
+	unsigned long long m_FramesMixed;			// Since Start
+	unsigned long long m_MixChecksum;			// FNV-1a of every byte of output so far
+
+	// Returns the buffer with this handle, or nullptr with a message in the log file
+	MixerBuffer* FindBuffer(int buffer);
+
+	// Postcondition:	m_LeftGain and m_RightGain match m_Volume and m_Pan
+	static void UpdateGains(MixerBuffer& buffer);
+
+	// Postcondition:	numFrames frames of the buffer have been added into the start of the
+	//					mix block, or fewer if it reached its end and is not looping.
+	void MixBuffer(MixerBuffer& buffer, int numFrames);
+
+	// Postcondition:	The stream's ring has been filled up from its source
+	void RefillStream(MixerStream& stream);
+
+	// Postcondition:	Up to numFrames frames of the stream have been added into the start of
+	//					the mix block, and taken out of its ring. Stops the stream once its
+	//					ring is empty and its source has finished.
+	void MixStream(MixerStream& stream, int numFrames);
+
+	// Postcondition:	The WAV header has been written, with sizes for m_FramesMixed frames
+	void WriteHeader();
+
+public:
+	// Parameters:
+	//		samplesPerSec	The output rate
+	//		outputFile		WAV file to write the mix to, or nullptr to throw it away
+	MixerBackend(int samplesPerSec, const wchar_t outputFile[]);
+
+	// Finishes the WAV file, if there is one, and deletes the streams' sources
+	~MixerBackend();
+
+	ErrorType Start() override;
+
+	// Uses AssetDecoder, so only PCM files are supported
+	ErrorType LoadWav(const wchar_t filename[], int& buffer) override;
+
+	// Only 8 and 16-bit mono or stereo samples are supported
+	ErrorType CreateBuffer(int channels, int samplesPerSec, int bitsPerSample,
+		const unsigned char samples[], size_t size, int& buffer) override;
+
+	// The copy shares the original's converted samples
+	ErrorType DuplicateBuffer(int buffer, int& copy) override;
+	void ReleaseBuffer(int buffer) override;
+	ErrorType Play(int buffer, bool looping) override;
+	ErrorType Stop(int buffer) override;
+	ErrorType Rewind(int buffer) override;
+	bool IsPlaying(int buffer) const override;
+	ErrorType SetVolume(int buffer, int volume) override;
+	ErrorType SetPan(int buffer, int pan) override;
+	ErrorType SetFrequency(int buffer, int frequency) override;
+	ErrorType CreateStream(WavStream* pSource, int& stream) override;
+	void ReleaseStream(int stream) override;
+	ErrorType PlayStream(int stream, bool looping) override;
+	ErrorType StopStream(int stream) override;
+	ErrorType SetStreamVolume(int stream, int volume) override;
+	bool IsStreamPlaying(int stream) override;
+	void UpdateStreams() override;
+
+	// Mixes the frames and writes them to the output
+	ErrorType Render(int numFrames) override;
+
+	// FNV-1a hash of every byte of output mixed since Start
+	unsigned long long GetMixChecksum() const override;
+
+	// Returns the number of frames mixed since Start
+	unsigned long long GetFramesMixed() const;
+};
@@ -6,15 +6,42 @@
 #include <algorithm>
 #include "GameObject.h"
 #include "components.h"
-#include "gamecode.h" 
 
-ObjectManager::ObjectManager()  {}
-ObjectManager::~ObjectManager() {} // Destructor
+ObjectManager::ObjectManager()
+{
+	stats = CollisionStats();
+	broadphaseMode = UNIFORMGRID;
+	updateTime = 0.0;
+	pointsScored = 0.0;
+
+	//The player is destroyed by everything except cows
+	collisionMatrix.SetReaction(LAYER_PLAYER, LAYER_PLAYER, true);
+	collisionMatrix.SetReaction(LAYER_PLAYER, LAYER_ROCK,   true);
+	collisionMatrix.SetReaction(LAYER_PLAYER, LAYER_BULLET, true);
+	//Bullets are destroyed by everything, and score when they hit cows
+	collisionMatrix.SetReaction(LAYER_BULLET, LAYER_PLAYER, true);
+	collisionMatrix.SetReaction(LAYER_BULLET, LAYER_ROCK,   true);
+	collisionMatrix.SetReaction(LAYER_BULLET, LAYER_COW,    true);
+	collisionMatrix.SetReaction(LAYER_BULLET, LAYER_BULLET, true);
+	//Cows are only destroyed by bullets
+	collisionMatrix.SetReaction(LAYER_COW, LAYER_BULLET, true);
+	//Rocks are indestructible, so react to nothing
+}
+ObjectManager::~ObjectManager() {} // Destructor - the pool deletes any remaining objects
 
-//Add new object pointer to the list
-void ObjectManager::AddObject(GameObject* pNewObject)
+//Constructs a new GO in the pool and records its handle
+//  The GO is not moved afterwards, so the pointer can be held until the GO is deleted
+GameObject* ObjectManager::NewObject()
 {
-	this->pObjectList.push_back(pNewObject);
+	SlotHandle handle = objects.Create(this);
+	GameObject* pNewGO = objects.Get(handle);
+	pNewGO->handle = handle;
+
+	//Give the GO a clean row in the transform table
+	transforms.Reserve(handle.index);
+	transforms.Reset(handle.index);
+	pNewGO->pTransforms = &transforms;
+	return pNewGO;
 }
 
 //Object Factory
@@ -23,7 +50,7 @@ void ObjectManager::AddObject(GameObject* pNewObject)
 GameObject* ObjectManager::CreateUFO(Vector2D position)
 {
 	//Create new GO & initialise
-	GameObject* pNewGO = new GameObject(this);
+	GameObject* pNewGO = this->NewObject();
 	pNewGO->Initialise(new RenderComponent(pNewGO, L"ufo.bmp", 1.25f),
 					   new UFOCollisionComponent(pNewGO, 30.0f),
 					   position, Vector2D(0,0));
@@ -33,15 +60,13 @@ GameObject* ObjectManager::CreateUFO(Vector2D position)
 	pNewGO->AddComponent(new PhysicsComponent(pNewGO));       //UFO can move around the screen.
 	pNewGO->AddComponent(new ExpirationComponent(pNewGO));    //UFO expires if off-screen	
 
-	//Add GO reference to ObjectManager's pObjectList
-	this->AddObject(pNewGO);
 	return pNewGO;
 }
 
 GameObject* ObjectManager::CreateRock(Vector2D position, Vector2D velocity, float rotation)
 {
 	//Create new GO & initialise
-	GameObject* pNewGO = new GameObject(this);
+	GameObject* pNewGO = this->NewObject();
 	//Rocks can be assigned 1 of 4 images
 	wchar_t* filename = nullptr;
 	switch ((rand() % 4) + 1)
@@ -69,15 +94,13 @@ GameObject* ObjectManager::CreateRock(Vector2D position, Vector2D velocity, floa
 	pNewGO->AddComponent(new PhysicsComponent(pNewGO, rotation));
 	pNewGO->AddComponent(new ExpirationComponent(pNewGO, true));
 
-	//Add GO reference to ObjectManager's pObjectList
-	this->AddObject(pNewGO);
 	return pNewGO;
 }
 
 GameObject* ObjectManager::CreateCow(Vector2D position, Vector2D velocity, float rotation)
 {
 	//Create new GO & initialise
-	GameObject* pNewGO = new GameObject(this);
+	GameObject* pNewGO = this->NewObject();
 	pNewGO->Initialise(new RenderComponent(pNewGO, L"cow.bmp"), 
 					   new CowCollisionComponent(pNewGO, 35.0f, 20.0f),
 					   position, velocity);
@@ -86,89 +109,362 @@ GameObject* ObjectManager::CreateCow(Vector2D position, Vector2D velocity, float
 	pNewGO->AddComponent(new PhysicsComponent(pNewGO, rotation));
 	pNewGO->AddComponent(new ExpirationComponent(pNewGO, true));
 
-	//Add GO reference to ObjectManager's pObjectList
-	this->AddObject(pNewGO);
 	return pNewGO;
 }
 
 GameObject* ObjectManager::CreateBullet(Vector2D position, Vector2D velocity)
 {
 	//Create new GO & initialise
-	GameObject* pNewGO = new GameObject(this);
+	GameObject* pNewGO = this->NewObject();
+	//Bullets are small and fast enough to jump over a cow in one long step, so test their whole path
+	BulletCollisionComponent* pCollision = new BulletCollisionComponent(pNewGO, 1.0f, 1.0f);
+	pCollision->SetContinuous(true);
 	pNewGO->Initialise(new RenderComponent(pNewGO, L"bullet.bmp", 3.0f), 
-		               new BulletCollisionComponent(pNewGO, 1.0f, 1.0f),
+		               pCollision,
 		               position, velocity);
 
 	//Attach custom components required by Bullets
 	pNewGO->AddComponent(new PhysicsComponent(pNewGO));
 	pNewGO->AddComponent(new ExpirationComponent(pNewGO));
 
-	//Add GO reference to ObjectManager's pObjectList
-	this->AddObject(pNewGO);
 	return pNewGO;
 }
 
-//Orders all objects in list to update
-void ObjectManager::UpdateAll()
+//Runs one simulation step - orders all objects to update, then moves them and checks for collisions
+//  Objects may create more objects (e.g. bullets) while updating. These are added
+//  to the end of the pool, so the size is re-read every pass and they update too.
+void ObjectManager::UpdateAll(const FrameContext& frame)
 {
-	for (GameObject* pObject : pObjectList)
+	transforms.SavePrevious(); //Rendering interpolates from here to the end of the step
+
+	updateTimer.mark();
+	for (int i = 0; i < objects.Size(); i++)
 	{
-		pObject->Update();
+		objects[i].Update(frame);
 	}
+	updateTimer.mark();
+	updateTime = updateTimer.mdFrameTime;
+
+	IntegrateAll(frame.frameTime);
 	CheckAllCollisions();
 }
 
+//Physics pass
+//  Replaces each PhysicsComponent moving its own owner. Every object is integrated
+//  in one loop over the transform table instead.
+void ObjectManager::IntegrateAll(float frameTime)
+{
+	transforms.Integrate(frameTime);
+}
+
+//Draws every object, blended between the last two simulation steps
+//  alpha is how far the current time is past the last step, as a fraction of a step
+void ObjectManager::RenderAll(float alpha)
+{
+	for (int i = 0; i < objects.Size(); i++)
+	{
+		GameObject& object = objects[i];
+		RenderComponent* pRender = object.GetRender();
+		if (pRender)
+		{
+			int row = objects.HandleAt(i).index;
+			pRender->Draw(Vector2D(transforms.GetInterpolatedX(row, alpha), transforms.GetInterpolatedY(row, alpha)),
+			              transforms.GetInterpolatedAngle(row, alpha));
+		}
+	}
+}
+
 //Delete any objects tagged as inactive
+//  Deleting moves the last object into the gap, so walk backwards
+//  to make sure every object is still visited.
 void ObjectManager::DeleteInactive()
 {
-	for (GameObject* &pObject : pObjectList)
+	for (int i = objects.Size() - 1; i >= 0; i--)
 	{
-		if (pObject->isActive() == false)
+		if (objects[i].isActive() == false)
 		{
-			delete pObject;    //Delete actual object
-			pObject = nullptr; //Reset pointer
+			SlotHandle handle = objects.HandleAt(i);
+			transforms.Reset(handle.index); //Stop the physics pass moving the empty slot
+			objects.Destroy(handle);
 		}
 	}
-	auto it = std::remove(pObjectList.begin(), pObjectList.end(), nullptr);
-	pObjectList.erase(it, pObjectList.end());
 }
 
-//Delete all objects in the list, irrespective of their current state.
+//Delete all objects, irrespective of their current state.
 void ObjectManager::DeleteAll()
 {
-	for (GameObject* &pObject : pObjectList)
+	for (int i = 0; i < objects.Size(); i++)
 	{
-		delete pObject;    //Delete actual object
-		pObject = nullptr; //Reset pointer
+		transforms.Reset(objects.HandleAt(i).index);
 	}
-	auto it = std::remove(pObjectList.begin(), pObjectList.end(), nullptr);
-	pObjectList.erase(it, pObjectList.end());
+	objects.Clear();
+}
+
+GameObject* ObjectManager::Find(SlotHandle handle) const
+{
+	return objects.Get(handle);
+}
+
+int ObjectManager::GetObjectCount() const
+{
+	return objects.Size();
 }
 
 //Checks all objects against eachother, detecting 
 //which objects' collision shapes are intersecting
-//Code itself is long-winded/hard to follow, comments attempt to stepthrough each segment
-void ObjectManager::CheckAllCollisions(){
-	std::list<GameObject*>::iterator it1;
-	std::list<GameObject*>::iterator it2;
-	//For each GameObject in the ObjectManager's pObjectList
-	//  Select the next object in the list
-	for (it1 = pObjectList.begin(); it1 != pObjectList.end(); it1++)
+//  The broadphase first finds pairs whose layers interact and whose bounds overlap, so only objects which
+//  care about one another and are close together have their actual shapes tested.
+//  Pairs with a continuous object are swept instead, and their hits are handled after
+//  the other pairs, in the order they happened during the step.
+void ObjectManager::CheckAllCollisions()
+{
+	stats = CollisionStats();
+
+	//Gather the bounds of every object which can collide, in pool order
+	proxies.clear();
+	for (int i = 0; i < objects.Size(); i++)
+	{
+		GameObject* pObject = &objects[i];
+		CollisionComponent* pCollision = pObject->GetCollision();
+		if (pCollision)
+		{
+			//Objects have finished moving for this step, so place each shape once here
+			//and every pair below reads it as it is
+			pCollision->UpdateShape();
+			const Rectangle2D& bounds = pCollision->GetBounds();
+			CollisionLayer layer = pCollision->GetLayer();
+			BroadphaseProxy proxy;
+			proxy.minX = bounds.GetBottomLeft().XValue;
+			proxy.minY = bounds.GetBottomLeft().YValue;
+			proxy.maxX = bounds.GetTopRight().XValue;
+			proxy.maxY = bounds.GetTopRight().YValue;
+			//Stretch the bounds back over the path moved this step. A continuous object is
+			//reported with everything it passed on the way, and with anything that crossed
+			//its path while it moved, since both boxes then cover where they met.
+			int row = objects.HandleAt(i).index;
+			float movedX = transforms.GetX(row) - transforms.GetPreviousX(row);
+			float movedY = transforms.GetY(row) - transforms.GetPreviousY(row);
+			proxy.minX = std::min(proxy.minX, proxy.minX - movedX);
+			proxy.maxX = std::max(proxy.maxX, proxy.maxX - movedX);
+			proxy.minY = std::min(proxy.minY, proxy.minY - movedY);
+			proxy.maxY = std::max(proxy.maxY, proxy.maxY - movedY);
+			proxy.layer = LayerBit(layer);
+			proxy.mask = collisionMatrix.GetMask(layer);
+			proxy.pObject = pObject;
+			proxy.slot = objects.HandleAt(i).index;
+			proxy.pShape = pCollision->GetShape();
+			proxy.continuous = pCollision->IsContinuous();
+			proxies.push_back(proxy);
+		}
+	}
+	stats.objects = (int)proxies.size();
+
+	//Find pairs which may be colliding. These come back in pool order, so collisions
+	//are processed in the same order as testing every pair would.
+	switch (broadphaseMode)
+	{
+	case ALLPAIRS:
+		allPairs.FindPairs(proxies, pairs);
+		break;
+	case SWEEPANDPRUNE:
+		sweepAndPrune.FindPairs(proxies, pairs);
+		stats.sortSwaps = sweepAndPrune.GetSwapCount();
+		break;
+	default:
+		uniformGrid.FindPairs(proxies, pairs);
+		break;
+	}
+	stats.candidatePairs = (int)pairs.size();
+
+	//Test the pairs in chunks spread over the worker pool. Each chunk only
+	//records what it finds - nothing is changed until every chunk is done.
+	int numChunks = ((int)pairs.size() + PAIRSPERCHUNK - 1) / PAIRSPERCHUNK;
+	if ((int)contactBuffers.size() < numChunks)
+	{
+		contactBuffers.resize(numChunks);
+	}
+	narrowphasePool.Run(numChunks, [this](int chunk) { TestChunk(chunk); });
+	stats.pairTests = (int)pairs.size();
+
+	//Collision handlers change objects and the score, so run them on this thread
+	//in pair order, as if the pairs had been tested one after another
+	sweptHits.clear();
+	for (int chunk = 0; chunk < numChunks; chunk++)
+	{
+		stats.sweptTests += contactBuffers[chunk].sweptTests;
+		for (const Contact& contact : contactBuffers[chunk].contacts)
+		{
+			if (contact.swept)
+				sweptHits.push_back(contact); //Kept until every other pair has been handled
+			else
+				ResolvePair(proxies[pairs[contact.pair].first], proxies[pairs[contact.pair].second]);
+		}
+	}
+
+	//Swept hits in the order they happened. Once an object has been destroyed, anything
+	//it would have reached later in the step is ignored, so a bullet stops at the first thing it hits.
+	std::stable_sort(sweptHits.begin(), sweptHits.end(),
+		[](const Contact& a, const Contact& b) { return a.timeOfImpact < b.timeOfImpact; });
+	for (const Contact& hit : sweptHits)
+	{
+		const BroadphaseProxy& first  = proxies[pairs[hit.pair].first];
+		const BroadphaseProxy& second = proxies[pairs[hit.pair].second];
+		if (first.pObject->isActive() && second.pObject->isActive())
+		{
+			ResolvePair(first, second);
+		}
+	}
+}
+
+//Tests one chunk of the candidate pairs, recording the pairs which touch in the chunk's buffer
+//  Pairs with a continuous object are given the swept test instead
+void ObjectManager::TestChunk(int chunk)
+{
+	ContactBuffer& buffer = contactBuffers[chunk];
+	buffer.contacts.clear();
+	int sweptTests = 0;
+
+	int end = std::min((int)pairs.size(), (chunk + 1) * PAIRSPERCHUNK);
+	for (int i = chunk * PAIRSPERCHUNK; i < end; i++)
 	{
-		//Select the object AFTER it1 in the list
-		for (it2 = std::next(it1); it2 != pObjectList.end(); it2++)
+		const BroadphaseProxy& first  = proxies[pairs[i].first];
+		const BroadphaseProxy& second = proxies[pairs[i].second];
+		Contact contact;
+		contact.pair = i;
+		contact.timeOfImpact = 0.0f;
+		contact.swept = false;
+
+		if (first.continuous || second.continuous)
 		{
-			//Make sure both currently selected objects have a valid collision component, otherwise next step will fail
-			if ((*it1)->GetCollision() && (*it1)->GetCollision())
+			sweptTests++;
+			contact.swept = true;
+			bool hits = first.continuous ? SweptIntersects(first.pObject, second.pObject, contact.timeOfImpact)
+			                             : SweptIntersects(second.pObject, first.pObject, contact.timeOfImpact);
+			if (hits)
 			{
-				//If the collisions shapes of the current objects in each list are overlapping
-				if ((*it1)->GetCollision()->GetShape()->Intersects(*((*it2)->GetCollision()->GetShape())))
-				{
-					//Tell both objects' CollisionComponents to process collision, with reference to the opposing object
-					(*it1)->GetCollision()->ProcessCollision(*it2);
-					(*it2)->GetCollision()->ProcessCollision(*it1);
-				}
+				buffer.contacts.push_back(contact);
 			}
 		}
+		//If the collisions shapes of the current objects are overlapping
+		else if (first.pShape->Intersects(*second.pShape))
+		{
+			buffer.contacts.push_back(contact);
+		}
 	}
-}
\ No newline at end of file
+	buffer.sweptTests = sweptTests;
+}
+
+//Tell each object's CollisionComponent which reacts to the other's layer to
+//process collision, with reference to the opposing object
+void ObjectManager::ResolvePair(const BroadphaseProxy& first, const BroadphaseProxy& second)
+{
+	stats.collisions++;
+	if (first.mask & second.layer)
+		first.pObject->GetCollision()->ProcessCollision(second.pObject);
+	if (second.mask & first.layer)
+		second.pObject->GetCollision()->ProcessCollision(first.pObject);
+}
+
+//Swept test - follows the centre of pMover along the path it moved this step relative to
+//pOther, against pOther's shape grown by pMover's half size, with pOther where it ended the step.
+//  Returns true if they hit, with timeOfImpact set to how far through the step the
+//  path first touched (0 to 1). Never misses a hit the test at the end of the step would find.
+bool ObjectManager::SweptIntersects(GameObject* pMover, GameObject* pOther, float& timeOfImpact) const
+{
+	//Both moved in straight lines over the step, so seen from pOther, pMover moved by the
+	//difference. A target moving across the path is met where it is, not where it ends up.
+	int row = pMover->handle.index;
+	int otherRow = pOther->handle.index;
+	Vector2D end = pMover->GetPosition();
+	Vector2D moved(transforms.GetX(row) - transforms.GetPreviousX(row), transforms.GetY(row) - transforms.GetPreviousY(row));
+	Vector2D otherMoved(transforms.GetX(otherRow) - transforms.GetPreviousX(otherRow), transforms.GetY(otherRow) - transforms.GetPreviousY(otherRow));
+	Vector2D start = end - moved + otherMoved;
+	Segment2D path;
+	path.PlaceAt(start, end);
+	float length = path.GetLength();
+
+	const Rectangle2D& moverBounds = pMover->GetCollision()->GetBounds();
+	Vector2D halfSize = (moverBounds.GetTopRight() - moverBounds.GetBottomLeft()) / 2.0f;
+	IShape2D* pShape = pOther->GetCollision()->GetShape();
+
+	if (length > 0.0f)
+	{
+		Vector2D entry = end;
+		bool hits = false;
+		switch (pShape->GetType())
+		{
+		case SHAPE_RECTANGLE:
+		{
+			const Rectangle2D* pRectangle = static_cast<const Rectangle2D*>(pShape);
+			Rectangle2D grown;
+			grown.PlaceAt(pRectangle->GetBottomLeft() - halfSize, pRectangle->GetTopRight() + halfSize);
+			hits = path.Intersects(grown);
+			if (hits)
+				entry = path.FirstIntersection(grown);
+			break;
+		}
+		case SHAPE_CIRCLE:
+		{
+			const Circle2D* pCircle = static_cast<const Circle2D*>(pShape);
+			Circle2D grown(pCircle->GetCentre(), pCircle->GetRadius() + std::max(halfSize.XValue, halfSize.YValue));
+			hits = path.Intersects(grown);
+			if (hits)
+				entry = path.FirstIntersection(grown);
+			break;
+		}
+		default:
+			break; //No swept test for this shape - only the end of the step is tested
+		}
+		if (hits)
+		{
+			timeOfImpact = (entry - start).magnitude() / length;
+			return true;
+		}
+	}
+
+	//Growing a circle by a box's half size misses the box's corners, so check the end as well
+	timeOfImpact = 1.0f;
+	return pMover->GetCollision()->GetShape()->Intersects(*pShape);
+}
+
+const CollisionStats& ObjectManager::GetCollisionStats() const
+{
+	return stats;
+}
+
+double ObjectManager::GetUpdateTime() const
+{
+	return updateTime;
+}
+
+void ObjectManager::SetBroadphase(BroadphaseMode mode)
+{
+	broadphaseMode = mode;
+}
+
+ObjectManager::BroadphaseMode ObjectManager::GetBroadphase() const
+{
+	return broadphaseMode;
+}
+
+void ObjectManager::SetNarrowphaseThreads(int threads)
+{
+	narrowphasePool.SetThreadCount(threads);
+}
+
+int ObjectManager::GetNarrowphaseThreads() const
+{
+	return narrowphasePool.GetThreadCount();
+}
+
+void ObjectManager::AddPoints(double points)
+{
+	pointsScored += points;
+}
+
+double ObjectManager::TakePoints()
+{
+	double points = pointsScored;
+	pointsScored = 0.0;
+	return points;
+}
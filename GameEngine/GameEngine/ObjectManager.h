@@ -4,15 +4,74 @@
 
 #pragma once
 #include "vector2d.h"
-#include <list>
+#include "Broadphase.h"
+#include "SlotMap.h"
+#include "TransformTable.h"
+#include "gametimer.h"
+#include "FrameContext.h"
+#include "CollisionLayers.h"
+#include "WorkerPool.h"
+#include <vector>
 
 class GameObject;
 
+//Counters describing the work done by the last call to CheckAllCollisions
+struct CollisionStats
+{
+	int objects;        //Objects with a collision component
+	int candidatePairs; //Pairs reported by the broadphase
+	int pairTests;      //Calls made to IShape2D::Intersects
+	int collisions;     //Pairs which were actually intersecting
+	int sortSwaps;      //Endpoint swaps made by the sweep and prune sort (zero for other modes)
+	int sweptTests;     //Pairs given the swept test, as one of them is continuous
+};
+
 class ObjectManager
 {
+public:
+	//The broadphase used to find pairs which may be colliding
+	//  ALLPAIRS      - every pair is tested, as the original loop did
+	//  UNIFORMGRID   - only pairs sharing a grid cell are tested
+	//  SWEEPANDPRUNE - only pairs overlapping along a sorted X axis are tested
+	enum BroadphaseMode{ALLPAIRS, UNIFORMGRID, SWEEPANDPRUNE};
 private:
-	std::list<GameObject*> pObjectList; //The list of all GameObjects
-	void AddObject(GameObject* pObject);
+	SlotMap<GameObject> objects;        //Storage for all GameObjects - pointers stay valid until the GO is deleted
+	TransformTable transforms;          //Position, velocity and angle of every GO, indexed by slot
+	GameTimer updateTimer;              //Measures how long the component updates take
+	double updateTime;                  //Seconds spent in the last round of component updates
+	AllPairsBroadphase      allPairs;       //Broadphases - one of these is selected by broadphaseMode
+	UniformGridBroadphase   uniformGrid;
+	SweepAndPruneBroadphase sweepAndPrune;
+	BroadphaseMode broadphaseMode;          //Which broadphase CheckAllCollisions uses
+	CollisionMatrix collisionMatrix;        //Which collision layers react to which
+	std::vector<BroadphaseProxy> proxies; //Collision bounds of each object - kept between frames to avoid reallocation
+	std::vector<BroadphasePair>  pairs;   //Candidate pairs found by the broadphase
+	//A pair found touching by the narrowphase, kept until every pair has been tested
+	struct Contact
+	{
+		int pair;           //Index into pairs
+		float timeOfImpact; //Swept hits: how far through the step the hit happened, from 0 to 1
+		bool swept;         //true if found by the swept test
+	};
+	//Contacts found in one chunk of pairs. Each chunk is tested by one thread and has its own buffer,
+	//  and the buffers are read back in chunk order, so the order is the same however many threads ran.
+	//  Padded rather than alignas, as VS2015's std::allocator does not align the vector's storage past 16 bytes.
+	struct ContactBuffer
+	{
+		std::vector<Contact> contacts;
+		int sweptTests;     //Pairs in the chunk given the swept test
+		char padding[64];   //Keeps the next chunk's buffer a cache line away, so threads filling neighbours do not share one
+	};
+	static const int PAIRSPERCHUNK = 256;  //Pairs tested by each narrowphase task
+	WorkerPool narrowphasePool;            //Threads the pair tests are split across
+	std::vector<ContactBuffer> contactBuffers; //One per chunk - kept between frames to avoid reallocation
+	std::vector<Contact> sweptHits;        //Hits involving continuous objects from the last collision check
+	CollisionStats stats;                 //Work done by the last collision check
+	double pointsScored;                  //Points awarded by collisions, waiting for the game to collect them
+	GameObject* NewObject(); //Creates an empty GO in the pool
+	bool SweptIntersects(GameObject* pMover, GameObject* pOther, float& timeOfImpact) const; //Tests pMover's path this step against pOther
+	void TestChunk(int chunk); //Narrowphase for one chunk of pairs. Only reads shapes and transforms, so can run on any thread.
+	void ResolvePair(const BroadphaseProxy& first, const BroadphaseProxy& second);     //Hands a colliding pair to whichever side reacts
 public:	
 	//Functions
 	ObjectManager();  // Constructor
@@ -21,8 +80,20 @@ public:
 	GameObject* CreateRock(Vector2D position, Vector2D velocity, float rotation);
 	GameObject* CreateCow(Vector2D position, Vector2D velocity, float rotation);
 	GameObject* CreateBullet(Vector2D position, Vector2D velocity);
-	void UpdateAll();
+	void UpdateAll(const FrameContext& frame);  //Updates every object with the same frame information
+	void IntegrateAll(float frameTime); //Moves every GO with a PhysicsComponent on by its velocity
+	void RenderAll(float alpha);        //Draws every GO between its previous (alpha 0) and current (alpha 1) transform
 	void CheckAllCollisions();
 	void DeleteInactive();
 	void DeleteAll();
+	GameObject* Find(SlotHandle handle) const;       //Returns the GO referred to by handle, or nullptr if it has been deleted
+	int GetObjectCount() const;                      //Returns the number of GOs currently held
+	const CollisionStats& GetCollisionStats() const; //Returns the counters from the last collision check
+	double GetUpdateTime() const;                    //Returns the seconds spent updating components in the last UpdateAll
+	void SetBroadphase(BroadphaseMode mode);         //Switches broadphase - can be changed at any time
+	BroadphaseMode GetBroadphase() const;            //Returns the broadphase currently in use
+	void SetNarrowphaseThreads(int threads);         //Threads the pair tests run on, counting the calling thread. 0 for one per core, which it starts at.
+	int GetNarrowphaseThreads() const;
+	void AddPoints(double points);                   //Awards the player points - the game collects them with TakePoints
+	double TakePoints();                             //Returns the points awarded since the last call, and clears them
 };
\ No newline at end of file
@@ -0,0 +1,61 @@
+//Created by 16007006
+//Fixed-size queue for passing items from exactly one producer thread to exactly one
+//consumer thread without a lock. Each side only writes its own index, so neither ever
+//waits for the other - a full queue just refuses the push.
+
+#pragma once
+#include <atomic>
+
+template<class T, unsigned int CAPACITY>
+class SPSCQueue
+{
+	static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "SPSCQueue capacity must be a power of two");
+
+private:
+	T m_Items[CAPACITY];
+
+	// Both count up forever and wrap; the slot is the count modulo CAPACITY.
+	// Padded apart so the two threads do not fight over one cache line. Padding
+	// rather than alignas, as the queue is often inside something made with new.
+	char m_PadItems[64];
+	std::atomic<unsigned int> m_Head;	// Next item to pop. Only written by the consumer.
+	char m_PadHead[64];
+	std::atomic<unsigned int> m_Tail;	// Next slot to push into. Only written by the producer.
+	char m_PadTail[64];
+
+public:
+	SPSCQueue() : m_Head(0), m_Tail(0) {}
+
+	SPSCQueue(const SPSCQueue&) = delete;
+	SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+	// Producer only.
+	// Returns: true if the item was added, false if the queue is full
+	bool TryPush(const T& item)
+	{
+		unsigned int tail = m_Tail.load(std::memory_order_relaxed);
+		if(tail - m_Head.load(std::memory_order_acquire) == CAPACITY)
+			return false;
+		m_Items[tail % CAPACITY] = item;
+		m_Tail.store(tail + 1, std::memory_order_release);	// Publishes the item to the consumer
+		return true;
+	}
+
+	// Consumer only.
+	// Returns: true if item was set to the oldest item, which has been removed. false if the queue is empty.
+	bool TryPop(T& item)
+	{
+		unsigned int head = m_Head.load(std::memory_order_relaxed);
+		if(head == m_Tail.load(std::memory_order_acquire))
+			return false;
+		item = m_Items[head % CAPACITY];
+		m_Head.store(head + 1, std::memory_order_release);	// Hands the slot back to the producer
+		return true;
+	}
+
+	// Either thread. Only a snapshot - the other thread may change it straight away.
+	bool IsEmpty() const
+	{
+		return m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_acquire);
+	}
+};
@@ -1,3 +1,7 @@
+// Modified by 16007006
+// IShape2D::Intersects looks the test for a pair of shapes up by their type tags, instead of dynamic_cast
+// Added Segment2D::FirstIntersection for circles, for swept collision
+
 #include "Shapes.h"
 #include <limits.h>
 #include <iostream>
@@ -9,6 +13,40 @@ using namespace std;
 // Member functions for IShape ***********************************
 // ***************************************************************
 
+// Tests one pair of concrete shapes. Calls the second shape's test with the first,
+// as each shape's own Intersects(IShape2D) always did.
+template<class FIRST, class SECOND>
+static bool IntersectPair(const IShape2D& first, const IShape2D& second)
+{
+	return static_cast<const SECOND&>(second).Intersects(static_cast<const FIRST&>(first));
+}
+
+typedef bool (*IntersectFunction)(const IShape2D& first, const IShape2D& second);
+
+// The test for every pair of shapes, by [first type][second type]
+static const IntersectFunction IntersectTable[NUMSHAPETYPES][NUMSHAPETYPES] =
+{
+	{IntersectPair<Point2D, Point2D>, IntersectPair<Point2D, Segment2D>, IntersectPair<Point2D, Circle2D>, IntersectPair<Point2D, Rectangle2D>},
+	{IntersectPair<Segment2D, Point2D>, IntersectPair<Segment2D, Segment2D>, IntersectPair<Segment2D, Circle2D>, IntersectPair<Segment2D, Rectangle2D>},
+	{IntersectPair<Circle2D, Point2D>, IntersectPair<Circle2D, Segment2D>, IntersectPair<Circle2D, Circle2D>, IntersectPair<Circle2D, Rectangle2D>},
+	{IntersectPair<Rectangle2D, Point2D>, IntersectPair<Rectangle2D, Segment2D>, IntersectPair<Rectangle2D, Circle2D>, IntersectPair<Rectangle2D, Rectangle2D>}
+};
+
+IShape2D::IShape2D(ShapeType type): mType(type)
+{
+
+}
+
+bool IShape2D::Intersects(const IShape2D& other) const
+{
+	return IntersectTable[mType][other.mType](*this, other);
+}
+
+ShapeType IShape2D::GetType() const
+{
+	return mType;
+}
+
 // Virtual destructor for usual reasons
 IShape2D::~IShape2D()
 {
@@ -20,17 +58,17 @@ IShape2D::~IShape2D()
 // Member functions for Point2D **********************************
 // ***************************************************************
 
-Point2D::Point2D()
+Point2D::Point2D(): IShape2D(SHAPE_POINT)
 {
 	this->mPosition.set(0,0);
 }
 
-Point2D::Point2D(float x, float y)
+Point2D::Point2D(float x, float y): IShape2D(SHAPE_POINT)
 {
 	this->mPosition.set(x,y);
 }
 
-Point2D::Point2D(const Vector2D &copy)
+Point2D::Point2D(const Vector2D &copy): IShape2D(SHAPE_POINT)
 {
 	this->mPosition=copy;
 }
@@ -73,36 +111,6 @@ bool Point2D::Intersects(const Segment2D &other) const
 		return false;
 }
 
-bool Point2D::Intersects(const IShape2D& other) const
-{
-	// Is it a rectangle?
-	const Rectangle2D* pRect = nullptr;
-	pRect = dynamic_cast<const Rectangle2D*> (&other);
-	if(pRect)
-		return pRect->Intersects(*this);
-
-	// Is it a circle?
-	const Circle2D* pCirc = nullptr;
-	pCirc = dynamic_cast<const Circle2D*> (&other);
-	if(pCirc)
-		return pCirc->Intersects(*this);
-
-	// Is it a segment?
-	const Segment2D* pSeg = nullptr;
-	pSeg = dynamic_cast<const Segment2D*> (&other);
-	if(pSeg)
-		return pSeg->Intersects(*this);
-
-	// Is it a point?
-	const Point2D* ppt = nullptr;
-	ppt = dynamic_cast<const Point2D*> (&other);
-	if(ppt)
-		return ppt->Intersects(*this);
-
-	// Undefined shape
-	return false;
-}
-
 float Point2D::Distance(const Segment2D &other) const
 {
 	// Project the point onto the line and find the parameter, t
@@ -222,7 +230,7 @@ Vector2D Point2D::Intersection(const Rectangle2D &other) const
 // Member functions for Segment2D *********************************
 // ****************************************************************
 
-Segment2D::Segment2D(): mStart(0,0), mEnd(0,0)
+Segment2D::Segment2D(): IShape2D(SHAPE_SEGMENT), mStart(0,0), mEnd(0,0)
 {
 
 }
@@ -297,36 +305,6 @@ Vector2D Segment2D::Intersection(const Point2D &other) const
 	}	// End if line length is not zero
 }
 
-bool Segment2D::Intersects(const IShape2D& other) const
-{
-	// Is it a rectangle?
-	const Rectangle2D* pRect = nullptr;
-	pRect = dynamic_cast<const Rectangle2D*> (&other);
-	if(pRect)
-		return pRect->Intersects(*this);
-
-	// Is it a circle?
-	const Circle2D* pCirc = nullptr;
-	pCirc = dynamic_cast<const Circle2D*> (&other);
-	if(pCirc)
-		return pCirc->Intersects(*this);
-
-	// Is it a segment?
-	const Segment2D* pSeg = nullptr;
-	pSeg = dynamic_cast<const Segment2D*> (&other);
-	if(pSeg)
-		return pSeg->Intersects(*this);
-
-	// Is it a point?
-	const Point2D* ppt = nullptr;
-	ppt = dynamic_cast<const Point2D*> (&other);
-	if(ppt)
-		return ppt->Intersects(*this);
-
-	// Undefined shape
-	return false;
-}
-
 bool Segment2D::Intersects(const Segment2D &other) const
 {
 	// Check that lines are not parallel
@@ -481,6 +459,25 @@ Vector2D Segment2D::Intersection(const Circle2D &other) const
 	return Intersection(Point2D(other.mCentre));
 }
 
+Vector2D Segment2D::FirstIntersection(const Circle2D &other) const
+{
+	// Solve |mStart + t(mEnd-mStart) - centre| = radius for the smaller t
+	Vector2D direction = mEnd - mStart;
+	Vector2D offset = mStart - other.mCentre;
+	float c = offset*offset - other.mdRadius*other.mdRadius;
+	if(c<=0)			// Start is inside the circle
+		return mStart;
+	float a = direction*direction;
+	float b = 2*(offset*direction);
+	float discriminant = b*b - 4*a*c;
+	if(a==0 || discriminant<0)	// Zero length, or the line misses the circle
+		return mEnd;
+	float t = (-b - sqrt(discriminant))/(2*a);
+	if(t<0 || t>1)		// Enters beyond the ends of the segment
+		return mEnd;
+	return PointFromT(t);
+}
+
 bool Segment2D::Intersects(const Rectangle2D &other) const
 {
 	if(GetLength()==0)	// Special case
@@ -611,12 +608,12 @@ void Segment2D::SetEndTo(float t)
 // Member functions for Circle2D
 // *********************************************************************
 
-Circle2D::Circle2D(): mdRadius(0)
+Circle2D::Circle2D(): IShape2D(SHAPE_CIRCLE), mdRadius(0)
 {
 	this->mCentre.set(0,0);
 }
 
-Circle2D::Circle2D(const Vector2D &centre, float radius)
+Circle2D::Circle2D(const Vector2D &centre, float radius): IShape2D(SHAPE_CIRCLE)
 {
 	this->mCentre=centre;
 	if(radius>=0)
@@ -674,36 +671,6 @@ bool Circle2D::Intersects(const Segment2D &other) const
 	return other.Intersects(*this);
 }
 
-bool Circle2D::Intersects(const IShape2D& other) const
-{
-	// Is it a rectangle?
-	const Rectangle2D* pRect = nullptr;
-	pRect = dynamic_cast<const Rectangle2D*> (&other);
-	if(pRect)
-		return pRect->Intersects(*this);
-
-	// Is it a circle?
-	const Circle2D* pCirc = nullptr;
-	pCirc = dynamic_cast<const Circle2D*> (&other);
-	if(pCirc)
-		return pCirc->Intersects(*this);
-
-	// Is it a segment?
-	const Segment2D* pSeg = nullptr;
-	pSeg = dynamic_cast<const Segment2D*> (&other);
-	if(pSeg)
-		return pSeg->Intersects(*this);
-
-	// Is it a point?
-	const Point2D* ppt = nullptr;
-	ppt = dynamic_cast<const Point2D*> (&other);
-	if(ppt)
-		return ppt->Intersects(*this);
-
-	// Undefined shape
-	return false;
-}
-
 float Circle2D::Distance(const Segment2D &other) const
 {
 	return Distance(other.Intersection(mCentre));
@@ -775,7 +742,7 @@ Vector2D Circle2D::CollisionNormal(const Segment2D& other) const
 // Member functions for Rectangle2D
 // ********************************************************************
 
-Rectangle2D::Rectangle2D()
+Rectangle2D::Rectangle2D(): IShape2D(SHAPE_RECTANGLE)
 {
 	this->mCorner1.set(0,0);
 	this->mCorner2.set(0,0);
@@ -986,36 +953,6 @@ bool Rectangle2D::Intersects(const Segment2D &other) const
 	return other.Intersects(*this);
 }
 
-bool Rectangle2D::Intersects(const IShape2D& other) const
-{
-	// Is it a rectangle?
-	const Rectangle2D* pRect = nullptr;
-	pRect = dynamic_cast<const Rectangle2D*> (&other);
-	if(pRect)
-		return pRect->Intersects(*this);
-
-	// Is it a circle?
-	const Circle2D* pCirc = nullptr;
-	pCirc = dynamic_cast<const Circle2D*> (&other);
-	if(pCirc)
-		return pCirc->Intersects(*this);
-
-	// Is it a segment?
-	const Segment2D* pSeg = nullptr;
-	pSeg = dynamic_cast<const Segment2D*> (&other);
-	if(pSeg)
-		return pSeg->Intersects(*this);
-
-	// Is it a point?
-	const Point2D* ppt = nullptr;
-	ppt = dynamic_cast<const Point2D*> (&other);
-	if(ppt)
-		return ppt->Intersects(*this);
-
-	// Undefined shape
-	return false;
-}
-
 
 
 Vector2D Rectangle2D::Intersection(const Segment2D &other) const
@@ -1122,7 +1059,6 @@ Segment2D Rectangle2D::Clip(Segment2D other) const
 	{
 		tempT = other.GetTFromY(bottom);
 		if(tempT>minT) minT=tempT;
-		cout << "b";
 	}
 
 	// Check for mint and maxt overlap - means you missed the rectangle
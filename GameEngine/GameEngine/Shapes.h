@@ -3,15 +3,34 @@
 // Shell engine version 2020
 // Chris Rook
 // Last modified 20/09/2018
+// Modified by 16007006
+// Shapes carry a type tag, and IShape2D::Intersects finds the test for a pair from a table
+// Added Segment2D::FirstIntersection for circles, for swept collision
 
 #include "Vector2D.h"
 #pragma once
 
+// The concrete shapes, as stored in each shape's type tag
+enum ShapeType{SHAPE_POINT, SHAPE_SEGMENT, SHAPE_CIRCLE, SHAPE_RECTANGLE, NUMSHAPETYPES};
+
 // Abstract 2D shape
 class IShape2D
 {
+private:
+	ShapeType mType;        // Which concrete shape this is. Set once by its constructor.
+
+protected:
+	IShape2D(ShapeType type);
+
 public:
-	virtual bool Intersects(const IShape2D& other) const=0;
+	// Returns true if this intersects the other shape, whatever the two are.
+	// Looks the test for the pair up by their type tags, rather than
+	// trying a cast to each shape in turn.
+	bool Intersects(const IShape2D& other) const;
+
+	// Returns the concrete shape this is
+	ShapeType GetType() const;
+
 	virtual ~IShape2D();
 };
 
@@ -89,7 +108,7 @@ public:
 	bool Intersects(const Rectangle2D &other) const;
 
 	// Returns true if the point intersects the specified shape
-	bool Intersects(const IShape2D &other) const;
+	using IShape2D::Intersects;
 
 	// Returns the distance from this point to the closest 
 	// point on the rectangle.
@@ -138,7 +157,7 @@ public:
 	bool Intersects(const Point2D &other) const;
 
 	// Returns true if the segment intersects the specified shape
-	bool Intersects(const IShape2D &other) const;
+	using IShape2D::Intersects;
 
 	// Distance from other to the closest point
 	// on the segment
@@ -182,6 +201,11 @@ public:
 	// deepest point on the segment
 	Vector2D Intersection(const Circle2D &other) const;
 
+	// Returns the point where the segment enters the circle.
+	// If the start is inside the circle, returns the start.
+	// If no intersection is found, returns the end of the segment
+	Vector2D FirstIntersection(const Circle2D &other) const;
+
 	// Returns true if the segment intersects the rectangle
 	// False otherwise
 	bool Intersects(const Rectangle2D &other) const;
@@ -272,7 +296,7 @@ public:
 	bool Intersects(const Point2D &other) const;
 
 	// Returns true if the circle intersects the specified shape
-	bool Intersects(const IShape2D &other) const;
+	using IShape2D::Intersects;
 
 	// Returns the distance from the point to the circle
 	// If the point is inside the circle,
@@ -498,6 +522,6 @@ public:
 	// intersect the rectangle
 	Segment2D Clip(Segment2D other) const;
 
-		// Returns true if the rectangle intersects the specified shape
-	bool Intersects(const IShape2D &other) const;
+	// Returns true if the rectangle intersects the specified shape
+	using IShape2D::Intersects;
 };
\ No newline at end of file
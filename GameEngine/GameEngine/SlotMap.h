@@ -0,0 +1,175 @@
+//Created by 16007006
+//Pooled object storage with generational handles
+//Objects live in fixed-size chunks which are never moved, so pointers to them stay
+//valid for as long as the object exists. A packed list of the live slots gives a
+//dense iteration order, and freed slots are reused without going back to the heap.
+
+#pragma once
+#include <vector>
+#include <new>
+#include <utility>
+
+//Refers to an object in a SlotMap.
+//  When the object is destroyed its slot's generation changes, so an old handle
+//  can never find the object which later reuses the slot.
+struct SlotHandle
+{
+	unsigned int index;      //The slot the object lives in
+	unsigned int generation; //The generation of the slot when the object was created
+
+	SlotHandle() : index(0xFFFFFFFF), generation(0) {} //Default handle refers to nothing
+};
+
+template <class T, int CHUNKSIZE = 256>
+class SlotMap
+{
+private:
+	//Book-keeping for one slot of storage
+	struct Slot
+	{
+		unsigned int generation; //Incremented every time the slot is freed
+		int dense;               //Position in the dense list, or -1 if the slot is free
+		int nextFree;            //Next slot in the free list, if this one is free
+	};
+
+	std::vector<T*>  chunks;            //Raw storage for CHUNKSIZE objects each. Never reallocated.
+	std::vector<Slot> slots;            //One entry per slot in the chunks
+	std::vector<unsigned int> dense;    //Slot index of every live object, packed together
+	int firstFree;                      //Head of the free slot list, or -1 if every slot is in use
+
+	//Returns the address of the storage for a slot
+	T* SlotAddress(unsigned int index) const
+	{
+		return chunks[index / CHUNKSIZE] + (index % CHUNKSIZE);
+	}
+
+	//Adds another chunk of slots to the free list
+	void Grow()
+	{
+		chunks.push_back(static_cast<T*>(::operator new(sizeof(T) * CHUNKSIZE)));
+		int first = (int)slots.size();
+		for (int i = 0; i < CHUNKSIZE; i++)
+		{
+			Slot slot;
+			slot.generation = 0;
+			slot.dense      = -1;
+			slot.nextFree   = (i + 1 < CHUNKSIZE) ? first + i + 1 : firstFree;
+			slots.push_back(slot);
+		}
+		firstFree = first;
+	}
+
+	SlotMap(const SlotMap& other);            //Copying disabled
+	SlotMap& operator=(const SlotMap& other); //Assignment disabled
+
+public:
+	//Constructor
+	SlotMap()
+	{
+		firstFree = -1;
+	}
+
+	//Destructor - destroys any remaining objects and releases the chunks
+	~SlotMap()
+	{
+		Clear();
+		for (T* pChunk : chunks)
+		{
+			::operator delete(pChunk);
+		}
+	}
+
+	//Constructs a new object in a free slot, passing args to its constructor.
+	//  Returns the handle of the new object.
+	template <class... Args>
+	SlotHandle Create(Args&&... args)
+	{
+		if (firstFree < 0)
+		{
+			Grow();
+		}
+		unsigned int index = (unsigned int)firstFree;
+		Slot& slot = slots[index];
+		firstFree = slot.nextFree;
+
+		new (SlotAddress(index)) T(std::forward<Args>(args)...);
+		slot.dense = (int)dense.size();
+		dense.push_back(index);
+
+		SlotHandle handle;
+		handle.index      = index;
+		handle.generation = slot.generation;
+		return handle;
+	}
+
+	//Destroys the object referred to by handle. Does nothing if the handle is stale.
+	//  The last object in the dense list is moved into the gap, so this is O(1),
+	//  but it does change the iteration order.
+	void Destroy(SlotHandle handle)
+	{
+		if (!Get(handle))
+		{
+			return;
+		}
+		Slot& slot = slots[handle.index];
+		SlotAddress(handle.index)->~T();
+
+		//Fill the gap in the dense list with the last entry
+		unsigned int last = dense.back();
+		dense[slot.dense] = last;
+		slots[last].dense = slot.dense;
+		dense.pop_back();
+
+		//Return the slot to the free list
+		slot.dense    = -1;
+		slot.generation++;
+		slot.nextFree = firstFree;
+		firstFree     = (int)handle.index;
+	}
+
+	//Destroys every object. The storage is kept for reuse.
+	void Clear()
+	{
+		while (!dense.empty())
+		{
+			Destroy(HandleAt((int)dense.size() - 1));
+		}
+	}
+
+	//Returns a pointer to the object referred to by handle,
+	//  or nullptr if the handle is stale or invalid
+	T* Get(SlotHandle handle) const
+	{
+		if (handle.index >= slots.size())
+		{
+			return nullptr;
+		}
+		const Slot& slot = slots[handle.index];
+		if (slot.dense < 0 || slot.generation != handle.generation)
+		{
+			return nullptr;
+		}
+		return SlotAddress(handle.index);
+	}
+
+	//Returns the number of live objects
+	int Size() const
+	{
+		return (int)dense.size();
+	}
+
+	//Returns the i'th live object, for 0 <= i < Size()
+	T& operator[](int i) const
+	{
+		return *SlotAddress(dense[i]);
+	}
+
+	//Returns the handle of the i'th live object
+	SlotHandle HandleAt(int i) const
+	{
+		SlotHandle handle;
+		handle.index      = dense[i];
+		handle.generation = slots[dense[i]].generation;
+		return handle;
+	}
+};
@@ -0,0 +1,444 @@
+//Created by 16007006
+//CPU rasterizer implementation of DrawBackend
+//Each sprite, triangle or line is broken into horizontal spans. Texels for a span are
+//fetched first, then blended in a separate loop with no branches or float maths, so
+//the compiler can vectorise the part that touches every pixel.
+
+#include "SoftwareBackend.h"
+#include "errorlogger.h"
+#include "AssetDecoder.h"
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+// *************************************************************
+// Span loops
+// *************************************************************
+
+// Divides by 255, rounding. Exact for any value up to 255*255.
+static inline unsigned int Div255(unsigned int x)
+{
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+// Blends count texels over the destination. Each texel's own alpha is scaled by modAlpha (0-255).
+static void BlendTexels(unsigned int* __restrict dst, const unsigned int* __restrict src, int count, unsigned int modAlpha)
+{
+	for(int i=0;i<count;i++)
+	{
+		unsigned int s = src[i];
+		unsigned int d = dst[i];
+		unsigned int a = Div255((s >> 24) * modAlpha);
+		unsigned int ia = 255 - a;
+		unsigned int r = Div255(((s >> 16) & 255) * a + ((d >> 16) & 255) * ia);
+		unsigned int g = Div255(((s >> 8) & 255) * a + ((d >> 8) & 255) * ia);
+		unsigned int b = Div255((s & 255) * a + (d & 255) * ia);
+		dst[i] = 0xFF000000 | (r << 16) | (g << 8) | b;
+	}
+}
+
+// Blends one colour over count pixels, using the alpha in the colour
+static void BlendSolid(unsigned int* __restrict dst, int count, unsigned int colour)
+{
+	unsigned int a = colour >> 24;
+	unsigned int ia = 255 - a;
+	unsigned int r = ((colour >> 16) & 255) * a;
+	unsigned int g = ((colour >> 8) & 255) * a;
+	unsigned int b = (colour & 255) * a;
+	for(int i=0;i<count;i++)
+	{
+		unsigned int d = dst[i];
+		dst[i] = 0xFF000000
+			| (Div255(r + ((d >> 16) & 255) * ia) << 16)
+			| (Div255(g + ((d >> 8) & 255) * ia) << 8)
+			| Div255(b + (d & 255) * ia);
+	}
+}
+
+// Overwrites count pixels with one colour
+static void FillSolid(unsigned int* __restrict dst, int count, unsigned int colour)
+{
+	colour |= 0xFF000000;
+	for(int i=0;i<count;i++)
+		dst[i] = colour;
+}
+
+// Narrows lo <= f0 + df*x < hi to a range of x, intersected with [xl, xr)
+static void ClipRange(float f0, float df, float lo, float hi, float& xl, float& xr)
+{
+	if(df == 0.0f)
+	{
+		if(f0 < lo || f0 >= hi)
+			xr = xl;		// Nothing on this row
+	}
+	else if(df > 0.0f)
+	{
+		xl = std::max(xl, (lo - f0) / df);
+		xr = std::min(xr, (hi - f0) / df);
+	}
+	else
+	{
+		xl = std::max(xl, (hi - f0) / df);
+		xr = std::min(xr, (lo - f0) / df);
+	}
+}
+
+// *************************************************************
+// Construction and frames
+// *************************************************************
+
+SoftwareBackend::SoftwareBackend(int width, int height)
+{
+	m_Width = width;
+	m_Height = height;
+	m_NextPicture = 1;
+	m_NextFont = 1;
+	m_FrameChecksum = 0;
+}
+
+// *******************************************************************
+
+ErrorType SoftwareBackend::Start(int width, int height, bool fullScreen)
+{
+	return Reset(width, height, fullScreen);
+}
+
+// *******************************************************************
+
+// Resizes the framebuffer. Pictures are in memory, so they survive.
+ErrorType SoftwareBackend::Reset(int width, int height, bool /*fullScreen*/)
+{
+	if(width <= 0 || height <= 0)
+	{
+		ErrorLogger::Writeln(L"Invalid framebuffer size in SoftwareBackend");
+		return FAILURE;
+	}
+
+	m_Width = width;
+	m_Height = height;
+	m_Framebuffer.assign(width * height, 0xFF000000);
+	m_RowBuffer.resize(width);
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+void SoftwareBackend::GetNativeResolution(int& width, int& height) const
+{
+	width = m_Width;
+	height = m_Height;
+}
+
+// *******************************************************************
+
+ErrorType SoftwareBackend::Clear()
+{
+	std::fill(m_Framebuffer.begin(), m_Framebuffer.end(), 0xFF000000);
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType SoftwareBackend::Present()
+{
+	// 64-bit FNV-1a, one pixel at a time
+	unsigned long long hash = 14695981039346656037ULL;
+	for(unsigned int pixel : m_Framebuffer)
+	{
+		hash ^= pixel;
+		hash *= 1099511628211ULL;
+	}
+	m_FrameChecksum = hash;
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+unsigned long long SoftwareBackend::GetFrameChecksum() const
+{
+	return m_FrameChecksum;
+}
+
+// *******************************************************************
+
+const unsigned int* SoftwareBackend::GetFramebuffer() const
+{
+	return m_Framebuffer.data();
+}
+
+// *************************************************************
+// Textures
+// *************************************************************
+
+ErrorType SoftwareBackend::GetPictureSize(const wchar_t filename[], int& width, int& height)
+{
+	return AssetDecoder::ReadBMPSize(filename, width, height);
+}
+
+// *******************************************************************
+
+ErrorType SoftwareBackend::LoadPicture(const wchar_t filename[], int& picture, DrawRegion& region)
+{
+	int width, height;
+	std::vector<unsigned int> pixels;
+	if(AssetDecoder::DecodeBMP(filename, width, height, pixels) == FAILURE)
+	{
+		ErrorLogger::Write(L"Failed to load BMP in SoftwareBackend: ");
+		ErrorLogger::Writeln(filename);
+		return FAILURE;
+	}
+
+	return LoadPictureData(pixels.data(), width, height, picture, region);
+}	// LoadPicture
+
+// *******************************************************************
+
+ErrorType SoftwareBackend::LoadPictureData(const unsigned int pixels[], int width, int height, int& picture, DrawRegion& region)
+{
+	// Find room in the atlas, starting a page if needed. New pages are transparent.
+	int pageWidth, pageHeight;
+	m_Atlas.Insert(width, height, region, pageWidth, pageHeight);
+	SoftwareTexture& page = m_PageList[region.texture];
+	if(pageWidth > 0)
+	{
+		page.m_width = pageWidth;
+		page.m_height = pageHeight;
+		page.m_Pixels.assign(size_t(pageWidth) * pageHeight, 0);
+	}
+
+	// Copy the image in
+	for(int y=0;y<height;y++)
+	{
+		std::copy(pixels + size_t(y) * width,
+				  pixels + size_t(y + 1) * width,
+				  page.m_Pixels.begin() + size_t(region.top + y) * page.m_width + region.left);
+	}
+
+	picture = m_NextPicture++;
+	m_PictureList[picture] = region;
+	return SUCCESS;
+}	// LoadPictureData
+
+// *******************************************************************
+
+void SoftwareBackend::ReleasePicture(int picture)
+{
+	std::map<int, DrawRegion>::iterator it = m_PictureList.find(picture);
+	if(it == m_PictureList.end())
+		return;
+
+	if(m_Atlas.Remove(it->second.texture))
+		m_PageList.erase(it->second.texture);
+	m_PictureList.erase(it);
+}
+
+// *************************************************************
+// Drawing
+// *************************************************************
+
+ErrorType SoftwareBackend::DrawSprites(const DrawSprite sprites[], unsigned int numSprites)
+{
+	int currentHandle = 0;
+	const SoftwareTexture* pPage = nullptr;
+	for(unsigned int i=0;i<numSprites;i++)
+	{
+		// Sprites are sorted, so the page only needs looking up when it changes
+		if(sprites[i].source.texture != currentHandle)
+		{
+			currentHandle = sprites[i].source.texture;
+			std::map<int, SoftwareTexture>::const_iterator it = m_PageList.find(currentHandle);
+			pPage = (it == m_PageList.end()) ? nullptr : &it->second;
+		}
+		if(pPage)
+			DrawOneSprite(sprites[i], *pPage);
+	}
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+void SoftwareBackend::DrawOneSprite(const DrawSprite& sprite, const SoftwareTexture& page)
+{
+	float det = sprite.m11 * sprite.m22 - sprite.m21 * sprite.m12;
+	if(std::fabs(det) < 1e-12f)
+		return;			// Scaled to nothing
+
+	float w = float(sprite.source.width);
+	float h = float(sprite.source.height);
+
+	// Rows covered by the transformed rectangle
+	float cornerY[4] = {sprite.dy, sprite.dy + w*sprite.m12, sprite.dy + h*sprite.m22, sprite.dy + w*sprite.m12 + h*sprite.m22};
+	float minY = *std::min_element(cornerY, cornerY+4);
+	float maxY = *std::max_element(cornerY, cornerY+4);
+	int yStart = std::max(0, int(std::ceil(minY - 0.5f)));
+	int yEnd = std::min(m_Height-1, int(std::floor(maxY - 0.5f)));
+
+	// Inverse transform - screen to texel
+	float uPerX = sprite.m22 / det;
+	float uPerY = -sprite.m21 / det;
+	float vPerX = -sprite.m12 / det;
+	float vPerY = sprite.m11 / det;
+
+	unsigned int modAlpha = sprite.colour >> 24;
+	int maxU = sprite.source.width - 1;
+	int maxV = sprite.source.height - 1;
+	const unsigned int* texels = &page.m_Pixels[size_t(sprite.source.top) * page.m_width + sprite.source.left];
+	unsigned int* row = m_RowBuffer.data();
+
+	for(int y=yStart;y<=yEnd;y++)
+	{
+		// Texel coordinates at x = 0 on this row, sampled at the pixel centre
+		float yc = y + 0.5f - sprite.dy;
+		float u0 = -sprite.dx * uPerX + yc * uPerY;
+		float v0 = -sprite.dx * vPerX + yc * vPerY;
+
+		// Pixels whose centres map inside the picture
+		float xl = 0.0f;
+		float xr = float(m_Width);
+		ClipRange(u0, uPerX, 0.0f, w, xl, xr);
+		ClipRange(v0, vPerX, 0.0f, h, xl, xr);
+		int xStart = std::max(0, int(std::ceil(xl - 0.5f)));
+		int xEnd = std::min(m_Width-1, int(std::ceil(xr - 0.5f)) - 1);
+		int count = xEnd - xStart + 1;
+		if(count <= 0)
+			continue;
+
+		// Fetch the texels, stepping through the texture in 16.16 fixed point
+		float xc = xStart + 0.5f;
+		int fu = int((u0 + xc * uPerX) * 65536.0f);
+		int fv = int((v0 + xc * vPerX) * 65536.0f);
+		int du = int(uPerX * 65536.0f);
+		int dv = int(vPerX * 65536.0f);
+		for(int i=0;i<count;i++)
+		{
+			// Clamped, in case rounding steps just outside the edge of the picture
+			int tu = std::min(std::max(fu >> 16, 0), maxU);
+			int tv = std::min(std::max(fv >> 16, 0), maxV);
+			row[i] = texels[tv * page.m_width + tu];
+			fu += du;
+			fv += dv;
+		}
+
+		BlendTexels(&m_Framebuffer[y * m_Width + xStart], row, count, modAlpha);
+	}
+}	// DrawOneSprite
+
+// *******************************************************************
+
+ErrorType SoftwareBackend::DrawPrimitives(DrawPrimitiveType type, bool blend, const DrawVertex vertices[], unsigned int numVertices, int& drawCalls)
+{
+	if(type == DRAW_POINTLIST)
+	{
+		for(unsigned int i=0;i<numVertices;i++)
+			PlotPixel(int(std::floor(vertices[i].x)), int(std::floor(vertices[i].y)), vertices[i].colour, blend);
+	}
+	else if(type == DRAW_LINELIST)
+	{
+		for(unsigned int i=0;i+1<numVertices;i+=2)
+			DrawOneLine(vertices[i], vertices[i+1], blend);
+	}
+	else
+	{
+		for(unsigned int i=0;i+2<numVertices;i+=3)
+			FillTriangle(vertices[i], vertices[i+1], vertices[i+2], blend);
+	}
+	drawCalls++;
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+void SoftwareBackend::PlotPixel(int x, int y, unsigned int colour, bool blend)
+{
+	if(x < 0 || y < 0 || x >= m_Width || y >= m_Height)
+		return;
+
+	unsigned int* dst = &m_Framebuffer[y * m_Width + x];
+	if(blend)
+		BlendSolid(dst, 1, colour);
+	else
+		*dst = colour | 0xFF000000;
+}
+
+// *******************************************************************
+
+// Steps along the longer axis one pixel at a time
+void SoftwareBackend::DrawOneLine(const DrawVertex& start, const DrawVertex& end, bool blend)
+{
+	float dx = end.x - start.x;
+	float dy = end.y - start.y;
+	int steps = int(std::max(std::fabs(dx), std::fabs(dy)));
+	if(steps == 0)
+		return;
+
+	float stepX = dx / steps;
+	float stepY = dy / steps;
+	for(int i=0;i<steps;i++)
+		PlotPixel(int(std::floor(start.x + stepX*i)), int(std::floor(start.y + stepY*i)), start.colour, blend);
+}
+
+// *******************************************************************
+
+// Flat shaded with the colour of the first vertex
+void SoftwareBackend::FillTriangle(const DrawVertex& a, const DrawVertex& b, const DrawVertex& c, bool blend)
+{
+	const DrawVertex* corners[3] = {&a, &b, &c};
+
+	float minY = std::min(a.y, std::min(b.y, c.y));
+	float maxY = std::max(a.y, std::max(b.y, c.y));
+	int yStart = std::max(0, int(std::ceil(minY - 0.5f)));
+	int yEnd = std::min(m_Height-1, int(std::ceil(maxY - 0.5f)) - 1);
+
+	for(int y=yStart;y<=yEnd;y++)
+	{
+		float yc = y + 0.5f;
+
+		// Where this row crosses the edges
+		float xl = FLT_MAX;
+		float xr = -FLT_MAX;
+		for(int e=0;e<3;e++)
+		{
+			const DrawVertex& p = *corners[e];
+			const DrawVertex& q = *corners[(e+1)%3];
+			if((p.y <= yc && yc < q.y) || (q.y <= yc && yc < p.y))
+			{
+				float x = p.x + (yc - p.y) * (q.x - p.x) / (q.y - p.y);
+				xl = std::min(xl, x);
+				xr = std::max(xr, x);
+			}
+		}
+		if(xl > xr)
+			continue;
+
+		// Pixels whose centres are inside
+		int xStart = std::max(0, int(std::ceil(xl - 0.5f)));
+		int xEnd = std::min(m_Width-1, int(std::ceil(xr - 0.5f)) - 1);
+		int count = xEnd - xStart + 1;
+		if(count <= 0)
+			continue;
+
+		unsigned int* dst = &m_Framebuffer[y * m_Width + xStart];
+		if(blend)
+			BlendSolid(dst, count, a.colour);
+		else
+			FillSolid(dst, count, a.colour);
+	}
+}	// FillTriangle
+
+// *************************************************************
+// Fonts and text
+// *************************************************************
+
+ErrorType SoftwareBackend::LoadFont(const wchar_t /*fontName*/[], int /*height*/, bool /*bold*/, bool /*italic*/, int& font)
+{
+	font = m_NextFont++;
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType SoftwareBackend::WriteText(int /*font*/, int /*x*/, int /*y*/, const wchar_t /*text*/[], unsigned int /*colour*/)
+{
+	return SUCCESS;
+}
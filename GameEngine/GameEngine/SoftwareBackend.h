@@ -0,0 +1,80 @@
+//Created by 16007006
+//CPU rasterizer implementation of DrawBackend
+//Draws into a 32-bit XRGB framebuffer in memory, so frames can be rendered, checksummed
+//and timed without a window or a graphics card - e.g. on the Linux benchmark hosts.
+//Does not depend on Windows.
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include "DrawBackend.h"
+#include "TextureAtlas.h"
+
+class SoftwareBackend : public DrawBackend
+{
+private:
+	// An atlas page. Pixels are ARGB, row by row from the top.
+	struct SoftwareTexture
+	{
+		int m_width;
+		int m_height;
+		std::vector<unsigned int> m_Pixels;
+	};
+
+	int m_Width;								// Size of the framebuffer
+	int m_Height;
+	std::vector<unsigned int> m_Framebuffer;	// The back buffer. XRGB, row by row from the top.
+	std::vector<unsigned int> m_RowBuffer;		// Texels fetched for the span being blended
+
+	TextureAtlas m_Atlas;						// Where each picture goes in the pages
+	std::map<int, SoftwareTexture> m_PageList;	// Atlas pages, by texture handle
+	std::map<int, DrawRegion> m_PictureList;	// Loaded pictures, by handle
+	int m_NextPicture;						// Handle of the next picture to be loaded
+	int m_NextFont;							// Handle of the next font to be loaded
+
+	unsigned long long m_FrameChecksum;		// Checksum of the last frame presented
+
+	// Blits one sprite from its atlas page, nearest-neighbour sampled and alpha blended
+	void DrawOneSprite(const DrawSprite& sprite, const SoftwareTexture& page);
+
+	// Fills one triangle, covering pixels whose centres are inside it
+	void FillTriangle(const DrawVertex& a, const DrawVertex& b, const DrawVertex& c, bool blend);
+
+	// Draws a line, leaving out the last pixel as Direct3D does
+	void DrawOneLine(const DrawVertex& start, const DrawVertex& end, bool blend);
+
+	// Plots one pixel if it is on the framebuffer
+	void PlotPixel(int x, int y, unsigned int colour, bool blend);
+
+public:
+	// Parameters:
+	//		width, height	The resolution reported by GetNativeResolution
+	SoftwareBackend(int width, int height);
+
+	ErrorType Start(int width, int height, bool fullScreen) override;
+	ErrorType Reset(int width, int height, bool fullScreen) override;
+	void GetNativeResolution(int& width, int& height) const override;
+	ErrorType Clear() override;
+
+	// Computes the frame checksum. The framebuffer is not cleared.
+	ErrorType Present() override;
+
+	// Only BMP files are supported
+	ErrorType GetPictureSize(const wchar_t filename[], int& width, int& height) override;
+	ErrorType LoadPicture(const wchar_t filename[], int& picture, DrawRegion& region) override;
+	ErrorType LoadPictureData(const unsigned int pixels[], int width, int height, int& picture, DrawRegion& region) override;
+	void ReleasePicture(int picture) override;
+	ErrorType DrawSprites(const DrawSprite sprites[], unsigned int numSprites) override;
+	ErrorType DrawPrimitives(DrawPrimitiveType type, bool blend, const DrawVertex vertices[], unsigned int numVertices, int& drawCalls) override;
+
+	// There are no glyphs, so fonts are accepted and text is not drawn.
+	ErrorType LoadFont(const wchar_t fontName[], int height, bool bold, bool italic, int& font) override;
+	ErrorType WriteText(int font, int x, int y, const wchar_t text[], unsigned int colour) override;
+
+	// FNV-1a hash of the framebuffer when Present was last called
+	unsigned long long GetFrameChecksum() const override;
+
+	// Returns the framebuffer, width*height XRGB pixels row by row from the top
+	const unsigned int* GetFramebuffer() const;
+};
@@ -0,0 +1,98 @@
+//Created by 16007006
+//The interface between MySoundEngine and whatever actually makes the noise
+//MySoundEngine does the SoundIndex bookkeeping, the cache and the voice pool. A backend
+//only sees numbered sample buffers, so the engine can run on DirectSound or on the
+//headless software mixer.
+//Long music is played through streams, which hold only a short ring of samples that is
+//topped up from a WavStream by UpdateStreams, on the sound engine's audio thread.
+
+#pragma once
+
+#include <cstddef>
+#include "errortype.h"
+
+class WavStream;
+
+// Abstract sound backend. One instance is owned by MySoundEngine.
+// Buffers are referred to by handles greater than zero.
+// Volume, pan and frequency use DirectSound's units:
+//		volume		hundredths of a decibel, 0 (full) to -10000 (silent)
+//		pan			-10000 (left) to 10000 (right), attenuating the other side
+//		frequency	samples per second to play at, or 0 for the buffer's own rate
+class SoundBackend
+{
+public:
+	virtual ~SoundBackend() {}
+
+	// Postcondition:	The backend is ready to create buffers.
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	virtual ErrorType Start() = 0;
+
+	// Postcondition:	The PCM wave file has been loaded into a new buffer, and buffer set to its handle.
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	virtual ErrorType LoadWav(const wchar_t filename[], int& buffer) = 0;
+
+	// Postcondition:	A new buffer has been filled with PCM samples already in memory,
+	//					and buffer set to its handle.
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	virtual ErrorType CreateBuffer(int channels, int samplesPerSec, int bitsPerSample,
+		const unsigned char samples[], size_t size, int& buffer) = 0;
+
+	// Postcondition:	copy is set to a new buffer that shares the samples of buffer, but
+	//					plays, and has its volume, pan and frequency set, on its own.
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	virtual ErrorType DuplicateBuffer(int buffer, int& copy) = 0;
+
+	// Postcondition:	The buffer has been stopped and released. The handle is no longer valid.
+	//					Samples shared with copies are kept until the last one is released.
+	virtual void ReleaseBuffer(int buffer) = 0;
+
+	// Postcondition:	The buffer is playing from where it was. A buffer that is not looping
+	//					stops at its end and goes back to the start.
+	virtual ErrorType Play(int buffer, bool looping) = 0;
+
+	// Postcondition:	The buffer has stopped where it was
+	virtual ErrorType Stop(int buffer) = 0;
+
+	// Postcondition:	The buffer's next sample is its first one
+	virtual ErrorType Rewind(int buffer) = 0;
+
+	// Returns true if the buffer is playing
+	virtual bool IsPlaying(int buffer) const = 0;
+
+	virtual ErrorType SetVolume(int buffer, int volume) = 0;
+	virtual ErrorType SetPan(int buffer, int pan) = 0;
+	virtual ErrorType SetFrequency(int buffer, int frequency) = 0;
+
+	// Postcondition:	A stream has been created to play the source, and stream set to its handle.
+	//					The backend owns the source from now on, and deletes it in ReleaseStream.
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	virtual ErrorType CreateStream(WavStream* pSource, int& stream) = 0;
+
+	// Postcondition:	The stream has been stopped and released, along with its source
+	virtual void ReleaseStream(int stream) = 0;
+
+	// Postcondition:	The stream is playing from the start of its source. If looping, the
+	//					end runs straight on into the start with no gap.
+	virtual ErrorType PlayStream(int stream, bool looping) = 0;
+
+	// Postcondition:	The stream has stopped. Playing it again starts from the beginning.
+	virtual ErrorType StopStream(int stream) = 0;
+
+	virtual ErrorType SetStreamVolume(int stream, int volume) = 0;
+
+	// Returns true if the stream is playing. A stream that is not looping stops by
+	// itself once the last of its source has been heard.
+	virtual bool IsStreamPlaying(int stream) = 0;
+
+	// Postcondition:	Every playing stream's ring has been topped up from its source.
+	// Called on the audio thread - the stream methods above must be safe to call alongside it.
+	virtual void UpdateStreams() = 0;
+
+	// Postcondition:	numFrames more frames of output have been mixed from the playing buffers.
+	//					Backends that play in real time do their own mixing and ignore this.
+	virtual ErrorType Render(int numFrames) = 0;
+
+	// Returns a checksum of everything mixed so far, or zero if the backend cannot read its output back
+	virtual unsigned long long GetMixChecksum() const = 0;
+};
@@ -0,0 +1,151 @@
+//Created by 16007006
+//Skyline packing - each page remembers the outline of the pictures packed so far,
+//and a new picture goes in the topmost place along it where it fits.
+//Packs well when pictures arrive tallest first, and still reasonably when they don't.
+
+#include "TextureAtlas.h"
+#include <algorithm>
+
+TextureAtlas::TextureAtlas(int pageSize)
+{
+	m_PageSize = pageSize;
+	m_NextPage = 1;			// Page handles are texture handles, so zero is never valid
+}
+
+// *******************************************************************
+
+void TextureAtlas::Insert(int width, int height, DrawRegion& region, int& newPageWidth, int& newPageHeight)
+{
+	// Each block holds the picture plus the padding to its right and below.
+	// The padding above and to the left comes from the skyline starting at PADDING.
+	int blockWidth = width + PADDING;
+	int blockHeight = height + PADDING;
+
+	region.width = width;
+	region.height = height;
+	newPageWidth = 0;
+	newPageHeight = 0;
+
+	// Try each page in turn
+	for(std::map<int, Page>::iterator it = m_PageList.begin(); it != m_PageList.end(); it++)
+	{
+		int x, y;
+		size_t node;
+		if(FindPosition(it->second, blockWidth, blockHeight, x, y, node))
+		{
+			AddToSkyline(it->second, node, x, y, blockWidth, blockHeight);
+			it->second.m_NumPictures++;
+			region.texture = it->first;
+			region.left = x;
+			region.top = y;
+			return;
+		}
+	}
+
+	// Start a new page, big enough for the picture even if it is bigger than normal
+	Page page;
+	page.m_Width = std::max(m_PageSize, blockWidth + PADDING);
+	page.m_Height = std::max(m_PageSize, blockHeight + PADDING);
+	page.m_NumPictures = 1;
+	SkylineNode start = {PADDING, PADDING, page.m_Width - PADDING};
+	page.m_Skyline.push_back(start);
+	AddToSkyline(page, 0, PADDING, PADDING, blockWidth, blockHeight);
+
+	region.texture = m_NextPage++;
+	region.left = PADDING;
+	region.top = PADDING;
+	newPageWidth = page.m_Width;
+	newPageHeight = page.m_Height;
+	m_PageList.insert(std::pair<int, Page>(region.texture, page));
+}	// Insert
+
+// *******************************************************************
+
+bool TextureAtlas::Remove(int page)
+{
+	std::map<int, Page>::iterator it = m_PageList.find(page);
+	if(it == m_PageList.end())
+		return false;
+
+	if(--it->second.m_NumPictures > 0)
+		return false;
+
+	m_PageList.erase(it);
+	return true;
+}	// Remove
+
+// *******************************************************************
+
+bool TextureAtlas::FindPosition(const Page& page, int width, int height, int& x, int& y, size_t& node)
+{
+	const std::vector<SkylineNode>& skyline = page.m_Skyline;
+	bool found = false;
+
+	for(size_t i=0;i<skyline.size();i++)
+	{
+		// Nodes are left to right, so if it doesn't fit here it won't fit further right
+		int left = skyline[i].x;
+		if(left + width > page.m_Width)
+			break;
+
+		// The block rests on the lowest part of the skyline it spans
+		int top = 0;
+		int widthLeft = width;
+		size_t j = i;
+		while(widthLeft > 0 && j < skyline.size())
+		{
+			top = std::max(top, skyline[j].y);
+			widthLeft -= skyline[j].width;
+			j++;
+		}
+		if(widthLeft > 0 || top + height > page.m_Height)
+			continue;
+
+		if(!found || top < y)
+		{
+			found = true;
+			x = left;
+			y = top;
+			node = i;
+		}
+	}
+	return found;
+}	// FindPosition
+
+// *******************************************************************
+
+void TextureAtlas::AddToSkyline(Page& page, size_t node, int x, int y, int width, int height)
+{
+	std::vector<SkylineNode>& skyline = page.m_Skyline;
+
+	SkylineNode block = {x, y + height, width};
+	skyline.insert(skyline.begin() + node, block);
+
+	// Cut back the nodes the block now covers
+	size_t i = node + 1;
+	while(i < skyline.size())
+	{
+		int blockRight = skyline[i-1].x + skyline[i-1].width;
+		if(skyline[i].x >= blockRight)
+			break;
+
+		int overlap = blockRight - skyline[i].x;
+		skyline[i].x += overlap;
+		skyline[i].width -= overlap;
+		if(skyline[i].width > 0)
+			break;
+		skyline.erase(skyline.begin() + i);
+	}
+
+	// Join neighbours at the same level
+	for(size_t j=0;j+1<skyline.size();)
+	{
+		if(skyline[j].y == skyline[j+1].y)
+		{
+			skyline[j].width += skyline[j+1].width;
+			skyline.erase(skyline.begin() + j + 1);
+		}
+		else
+			j++;
+	}
+}	// AddToSkyline
@@ -0,0 +1,63 @@
+//Created by 16007006
+//Packs pictures into a few large textures ("pages"), so sprites using different
+//pictures can still be drawn in one batch. Only tracks the space - the backend
+//owns the textures and copies the pixels in. Does not depend on Windows.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <map>
+#include "DrawBackend.h"
+
+class TextureAtlas
+{
+public:
+	static const int PAGESIZE = 2048;		// Width and height of a normal page, in texels
+	static const int PADDING = 1;			// Empty texels left around each picture, so filtering does not pick up its neighbours
+
+	// Parameters:
+	//		pageSize	Width and height of a normal page
+	TextureAtlas(int pageSize = PAGESIZE);
+
+	// Postcondition:	Space has been found for a picture of the given size, on the first page
+	//					with room. If no page had room, a new page was started - one bigger than
+	//					normal if the picture would not fit otherwise.
+	//					region is set to the page handle and the position of the picture.
+	//					If a page was started, newPageWidth and newPageHeight are set to its size
+	//					and the caller must create its texture, otherwise they are set to zero.
+	void Insert(int width, int height, DrawRegion& region, int& newPageWidth, int& newPageHeight);
+
+	// Postcondition:	One picture on the page is no longer in use. The space is not reused,
+	//					but when the last picture on a page is removed the page is deleted.
+	// Returns:			true if the page was deleted, so the caller should release its texture
+	bool Remove(int page);
+
+private:
+	// One step of the skyline - the first free row below the packed pictures, over a range of columns
+	struct SkylineNode
+	{
+		int x;
+		int y;
+		int width;
+	};
+
+	struct Page
+	{
+		int m_Width;
+		int m_Height;
+		std::vector<SkylineNode> m_Skyline;		// Left to right, covering the whole page
+		int m_NumPictures;						// Pictures inserted and not yet removed
+	};
+
+	int m_PageSize;
+	std::map<int, Page> m_PageList;		// Pages, by handle
+	int m_NextPage;						// Handle of the next page to be started
+
+	// Finds the topmost, then leftmost, place on the page for a width x height block.
+	// Returns false if there is no room.
+	static bool FindPosition(const Page& page, int width, int height, int& x, int& y, size_t& node);
+
+	// Moves the skyline down over a block placed at x,y starting at the given node
+	static void AddToSkyline(Page& page, size_t node, int x, int y, int width, int height);
+};
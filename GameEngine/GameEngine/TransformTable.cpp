@@ -0,0 +1,100 @@
+//Created by 16007006
+//Structure-of-arrays storage for the position, velocity and angle of every GameObject
+//Each quantity lives in its own contiguous array, indexed by the object's slot in the
+//ObjectManager, so the physics pass can integrate every object in one tight loop.
+
+#include "TransformTable.h"
+
+//SSE is available on every x86 and x64 target. Anything else uses the plain loop,
+//which the compiler is free to vectorise itself.
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define TRANSFORMTABLE_SSE
+#include <xmmintrin.h>
+#endif
+
+TransformTable::TransformTable() {/*Nothing*/}
+TransformTable::~TransformTable() {/*Nothing*/}
+
+void TransformTable::Reserve(int index)
+{
+	if (index < (int)x.size())
+	{
+		return;
+	}
+	//Grow in blocks of four so the SSE loop rarely needs its scalar tail
+	size_t newSize = ((size_t)index + 4) & ~(size_t)3;
+	x.resize(newSize, 0.0f);
+	y.resize(newSize, 0.0f);
+	vx.resize(newSize, 0.0f);
+	vy.resize(newSize, 0.0f);
+	angle.resize(newSize, 0.0f);
+	angularVelocity.resize(newSize, 0.0f);
+	prevX.resize(newSize, 0.0f);
+	prevY.resize(newSize, 0.0f);
+	prevAngle.resize(newSize, 0.0f);
+	simulate.resize(newSize, 0.0f);
+}
+
+void TransformTable::Reset(int index)
+{
+	x[index]               = 0.0f;
+	y[index]               = 0.0f;
+	vx[index]              = 0.0f;
+	vy[index]              = 0.0f;
+	angle[index]           = 0.0f;
+	angularVelocity[index] = 0.0f;
+	prevX[index]           = 0.0f;
+	prevY[index]           = 0.0f;
+	prevAngle[index]       = 0.0f;
+	simulate[index]        = 0.0f;
+}
+
+int TransformTable::Size() const
+{
+	return (int)x.size();
+}
+
+void TransformTable::Integrate(float frameTime)
+{
+	int count = (int)x.size();
+	int i = 0;
+
+#ifdef TRANSFORMTABLE_SSE
+	// *********************************************************************
+	// Four rows at a time *************************************************
+	//  Rows which are not simulated have their step multiplied by zero, so
+	//  every row can be processed without branching.
+	__m128 dt = _mm_set1_ps(frameTime);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 step = _mm_mul_ps(dt, _mm_loadu_ps(&simulate[i]));
+		_mm_storeu_ps(&x[i],     _mm_add_ps(_mm_loadu_ps(&x[i]),     _mm_mul_ps(_mm_loadu_ps(&vx[i]), step)));
+		_mm_storeu_ps(&y[i],     _mm_add_ps(_mm_loadu_ps(&y[i]),     _mm_mul_ps(_mm_loadu_ps(&vy[i]), step)));
+		_mm_storeu_ps(&angle[i], _mm_add_ps(_mm_loadu_ps(&angle[i]), _mm_mul_ps(_mm_loadu_ps(&angularVelocity[i]), step)));
+	}
+#endif
+
+	// *********************************************************************
+	// Remaining rows ******************************************************
+	for (; i < count; i++)
+	{
+		float step = frameTime * simulate[i];
+		x[i]     += vx[i] * step;
+		y[i]     += vy[i] * step;
+		angle[i] += angularVelocity[i] * step;
+	}
+}
+
+void TransformTable::SavePrevious()
+{
+	prevX     = x;
+	prevY     = y;
+	prevAngle = angle;
+}
+
+void TransformTable::SnapPrevious(int index)
+{
+	prevX[index]     = x[index];
+	prevY[index]     = y[index];
+	prevAngle[index] = angle[index];
+}
@@ -0,0 +1,53 @@
+//Created by 16007006
+//Structure-of-arrays storage for the position, velocity and angle of every GameObject
+//Each quantity lives in its own contiguous array, indexed by the object's slot in the
+//ObjectManager, so the physics pass can integrate every object in one tight loop.
+
+#pragma once
+#include <vector>
+
+class TransformTable
+{
+private:
+	std::vector<float> x, y;            //Position
+	std::vector<float> vx, vy;          //Velocity, in units per second
+	std::vector<float> angle;           //Angle, in radians
+	std::vector<float> angularVelocity; //Radians per second
+	std::vector<float> prevX, prevY;    //Position at the start of the last simulation step
+	std::vector<float> prevAngle;       //Angle at the start of the last simulation step
+	std::vector<float> simulate;        //1.0f if the row is moved by Integrate, 0.0f otherwise.
+	                                    //  A float rather than a bool so it can be multiplied in without branching.
+public:
+	TransformTable();  //Constructor
+	~TransformTable(); //Destructor
+
+	void Reserve(int index);   //Makes sure there is a row for index. Existing rows are kept.
+	void Reset(int index);     //Zeroes a row and removes it from the physics pass
+	int Size() const;          //Returns the number of rows
+
+	//Moves every simulated row on by its velocity and angular velocity over frameTime seconds
+	void Integrate(float frameTime);
+
+	//Interpolation - lets rendering run between two simulation steps
+	void SavePrevious();        //Copies every current position and angle into the previous arrays. Call at the start of a step.
+	void SnapPrevious(int index); //Makes the previous transform equal the current one, so a teleport is not drawn as movement
+	float GetInterpolatedX(int index, float alpha) const     { return prevX[index] + (x[index] - prevX[index]) * alpha; }
+	float GetInterpolatedY(int index, float alpha) const     { return prevY[index] + (y[index] - prevY[index]) * alpha; }
+	float GetInterpolatedAngle(int index, float alpha) const { return prevAngle[index] + (angle[index] - prevAngle[index]) * alpha; }
+
+	//Row accessors
+	float GetX(int index) const                     { return x[index]; }
+	float GetY(int index) const                     { return y[index]; }
+	float GetPreviousX(int index) const             { return prevX[index]; }
+	float GetPreviousY(int index) const             { return prevY[index]; }
+	float GetVelocityX(int index) const             { return vx[index]; }
+	float GetVelocityY(int index) const             { return vy[index]; }
+	float GetAngle(int index) const                 { return angle[index]; }
+	float GetAngularVelocity(int index) const       { return angularVelocity[index]; }
+	bool  IsSimulated(int index) const              { return simulate[index] != 0.0f; }
+	void  SetPosition(int index, float newX, float newY)  { x[index] = newX; y[index] = newY; }
+	void  SetVelocity(int index, float newVX, float newVY) { vx[index] = newVX; vy[index] = newVY; }
+	void  SetAngle(int index, float newAngle)               { angle[index] = newAngle; }
+	void  SetAngularVelocity(int index, float newVelocity)  { angularVelocity[index] = newVelocity; }
+	void  SetSimulated(int index, bool simulated)           { simulate[index] = simulated ? 1.0f : 0.0f; }
+};
@@ -0,0 +1,155 @@
+//Created by 16007006
+//Reads are made on the sound engine's audio thread, so nothing here writes to the log
+//except Open, which is called on the main thread.
+
+#include "WavStream.h"
+#include "AssetDecoder.h"
+#include "AssetPack.h"
+#include "errorlogger.h"
+#include <cstring>
+#include <algorithm>
+
+WavStream::WavStream()
+{
+	m_Channels = 0;
+	m_SamplesPerSec = 0;
+	m_BitsPerSample = 0;
+	m_pPacked = nullptr;
+	m_DataOffset = 0;
+	m_DataSize = 0;
+	m_Position = 0;
+	m_Looping = false;
+}
+
+// *******************************************************************
+
+ErrorType WavStream::Open(const wchar_t filename[])
+{
+	m_Filename = filename;
+
+	// Packed - the samples are already mapped
+	AssetPack* pPack = AssetPack::GetInstance();
+	const AssetPackEntry* pEntry = pPack ? pPack->Find(filename) : nullptr;
+	if(pEntry && pEntry->m_Type == ASSET_SOUND)
+	{
+		m_Channels = int(pEntry->m_Channels);
+		m_SamplesPerSec = int(pEntry->m_SamplesPerSec);
+		m_BitsPerSample = int(pEntry->m_BitsPerSample);
+		m_pPacked = (const unsigned char*)pPack->GetData(*pEntry);
+		m_DataSize = size_t(pEntry->m_Size);
+	}
+	else
+	{
+		if(AssetDecoder::ReadWAVFormat(filename, m_Channels, m_SamplesPerSec, m_BitsPerSample, m_DataOffset, m_DataSize) == FAILURE)
+		{
+			ErrorLogger::Write(L"Failed to open music file ");
+			ErrorLogger::Writeln(filename);
+			return FAILURE;
+		}
+		m_File.open(AssetDecoder::NarrowName(filename).c_str(), std::ios::binary);
+	}
+
+	// A trailing part frame is never played
+	size_t frameSize = size_t(m_Channels * m_BitsPerSample / 8);
+	if(frameSize == 0 || m_DataSize < frameSize)
+	{
+		ErrorLogger::Write(L"No samples in music file ");
+		ErrorLogger::Writeln(filename);
+		return FAILURE;
+	}
+	m_DataSize -= m_DataSize % frameSize;
+
+	Rewind();
+	return SUCCESS;
+}	// Open
+
+// *******************************************************************
+
+int WavStream::GetChannels() const
+{
+	return m_Channels;
+}
+
+// *******************************************************************
+
+int WavStream::GetSamplesPerSec() const
+{
+	return m_SamplesPerSec;
+}
+
+// *******************************************************************
+
+int WavStream::GetBitsPerSample() const
+{
+	return m_BitsPerSample;
+}
+
+// *******************************************************************
+
+const wchar_t* WavStream::GetFilename() const
+{
+	return m_Filename.c_str();
+}
+
+// *******************************************************************
+
+void WavStream::Rewind()
+{
+	m_Position = 0;
+	if(!m_pPacked)
+	{
+		m_File.clear();
+		m_File.seekg(std::streamoff(m_DataOffset));
+	}
+}
+
+// *******************************************************************
+
+void WavStream::SetLooping(bool looping)
+{
+	m_Looping = looping;
+}
+
+// *******************************************************************
+
+bool WavStream::IsFinished() const
+{
+	return !m_Looping && m_Position >= m_DataSize;
+}
+
+// *******************************************************************
+
+size_t WavStream::Read(unsigned char dest[], size_t size)
+{
+	size_t frameSize = size_t(m_Channels * m_BitsPerSample / 8);
+	size -= size % frameSize;
+
+	size_t total = 0;
+	while(total < size)
+	{
+		if(m_Position >= m_DataSize)
+		{
+			if(!m_Looping)
+				break;
+			Rewind();
+		}
+
+		size_t count = std::min(size - total, m_DataSize - m_Position);
+		if(m_pPacked)
+		{
+			memcpy(dest + total, m_pPacked + m_Position, count);
+		}
+		else if(!m_File.read((char*)dest + total, std::streamsize(count)))
+		{
+			// File cut short since it was opened - treat it as the end
+			m_DataSize = m_Position + size_t(m_File.gcount());
+			m_DataSize -= m_DataSize % frameSize;
+			count = m_DataSize - m_Position;
+			if(count == 0)
+				break;
+		}
+		total += count;
+		m_Position += count;
+	}
+	return total;
+}	// Read
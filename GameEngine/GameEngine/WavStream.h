@@ -0,0 +1,54 @@
+//Created by 16007006
+//Reads the samples of a PCM WAV file a piece at a time, for music too long to load whole.
+//The samples come from the asset pack's mapping if the file was packed, or else straight
+//from the file. Only the piece asked for is ever in memory. Does not depend on Windows.
+
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include "errortype.h"
+
+class WavStream
+{
+private:
+	std::wstring m_Filename;
+	int m_Channels;
+	int m_SamplesPerSec;
+	int m_BitsPerSample;
+
+	const unsigned char* m_pPacked;		// The samples in the asset pack, or nullptr if read from the file
+	std::ifstream m_File;
+	size_t m_DataOffset;				// Where the samples start in the file
+	size_t m_DataSize;					// In bytes, a whole number of frames
+	size_t m_Position;					// Next byte to read, from the start of the samples
+	bool m_Looping;
+
+public:
+	WavStream();
+
+	// Postcondition:	The file is ready to read from its first sample. If an AssetPack has been
+	//					started and holds a sound packed from a file of this name, that is used instead.
+	// Returns:			SUCCESS, or FAILURE with a message in the log file.
+	ErrorType Open(const wchar_t filename[]);
+
+	int GetChannels() const;
+	int GetSamplesPerSec() const;
+	int GetBitsPerSample() const;
+	const wchar_t* GetFilename() const;
+
+	// Postcondition:	The next Read starts from the first sample
+	void Rewind();
+
+	// If looping, Read goes back to the start when it reaches the end, so the
+	// samples it returns carry on without a gap
+	void SetLooping(bool looping);
+
+	// Returns true if Read has reached the end and is not looping
+	bool IsFinished() const;
+
+	// Postcondition:	Up to size bytes of samples have been copied into dest, always a whole number of frames.
+	// Returns:			The number of bytes copied. Less than size only once the end is reached and not looping.
+	size_t Read(unsigned char dest[], size_t size);
+};
@@ -0,0 +1,132 @@
+//Created by 16007006
+//Workers sleep on a condition variable between batches. Task numbers are handed out
+//with an atomic counter rather than under the lock, so threads finishing small tasks
+//do not queue up behind one another.
+
+#include "WorkerPool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(int numThreads)
+{
+	m_pTask = nullptr;
+	m_NumTasks = 0;
+	m_NextTask = 0;
+	m_Batch = 0;
+	m_Running = 0;
+	m_Stopping = false;
+	m_NumThreads = 1;
+	SetThreadCount(numThreads);
+}
+
+// *******************************************************************
+
+WorkerPool::~WorkerPool()
+{
+	Stop();
+}
+
+// *******************************************************************
+
+void WorkerPool::SetThreadCount(int numThreads)
+{
+	Stop();
+	if(numThreads <= 0)
+		numThreads = std::max(1, int(std::thread::hardware_concurrency()));
+	m_NumThreads = numThreads;
+}
+
+// *******************************************************************
+
+int WorkerPool::GetThreadCount() const
+{
+	return m_NumThreads;
+}
+
+// *******************************************************************
+
+void WorkerPool::Run(int numTasks, const std::function<void(int)>& task)
+{
+	// Not worth waking anyone for
+	if(m_NumThreads <= 1 || numTasks <= 1)
+	{
+		for(int i=0;i<numTasks;i++)
+			task(i);
+		return;
+	}
+
+	if(m_Workers.empty())
+	{
+		m_Stopping = false;
+		for(int i=1;i<m_NumThreads;i++)
+			m_Workers.push_back(std::thread(&WorkerPool::WorkerLoop, this, m_Batch));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_pTask = &task;
+		m_NumTasks = numTasks;
+		m_NextTask = 0;
+		m_Running = int(m_Workers.size());
+		m_Batch++;
+	}
+	m_WorkReady.notify_all();
+
+	RunTasks();
+
+	// Wait for the workers to finish the tasks they took
+	std::unique_lock<std::mutex> lock(m_Lock);
+	m_WorkDone.wait(lock, [this]()
+	{
+		return m_Running == 0;
+	});
+	m_pTask = nullptr;
+}	// Run
+
+// *******************************************************************
+
+void WorkerPool::Stop()
+{
+	if(m_Workers.empty())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Stopping = true;
+	}
+	m_WorkReady.notify_all();
+
+	for(std::thread& worker : m_Workers)
+		worker.join();
+	m_Workers.clear();
+}
+
+// *******************************************************************
+
+void WorkerPool::WorkerLoop(unsigned int lastBatch)
+{
+	std::unique_lock<std::mutex> lock(m_Lock);
+	while(true)
+	{
+		m_WorkReady.wait(lock, [this, lastBatch]()
+		{
+			return m_Stopping || m_Batch != lastBatch;
+		});
+		if(m_Stopping)
+			return;
+		lastBatch = m_Batch;
+
+		lock.unlock();
+		RunTasks();
+		lock.lock();
+
+		if(--m_Running == 0)
+			m_WorkDone.notify_one();
+	}
+}
+
+// *******************************************************************
+
+void WorkerPool::RunTasks()
+{
+	for(int i = m_NextTask++; i < m_NumTasks; i = m_NextTask++)
+		(*m_pTask)(i);
+}
@@ -0,0 +1,62 @@
+//Created by 16007006
+//A small pool of threads for splitting one batch of independent tasks across cores.
+//Run() hands out task numbers to the workers and the calling thread alike, and returns
+//once every task has finished, so the caller sees the batch as one blocking call.
+//The threads are only started by the first batch that can use them. Does not depend on Windows.
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+class WorkerPool
+{
+private:
+	std::vector<std::thread> m_Workers;
+	int m_NumThreads;								// Threads to run batches on, counting the caller
+	std::mutex m_Lock;								// Guards everything below except m_NextTask
+	std::condition_variable m_WorkReady;			// Signalled when a batch starts, or on Stop
+	std::condition_variable m_WorkDone;				// Signalled when the last worker leaves a batch
+	const std::function<void(int)>* m_pTask;		// The batch being run
+	int m_NumTasks;
+	std::atomic<int> m_NextTask;					// Next task number to hand out
+	unsigned int m_Batch;							// Counts batches, so a worker only wakes once for each
+	int m_Running;									// Workers still inside the current batch
+	bool m_Stopping;
+
+	// Each worker thread runs this until the pool is stopped.
+	// lastBatch is the batch count when the thread was made - it works on every batch after that.
+	void WorkerLoop(unsigned int lastBatch);
+
+	// Runs tasks from the current batch until none are left. Called by the workers and the caller.
+	void RunTasks();
+
+public:
+	// numThreads counts the calling thread. If zero, one per core is used.
+	WorkerPool(int numThreads = 0);
+
+	// Stops the threads
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// Postcondition:	The pool will run batches on numThreads threads, counting the caller.
+	//					If zero, one per core is used. Running threads are stopped first.
+	void SetThreadCount(int numThreads);
+
+	// Returns the number of threads batches are run on, counting the caller
+	int GetThreadCount() const;
+
+	// Postcondition:	task has been called once for every number from 0 to numTasks-1, each
+	//					on whichever thread took it. Tasks must not depend on one another.
+	//					Run from one thread at a time.
+	void Run(int numTasks, const std::function<void(int)>& task);
+
+	// Postcondition:	The worker threads have stopped. The next Run starts them again.
+	void Stop();
+};
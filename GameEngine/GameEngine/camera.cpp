@@ -1,3 +1,6 @@
+// Modified by 16007006
+// Builds without Windows, for the headless software renderer
+
 // camera.cpp
 // Shell engine version 2020
 // Chris Rook
@@ -83,11 +86,13 @@ void Camera::Reset()
 		height = pDrawEngine->GetScreenHeight();
 		width = pDrawEngine->GetScreenWidth();	
 	}
+#ifdef _WIN32
 	else					// Use windows instead
 	{
 		width=GetSystemMetrics(SM_CXSCREEN);
 		height = GetSystemMetrics(SM_CYSCREEN);
 	}
+#endif
 
 	m_screenCentre.set(width/2.0f, height/2.0f);
 	m_zoom = height/2000.0f;
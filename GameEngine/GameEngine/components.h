@@ -6,8 +6,8 @@
 #pragma once
 #include "mydrawengine.h"
 #include "mysoundengine.h"
-#include "gametimer.h"
-#include "gamecode.h"
+#include "FrameContext.h"
+#include "CollisionLayers.h"
 
 //Foward-declarations - only referenceed, never used
 class GameObject;
@@ -19,13 +19,14 @@ class ObjectManager;
 
 class Component
 {
-protected:
-	GameTimer timer; //Timer tracking frametime
 public:
 	Component(GameObject* pOwner);
-	~Component();
+	virtual ~Component(); //Virtual so GameObject can delete any component through a Component*
 	GameObject* pOwner;
-	virtual void Update() = 0;
+	virtual void Update(const FrameContext& frame) = 0; //frame is shared by every component in the frame
+	//Components are allocated from the BlockAllocator rather than the heap
+	static void* operator new(size_t size);
+	static void operator delete(void* pMemory, size_t size);
 };
 
 /********************
@@ -45,24 +46,24 @@ public:
 	// Destructor
 	virtual ~InputComponent();
 	
-	void Update() override;
+	void Update(const FrameContext& frame) override;
 };
 
 /*********************
  * PHYSICS COMPONENT *
  *********************/
 
+//Marks its owner to be moved by the ObjectManager's physics pass.
+//  The movement itself is integrated for every object at once in ObjectManager::IntegrateAll
 class PhysicsComponent : public Component
 {
-private:
-	float rotation;
 public:
 	// Constructor
-	PhysicsComponent(GameObject* pOwner, float rotation = 0.0f);
+	PhysicsComponent(GameObject* pOwner, float rotation = 0.0f); //rotation is in radians per second
 	// Destructor
 	~PhysicsComponent();
 	//Functions
-	void Update() override;
+	void Update(const FrameContext& frame) override;
 };
 
 /********************
@@ -81,7 +82,8 @@ public:
 	// Destructor
 	~RenderComponent();
 	//Functions
-	void Update() override;
+	void Update(const FrameContext& frame) override;
+	void Draw(const Vector2D& position, float angle); //Draws the image at the given transform
 	void LoadImg(wchar_t* filename);
 	float GetScale();	
 };
@@ -95,6 +97,10 @@ public:
 //  Super Collision Components such as BoxCollisionComponent and CircleCollisionComponent will destroy their
 //  owner GameObject regardless of what they have collided with.
 //  Subclasses of these root components may overwrite this with their own directed behaviour
+//  Every CollisionComponent sits on a CollisionLayer. ProcessCollision is only called for
+//  objects whose layer reacts to the other object's layer, so it need not check what it hit.
+//  Fast, small objects can be made continuous, so the ObjectManager tests the path they moved
+//  during the step rather than only where they ended up, and they cannot pass through things.
 
 /****************************
  * Root Collision Component *
@@ -102,13 +108,24 @@ public:
 
 class CollisionComponent : public Component
 {
+private:
+	CollisionLayer layer;
+	bool continuous;
 public:
-	CollisionComponent(GameObject* pOwner); //Constructor
-	virtual ~CollisionComponent();          //Destructor
+	CollisionComponent(GameObject* pOwner, CollisionLayer layer); //Constructor
+	virtual ~CollisionComponent();                                //Destructor
 	//Functions
 	virtual void ProcessCollision(GameObject* otherObject);
+	CollisionLayer GetLayer() const;  //Returns the layer the owner collides on
+	void SetContinuous(bool continuous); //Swept collision - off by default
+	bool IsContinuous() const;
 	virtual IShape2D* GetShape() = 0; //Every CollisionComponent will return a shape, 
 	                                  //but the abstract root cannot assume
+	virtual const Rectangle2D& GetBounds() const = 0; //Returns the world-space box enclosing the shape, used by the broadphase
+	//Places the shape and its bounds at the owner's position. The ObjectManager calls this once
+	//  per step after the physics pass, and GetShape and GetBounds return what it placed,
+	//  rather than rebuilding the shape for every pair the object is tested in.
+	virtual void UpdateShape() = 0;
 };
 
 /*******************************
@@ -122,22 +139,27 @@ private:
 	Rectangle2D shape;
 	float width, height;
 public:
-	BoxCollisionComponent(GameObject* pOwner, float width, float height); //Constructor
+	BoxCollisionComponent(GameObject* pOwner, float width, float height, CollisionLayer layer); //Constructor
 	~BoxCollisionComponent();                  //Destructor
 	IShape2D* GetShape() override; //Overrides the abstract superclass to return a rectangle
-	void Update() override; //DEBUG ONLY - Visualises collision shape
+	const Rectangle2D& GetBounds() const override; //The rectangle is already axis-aligned, so is its own bounds
+	void UpdateShape() override;
+	void Update(const FrameContext& frame) override; //DEBUG ONLY - Visualises collision shape
 };
 //Circle-collision uses a circle
 class CircleCollisionComponent : public CollisionComponent
 {
 private:
 	Circle2D shape;
+	Rectangle2D bounds; //Square enclosing the circle
 	float radius;
 public:
-	CircleCollisionComponent(GameObject* pOwner, float radius); //Constructor
+	CircleCollisionComponent(GameObject* pOwner, float radius, CollisionLayer layer); //Constructor
 	~CircleCollisionComponent();                  //Destructor
 	IShape2D* GetShape() override; //Overrides the abstract superclass to return a circle
-	void Update() override; //DEBUG ONLY - Visualises collision shape
+	const Rectangle2D& GetBounds() const override; //Returns the square enclosing the circle
+	void UpdateShape() override;
+	void Update(const FrameContext& frame) override; //DEBUG ONLY - Visualises collision shape
 };
 
 /****************************************
@@ -194,6 +216,6 @@ public:
 	ExpirationComponent(GameObject* pOwner, bool recyclable = false);
 	//Destructor
 	~ExpirationComponent();
-	void Update() override;
+	void Update(const FrameContext& frame) override;
 	void Recycle();
 };
\ No newline at end of file
@@ -9,6 +9,8 @@
 #include "mydrawengine.h"
 #include "mysoundengine.h"
 #include "myinputs.h"
+#include "AssetPack.h"
+#include "AssetLoader.h"
 #include <time.h>
 #include "gametimer.h"
 #include "errorlogger.h"
@@ -18,7 +20,13 @@
 
 Game::Game()
 {
-	// No-op
+	showStats = false;
+	randomSeed = 0;
+	replaying = false;
+	fixedTimestep = true;
+	SetSimulationRate(120.0);
+	accumulator = 0.0;
+	stepsLastFrame = 0;
 }
 
 Game::~Game()
@@ -39,6 +47,28 @@ ErrorType Game::Main()
 	pTheDrawEngine->Flip();
 	pTheDrawEngine->ClearBackBuffer();
 
+	//Hand over anything loaded in the background since the last frame
+	AssetLoader::GetInstance()->Publish();
+
+	//Sample the input once. Everything this frame reads this copy, so a new
+	//  key press is seen the same way by every reader.
+	MyInputs* pInputs = MyInputs::GetInstance();
+	pInputs->SampleFrame();
+	input = pInputs->GetSnapshot();
+
+	//The recording has run out - report how the frames went, and finish
+	if (replaying && !pInputs->IsReplaying())
+	{
+		replaying = false;
+		ErrorLogger::Write(L"Replay mean frame time (ms): ");
+		ErrorLogger::Writeln(timer.getMeanFrameTime() * 1000.0);
+		ErrorLogger::Write(L"Replay frame time jitter (ms): ");
+		ErrorLogger::Writeln(timer.getFrameTimeJitter() * 1000.0);
+		ErrorLogger::Write(L"Replay max overshoot (ms): ");
+		ErrorLogger::Writeln(timer.getMaxOvershoot() * 1000.0);
+		ChangeState(GAMEOVER);
+	}
+
 	ErrorType err=SUCCESS;
 
 	switch(m_currentState)
@@ -104,12 +134,23 @@ void Game::ChangeState(GameState newState)
 // This is called soon after the program runs
 ErrorType Game::Setup(bool bFullScreen, HWND hwnd, HINSTANCE hinstance)
 {
+	// Map the asset pack, if it has been built. Without it, each asset is loaded from its own file.
+	if(AssetPack::Start(L"assets.pak") == FAILURE)
+	{
+		ErrorLogger::Writeln(L"No asset pack - loading assets from their files");
+	}
+
 	// Create the engines - this should be done before creating other DDraw objects
 	if(FAILED(MyDrawEngine::Start(hwnd, bFullScreen)))
 	{
 		ErrorLogger::Writeln(L"Failed to start MyDrawEngine");
 		return FAILURE;
 	}
+	// Pack the game's pictures into the atlas up front. Anything missing is loaded when first used.
+	if(MyDrawEngine::GetInstance()->LoadPictureManifest(L"pictures.txt") == FAILURE)
+	{
+		ErrorLogger::Writeln(L"Could not load every picture in pictures.txt");
+	}
 	if(FAILED(MySoundEngine::Start(hwnd)))
 	{
 		ErrorLogger::Writeln(L"Failed to start MySoundEngine");
@@ -120,9 +161,35 @@ ErrorType Game::Setup(bool bFullScreen, HWND hwnd, HINSTANCE hinstance)
 		ErrorLogger::Writeln(L"Failed to start MyInputs");
 		return FAILURE;
 	}
+	//Worker threads for loading pictures and sounds in the background
+	if(AssetLoader::Start() == FAILURE)
+	{
+		ErrorLogger::Writeln(L"Failed to start AssetLoader");
+		return FAILURE;
+	}
+	//Cap the frame rate at 120Hz. The device presents on vsync, so at 60Hz or below the cap never
+	//waits - it only stops the software backend and high refresh displays drawing frames nobody sees.
+	//mark() sleeps most of the gap and spins the rest - the F1 stats show the jitter that leaves.
+	timer.setMinimumFrameTime(1.0 / 120.0);
+	randomSeed = (unsigned int)time(nullptr);
 	return (SUCCESS);
 }
 
+ErrorType Game::StartRecording(const wchar_t filename[])
+{
+	return MyInputs::GetInstance()->StartRecording(filename, randomSeed);
+}
+
+ErrorType Game::StartReplay(const wchar_t filename[])
+{
+	if (MyInputs::GetInstance()->StartReplay(filename, randomSeed) == FAILURE)
+	{
+		return FAILURE;
+	}
+	replaying = true;
+	return SUCCESS;
+}
+
 
 
 // Terminates the game engines - Draw Engine, Sound Engine, Input Engine
@@ -131,12 +198,15 @@ void Game::Shutdown()
 
 {
    // Any clean up code here 
+	objectManager.DeleteAll(); //Return all objects and components to their pools before the program exits
 
 
 	// (engines must be terminated last)
+	AssetLoader::Terminate();	//Stop loading before the engines it loads into are gone
 	MyDrawEngine::Terminate();
 	MySoundEngine::Terminate();
 	MyInputs::Terminate();
+	AssetPack::Terminate();
 }
 
 
@@ -168,17 +238,12 @@ ErrorType Game::PauseMenu()
 		MyDrawEngine::GetInstance()->WriteText(450,300+50*i, options[i], colour);
 	}
 
-	MyInputs* pInputs = MyInputs::GetInstance();
-
-   // Get user input
-	pInputs->SampleKeyboard();
-
    // Move choice up and down
-	if(pInputs->NewKeyPressed(DIK_UP))
+	if(input.NewKeyPressed(DIK_UP))
 	{
 		m_menuOption--;
 	}
-	if(pInputs->NewKeyPressed(DIK_DOWN))
+	if(input.NewKeyPressed(DIK_DOWN))
 	{
 		m_menuOption++;
 	}
@@ -192,7 +257,7 @@ ErrorType Game::PauseMenu()
 	}
 
    // If player chooses an option ....
-	if(pInputs->NewKeyPressed(DIK_RETURN))
+	if(input.NewKeyPressed(DIK_RETURN))
 	{
 		if(m_menuOption ==0)      // Resume
 		{
@@ -242,15 +307,12 @@ ErrorType Game::MainMenu()
 		MyDrawEngine::GetInstance()->WriteText(450,300+50*i, options[i], colour);
 	}
 
-   // Get keyboard input
-	MyInputs* pInputs = MyInputs::GetInstance();
-
-	pInputs->SampleKeyboard();
-	if(pInputs->NewKeyPressed(DIK_UP))
+   // Keyboard input, sampled in Main
+	if(input.NewKeyPressed(DIK_UP))
 	{
 		m_menuOption--;
 	}
-	if(pInputs->NewKeyPressed(DIK_DOWN))
+	if(input.NewKeyPressed(DIK_DOWN))
 	{
 		m_menuOption++;
 	}
@@ -264,7 +326,7 @@ ErrorType Game::MainMenu()
 	}
 
    // User selects an option
-	if(pInputs->NewKeyPressed(DIK_RETURN))
+	if(input.NewKeyPressed(DIK_RETURN))
 	{
 		if(m_menuOption ==0)          // Play
 		{  
@@ -304,9 +366,27 @@ ErrorType Game::StartOfGame()
    // **********************************************************************
 	//Start Game Timer 
 	timer.mark();
+	timer.resetStats();
+	frame = FrameContext();
+	accumulator = 0.0;
+	//Same rocks and cows every game of a recording or replay, different ones otherwise
+	MyInputs* pInputs = MyInputs::GetInstance();
+	if (!pInputs->IsRecording() && !pInputs->IsReplaying())
+	{
+		randomSeed = (unsigned int)time(nullptr);
+	}
+	srand(randomSeed);
 	//Reset score
 	score = 0;
 
+	//Load everything the game spawns on the worker threads at once, and wait for it here
+	//  rather than stalling the first frame that spawns each object
+	const wchar_t* pictures[] = {L"ufo.bmp", L"rock1.bmp", L"rock2.bmp", L"rock3.bmp", L"rock4.bmp", L"cow.bmp", L"bullet.bmp"};
+	const wchar_t* sounds[] = {L"thrustloop2.wav", L"photon2.wav"};
+	MyDrawEngine::GetInstance()->PrefetchPictures(pictures, sizeof(pictures) / sizeof(pictures[0]));
+	MySoundEngine::GetInstance()->PrefetchSounds(sounds, sizeof(sounds) / sizeof(sounds[0]));
+	AssetLoader::GetInstance()->WaitForAll();
+
 	//Create player, track with pointer. 
 	//  In example game, player is a UFO.
 	pPlayer = objectManager.CreateUFO(Vector2D(-960, 0));
@@ -339,28 +419,94 @@ ErrorType Game::StartOfGame()
 ErrorType Game::Update()
 {
 	// Check for entry to pause menu
-	static bool escapepressed = true;
-	if(KEYPRESSED(VK_ESCAPE))
+	if(input.NewKeyPressed(DIK_ESCAPE))
 	{
-		if(!escapepressed)
-			ChangeState(PAUSED);
-		escapepressed=true;
+		ChangeState(PAUSED);
+	}
+
+	// F1 toggles the collision statistics, F2 cycles through the broadphases
+	if(input.NewKeyPressed(DIK_F1))
+	{
+		showStats = !showStats;
+	}
+
+	if(input.NewKeyPressed(DIK_F2))
+	{
+		objectManager.SetBroadphase(ObjectManager::BroadphaseMode((objectManager.GetBroadphase() + 1) % 3));
 	}
-	else
-		escapepressed=false;
 
 
    // Your code goes here *************************************************
    // *********************************************************************
+	if(input.NewKeyPressed(DIK_F3))
+	{
+		fixedTimestep = !fixedTimestep;
+	}
+
 	timer.mark();
-	objectManager.DeleteInactive(); //Delete all inactive objects
-	objectManager.UpdateAll();      //Update all objects
+	//The recorded frame time while replaying, so the same steps are simulated
+	double frameTime = MyInputs::GetInstance()->RecordFrameTime(timer.mdFrameTime);
+
+	//Give the objects this frame's keys. Presses from frames that ran no step are kept
+	//  until one does, and each step clears them, so a press is acted on exactly once.
+	InputSnapshot stepInput = input;
+	stepInput.MergeEdges(frame.input);
+	frame.input = stepInput;
+	float alpha = 1.0f; //How far between the last two steps to draw the world
+
+	if (fixedTimestep)
+	{
+		//Simulate in fixed steps until the world has caught up with real time.
+		//  If a frame took too long (e.g. dragging the window), drop the extra time rather
+		//  than running ever more steps to catch up.
+		accumulator += frameTime;
+		if (accumulator > MAXSTEPSPERFRAME * simulationStep)
+		{
+			accumulator = MAXSTEPSPERFRAME * simulationStep;
+		}
+
+		stepsLastFrame = 0;
+		while (accumulator >= simulationStep && pPlayer->active)
+		{
+			frame.frameTime = (float)simulationStep; //Timed once here, rather than by every component
+			frame.gameTime += simulationStep;
+			frame.frameNumber++;
+
+			objectManager.DeleteInactive();  //Delete all inactive objects
+			objectManager.UpdateAll(frame);  //Update all objects
+			frame.input.ClearEdges();
+
+			accumulator -= simulationStep;
+			stepsLastFrame++;
+		}
+		//Draw the part of a step which has not been simulated yet
+		alpha = (float)(accumulator / simulationStep);
+	}
+	else
+	{
+		//Variable step - simulate the whole frame at once
+		frame.frameTime = (float)frameTime; //Timed once here, rather than by every component
+		frame.gameTime += frameTime;
+		frame.frameNumber++;
+
+		objectManager.DeleteInactive();  //Delete all inactive objects
+		objectManager.UpdateAll(frame);  //Update all objects
+		frame.input.ClearEdges();
+		stepsLastFrame = 1;
+	}
+	objectManager.RenderAll(alpha);
 
 	//Update Score
-	score += timer.mdFrameTime; //Update score
+	score += frameTime; //Update score
+	AddPoints(objectManager.TakePoints()); //Points awarded by collisions in this frame's steps
 	MyDrawEngine::GetInstance()->WriteText(Vector2D(-250, 1000), L"Score: ", MyDrawEngine::WHITE);
 	MyDrawEngine::GetInstance()->WriteDouble(Vector2D(0, 1000), round(score), MyDrawEngine::WHITE);
 
+	if (showStats)
+	{
+		DrawStats();
+	}
+
 	//If player is dead, end game
 	if (!pPlayer->active)
 	{
@@ -395,6 +541,99 @@ ErrorType Game::EndOfGame()
 	return SUCCESS;
 }
 
+// Draws the counters from the last update and collision check, so the broadphases can be compared
+void Game::DrawStats()
+{
+	MyDrawEngine* pDE = MyDrawEngine::GetInstance();
+	const CollisionStats& stats = objectManager.GetCollisionStats();
+
+	const wchar_t* modeNames[] = {L"All pairs", L"Uniform grid", L"Sweep and prune"};
+	pDE->WriteText(10, 10, L"Broadphase (F2):", MyDrawEngine::WHITE);
+	pDE->WriteText(250, 10, modeNames[objectManager.GetBroadphase()], MyDrawEngine::WHITE);
+	pDE->WriteText(10, 40, L"Objects:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 40, stats.objects, MyDrawEngine::WHITE);
+	pDE->WriteText(10, 70, L"Candidate pairs:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 70, stats.candidatePairs, MyDrawEngine::WHITE);
+	pDE->WriteText(10, 100, L"Pair tests:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 100, stats.pairTests, MyDrawEngine::WHITE);
+	pDE->WriteText(10, 130, L"Collisions:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 130, stats.collisions, MyDrawEngine::WHITE);
+	pDE->WriteText(10, 160, L"Sort swaps:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 160, stats.sortSwaps, MyDrawEngine::WHITE);
+
+	//Average cost of updating one object's components, in microseconds
+	int objectCount = objectManager.GetObjectCount();
+	pDE->WriteText(10, 190, L"Update us/object:", MyDrawEngine::WHITE);
+	pDE->WriteDouble(250, 190, objectCount ? objectManager.GetUpdateTime() * 1000000.0 / objectCount : 0.0, MyDrawEngine::WHITE);
+
+	pDE->WriteText(10, 220, fixedTimestep ? L"Fixed steps (F3):" : L"Variable step (F3):", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 220, stepsLastFrame, MyDrawEngine::WHITE);
+
+	//Frame pacing since the start of the game, in milliseconds
+	pDE->WriteText(10, 250, L"Frame time (ms):", MyDrawEngine::WHITE);
+	pDE->WriteDouble(250, 250, timer.getMeanFrameTime() * 1000.0, MyDrawEngine::WHITE);
+	pDE->WriteText(10, 280, L"Frame jitter (ms):", MyDrawEngine::WHITE);
+	pDE->WriteDouble(250, 280, timer.getFrameTimeJitter() * 1000.0, MyDrawEngine::WHITE);
+
+	//Sprite submission in the last frame
+	int sprites, flushes, batches;
+	pDE->GetSpriteStats(sprites, flushes, batches);
+	pDE->WriteText(10, 310, L"Sprites:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 310, sprites, MyDrawEngine::WHITE);
+	pDE->WriteText(10, 340, L"Sprite flushes:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 340, flushes, MyDrawEngine::WHITE);
+	pDE->WriteText(10, 370, L"Sprite batches:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 370, batches, MyDrawEngine::WHITE);
+
+	//Primitive submission in the last frame
+	int vertices, primitiveFlushes, draws;
+	pDE->GetPrimitiveStats(vertices, primitiveFlushes, draws);
+	pDE->WriteText(10, 400, L"Primitive vertices:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 400, vertices, MyDrawEngine::WHITE);
+	pDE->WriteText(10, 430, L"Primitive draws:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 430, draws, MyDrawEngine::WHITE);
+	pDE->WriteText(10, 460, L"Primitive flushes:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 460, primitiveFlushes, MyDrawEngine::WHITE);
+
+	//Sound loads since the program started
+	int soundHits, soundMisses, sounds;
+	MySoundEngine::GetInstance()->GetCacheStats(soundHits, soundMisses, sounds);
+	pDE->WriteText(10, 490, L"Sound cache hits:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 490, soundHits, MyDrawEngine::WHITE);
+	pDE->WriteText(10, 520, L"Sound cache misses:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 520, soundMisses, MyDrawEngine::WHITE);
+
+	//Overlapping copies of sounds playing now, and copies cut short since the program started
+	int voicesPlaying, voicesStolen, playsDropped;
+	MySoundEngine::GetInstance()->GetVoiceStats(voicesPlaying, voicesStolen, playsDropped);
+	pDE->WriteText(10, 550, L"Sound voices:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 550, voicesPlaying, MyDrawEngine::WHITE);
+	pDE->WriteText(10, 580, L"Voices stolen:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 580, voicesStolen, MyDrawEngine::WHITE);
+
+	//Sound commands sent to the audio thread, and those it could skip
+	int commandsQueued, commandsCoalesced;
+	MySoundEngine::GetInstance()->GetCommandStats(commandsQueued, commandsCoalesced);
+	pDE->WriteText(10, 610, L"Sound commands:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 610, commandsQueued, MyDrawEngine::WHITE);
+	pDE->WriteText(10, 640, L"Commands coalesced:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 640, commandsCoalesced, MyDrawEngine::WHITE);
+
+	//Pairs tested along the path moved, for continuous objects such as bullets
+	pDE->WriteText(10, 670, L"Swept tests:", MyDrawEngine::WHITE);
+	pDE->WriteInt(250, 670, stats.sweptTests, MyDrawEngine::WHITE);
+
+	//Longest any frame has run past the frame limiter's target
+	pDE->WriteText(10, 700, L"Frame overshoot (ms):", MyDrawEngine::WHITE);
+	pDE->WriteDouble(250, 700, timer.getMaxOvershoot() * 1000.0, MyDrawEngine::WHITE);
+}
+
+void Game::SetSimulationRate(double hz)
+{
+	//Anything slower than 10Hz would make collisions unreliable
+	simulationStep = 1.0 / ((hz > 10.0) ? hz : 10.0);
+}
+
 void Game::AddPoints(double points)
 {
 	this->score += points;
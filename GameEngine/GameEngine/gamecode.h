@@ -4,6 +4,8 @@
 //and for Game::AddPoints(points) to increase player's score
 //Header file now contains the following additional variables:
 //  objectManager, pPlayer, score
+//  input - the keyboard, sampled once per frame in Main
+//  randomSeed - seeds rand() for each game, so a recorded session can be replayed
 
 // gamecode.h
 // Shell engine version 2020
@@ -17,6 +19,7 @@
 #include "mydrawengine.h"
 #include "gametimer.h"
 #include "ObjectManager.h"
+#include "FrameContext.h"
 #include <list>
 
 //Forward declare - only referenced, never used
@@ -49,9 +52,20 @@ private:
 	~Game();                       // Destructor
 	Game(Game& other);             // Copy constructor disabled
 	GameTimer timer;               //Timer to keep count of frames
+	FrameContext frame;            //Frame information shared by every object, filled once per simulation step
+	InputSnapshot input;           //The keyboard this frame, sampled once in Main and read by the menus and Update
+	static const int MAXSTEPSPERFRAME = 8; //Spiral-of-death clamp - simulation time beyond this many steps is dropped
+	bool fixedTimestep;            //If true, the world is simulated in fixed steps of simulationStep (toggled with F3)
+	double simulationStep;         //Length of one fixed step in seconds
+	double accumulator;            //Real time not yet simulated, in seconds
+	int stepsLastFrame;            //Simulation steps run in the last rendered frame
 	ObjectManager objectManager;   //Keeps track of all objects
 	GameObject* pPlayer;           //Pointer to player GO
 	double score;                  //Player's accrewed score
+	bool showStats;                //If true, update and collision statistics are drawn over the game (toggled with F1)
+	unsigned int randomSeed;       //Seeds rand() at the start of each game. Kept for a whole recording, and taken from it when replaying.
+	bool replaying;                //True while input is being replayed. The game exits when the replay finishes.
+	void DrawStats();              //Draws the update and collision statistics in the top left of the screen
 
 public:
 	static Game instance;          // Singleton instance
@@ -99,6 +113,19 @@ public:
 	// negative parameters, however, would suffice for subtracting points if needed
 	void AddPoints(double points);
 
+	// Sets how many fixed simulation steps are run per second, e.g. 120.
+	// Only used while fixed timestep mode is on
+	void SetSimulationRate(double hz);
+
+	// Records every frame's input, and the seed of the games played, to the file.
+	// Call after Setup. Returns SUCCESS, or FAILURE with the reason in the log file.
+	ErrorType StartRecording(const wchar_t filename[]);
+
+	// Replays a file made by StartRecording in place of the real input, then writes
+	// the frame-time statistics to the log and exits.
+	// Call after Setup. Returns SUCCESS, or FAILURE with the reason in the log file.
+	ErrorType StartReplay(const wchar_t filename[]);
+
 	//Static method to return a pointer to the current Game instance
 	static Game* GetInstance();
 };
\ No newline at end of file
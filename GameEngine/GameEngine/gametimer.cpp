@@ -1,23 +1,51 @@
+//Modified by 16007006
+//Now uses std::chrono::steady_clock rather than QueryPerformanceCounter, so it also runs on Linux
+//Added a hybrid sleep/spin frame limiter and frame-time jitter statistics
+
 // GameTimer.cpp
 // Shell engine version 2020
 // Chris Rook
 // Last modified 20/09/2018
 
 #include "GameTimer.h"
+#include <thread>
+#include <cmath>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// Limits on how long the hybrid limiter spins after sleeping (in seconds).
+// The margin starts at the maximum and adapts to how accurately the OS actually sleeps.
+static const double MINSLEEPMARGIN = 0.0002;
+static const double MAXSLEEPMARGIN = 0.004;
 
 GameTimer::GameTimer()
 {
-	if(QueryPerformanceFrequency(&freq)==0)		// Find the timer frequency
-	{
-		freq.QuadPart=0;									// Set to zero if function failed
-
-	}
+	last = Clock::now();
 
 	mdGameRate = 1.0;                   // Can adjust this to make the game faster/slower
                                         // Trivial to add functions that let the programmer adjust this.
                                         // I just haven't done it.
 	mdMinimumFrameTime=0;
 	mdFrameTime = 0;
+
+	limiterMode = HYBRID;
+	sleepMargin = MAXSLEEPMARGIN;
+	highResolutionSleep = false;
+	resetStats();
+}
+
+GameTimer::~GameTimer()
+{
+#ifdef _WIN32
+	if (highResolutionSleep)
+	{
+		timeEndPeriod(1);
+	}
+#endif
 }
 
 // Use to set the frameTime. Call this once each frame. 
@@ -32,33 +60,65 @@ GameTimer::GameTimer()
 // will be unreliable.
 void GameTimer::mark()
 {
-
-	if (freq.QuadPart<=0)		// If frequency is zero (if QueryPerformanceCounter failed)
+	if (mdMinimumFrameTime > 0.0)
 	{
-		last.QuadPart=0;			// Set everything to zero. Something is badly wrong.
-		mdFrameTime=0;
+		Wait(last + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(mdMinimumFrameTime)));
 	}
-	else
+
+	Clock::time_point now = Clock::now();
+	double frameTime = std::chrono::duration<double>(now - last).count();
+	Record(frameTime);
+
+	mdFrameTime = frameTime * mdGameRate;
+	last=now;						// Update mark time with current time
+}
+
+void GameTimer::Wait(Clock::time_point target)
+{
+	if (limiterMode == HYBRID)
 	{
-		LARGE_INTEGER now;
-		mdFrameTime=0.0;						      // Set to zero, ready for loop
-		while(mdFrameTime<=mdMinimumFrameTime)	// This is a loop that causes a delay until minimum frame time has elapsed
-                                             // Using "sleep" is just not accurate enough
+		// Sleep until just before the target, leaving sleepMargin to spin
+		double remaining = std::chrono::duration<double>(target - Clock::now()).count();
+		if (remaining > sleepMargin)
 		{
+			double request = remaining - sleepMargin;
+			Clock::time_point sleepStart = Clock::now();
+			std::this_thread::sleep_for(std::chrono::duration<double>(request));
+			double oversleep = std::chrono::duration<double>(Clock::now() - sleepStart).count() - request;
 
-			QueryPerformanceCounter(&now);		// Get current time
-
-			mdFrameTime=(now.QuadPart - last.QuadPart)/(double)freq.QuadPart;
-											// Find time elapsed since last mark, and divide by
-											// frequency to convert to seconds
+			// Widen the margin straight away if the OS overslept, otherwise let it shrink slowly
+			if (oversleep > sleepMargin)
+			{
+				sleepMargin = (oversleep < MAXSLEEPMARGIN) ? oversleep : MAXSLEEPMARGIN;
+			}
+			else
+			{
+				sleepMargin = sleepMargin * 0.99 + oversleep * 0.01;
+				if (sleepMargin < MINSLEEPMARGIN) sleepMargin = MINSLEEPMARGIN;
+			}
 		}
+	}
 
-		mdFrameTime = mdFrameTime * mdGameRate;
-		last=now;						// Update mark time with current time
-
+	// Spin for whatever is left
+	while (Clock::now() < target)
+	{
+		// Busy wait
 	}
 }
 
+void GameTimer::Record(double frameTime)
+{
+	frameCount++;
+	double delta = frameTime - meanFrameTime;
+	meanFrameTime += delta / frameCount;
+	sumSquares += delta * (frameTime - meanFrameTime);
+
+	double overshoot = frameTime - mdMinimumFrameTime;
+	if (mdMinimumFrameTime > 0.0 && overshoot > maxOvershoot)
+	{
+		maxOvershoot = overshoot;
+	}
+}
 
 // Sets the minimum frame time (in seconds). The mark() function will delay until
 // the minimum time has elapsed since the last call to mark().
@@ -68,7 +128,47 @@ void GameTimer::setMinimumFrameTime(double minTime)
 	if(minTime>0.0)      // Can't have a negative minimum time
 	{
 		mdMinimumFrameTime = minTime;
+#ifdef _WIN32
+		// Sleep is only accurate to the system timer period, which defaults to about 15ms
+		if (!highResolutionSleep)
+		{
+			highResolutionSleep = (timeBeginPeriod(1) == TIMERR_NOERROR);
+		}
+#endif
 	}
 	else 
 		mdMinimumFrameTime=0.0;
 }
+
+void GameTimer::setLimiterMode(LimiterMode mode)
+{
+	limiterMode = mode;
+}
+
+GameTimer::LimiterMode GameTimer::getLimiterMode() const
+{
+	return limiterMode;
+}
+
+double GameTimer::getMeanFrameTime() const
+{
+	return meanFrameTime;
+}
+
+double GameTimer::getFrameTimeJitter() const
+{
+	return (frameCount > 1) ? std::sqrt(sumSquares / (frameCount - 1)) : 0.0;
+}
+
+double GameTimer::getMaxOvershoot() const
+{
+	return maxOvershoot;
+}
+
+void GameTimer::resetStats()
+{
+	frameCount = 0;
+	meanFrameTime = 0.0;
+	sumSquares = 0.0;
+	maxOvershoot = 0.0;
+}
@@ -1,3 +1,7 @@
+//Modified by 16007006
+//Now uses std::chrono::steady_clock rather than QueryPerformanceCounter, so it also runs on Linux
+//Added a hybrid sleep/spin frame limiter and frame-time jitter statistics
+
 // GameTimer.h
 // Shell engine version 2020
 // Chris Rook
@@ -6,17 +10,35 @@
 
 #pragma once
 
-#include <windows.h>
+#include <chrono>
 
 // This class will allow you to measure the frame time.
 // Can also be used to measure any other short intervals.
 class GameTimer
 {
+public:
+	// How mark() waits for the minimum frame time
+	//  BUSYWAIT - spins on the clock for the whole wait. Accurate, but uses a full core.
+	//  HYBRID   - sleeps for most of the wait and spins only for the last fraction of
+	//             a millisecond. Nearly as accurate, with the core idle while sleeping.
+	enum LimiterMode{BUSYWAIT, HYBRID};
+
 private:
-	LARGE_INTEGER freq;		// Stores the frequency of the performance counter ("ticks" per second)
-	LARGE_INTEGER last;		// Stores the time of the last mark time (in ticks)
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point last;     // The time of the last mark
 	double mdMinimumFrameTime;	// The minumim frame time that mark() will allow
-				
+	LimiterMode limiterMode;    // How mark() waits for the minimum frame time
+	double sleepMargin;         // Seconds left to spin after sleeping. Grows if the OS oversleeps.
+	bool highResolutionSleep;   // True once the OS timer resolution has been raised for sleeping
+
+	// Frame-time statistics since the last ResetStats(), in unscaled seconds
+	int frameCount;             // Frames measured
+	double meanFrameTime;       // Running mean
+	double sumSquares;          // Running sum of squared differences from the mean (Welford's method)
+	double maxOvershoot;        // Longest time a frame ran past the minimum frame time
+
+	void Wait(Clock::time_point target); // Waits until target using the current limiter mode
+	void Record(double frameTime);       // Adds a frame to the statistics
 
 public:
 	double mdFrameTime;		// The duration between the last two uses of the mark() function in seconds
@@ -31,10 +53,17 @@ public:
 	// Constructor
 	GameTimer();
 
+	// Destructor
+	~GameTimer();
+
 		// Sets the minimum frame time (in seconds). The mark() function will delay until
 		// the minimum time has elapsed since the last call to mark().
 		// If not set, the minimum time is zero.
 	void setMinimumFrameTime(double minTime);
+
+		// Sets how mark() waits for the minimum frame time. Default is HYBRID.
+	void setLimiterMode(LimiterMode mode);
+	LimiterMode getLimiterMode() const;
 							
 // Use to set the frameTime. Call this once each frame. 
 // The function will also delay until the minumum frame time
@@ -47,5 +76,11 @@ public:
 // calls to mark(). Until this function has been called twice, it
 // will be unreliable.
 	void mark();			
+
+	// Frame-time statistics, measured before mdGameRate is applied
+	double getMeanFrameTime() const;    // Average frame time since the last reset
+	double getFrameTimeJitter() const;  // Standard deviation of the frame time since the last reset
+	double getMaxOvershoot() const;     // Longest any frame ran past the minimum frame time
+	void resetStats();                  // Starts the statistics again
 						
 };
@@ -1,3 +1,10 @@
+// Modified by 16007006
+// DrawAt now queues sprites, which are sorted by texture and submitted together by FlushSprites
+// Primitives are queued too, and submitted through one persistent dynamic vertex buffer by FlushPrimitives
+// Pictures are packed into texture atlas pages, and can be preloaded from a manifest with LoadPictureManifest
+// Pictures in the asset pack are copied straight from the mapped pack instead of being loaded from their files
+// LoadPictureAsync decodes pictures on the AssetLoader's worker threads, and PrefetchPictures starts a list of them
+
 // mydrawengine.cpp
 // Shell engine version 2020
 // Chris Rook
@@ -5,7 +12,15 @@
    // Fixed camera not affecting angles
 
 #include "mydrawengine.h"
+#include "SoftwareBackend.h"
+#ifdef _WIN32
+#include "D3D9Backend.h"
+#endif
+#include "AssetPack.h"
+#include "AssetLoader.h"
 #include <algorithm>			// Using find() in DeregisterPicture
+#include <math.h>				// Using sin() and cos() in DrawAt
+#include <fstream>				// Reading the picture manifest
 
 MyDrawEngine* MyDrawEngine::instance=nullptr;
 
@@ -13,8 +28,39 @@ MyDrawEngine* MyDrawEngine::instance=nullptr;
 // Constructors and singleton management
 // *************************************************************
 
-
+#ifdef _WIN32
 ErrorType MyDrawEngine::Start(HWND hwnd, bool bFullScreen)
+{
+	if(StartWithBackend(new D3D9Backend(hwnd)) == FAILURE)
+		return FAILURE;
+
+	// If user has requested windowed mode
+	if(!bFullScreen)
+		instance->GoWindowed();
+
+	// Clear everything
+	instance->Flip();
+	instance->ClearBackBuffer();
+
+	return SUCCESS;
+}		// Start
+#endif
+
+// **************************************************************
+
+ErrorType MyDrawEngine::StartHeadless(int width, int height)
+{
+	if(StartWithBackend(new SoftwareBackend(width, height)) == FAILURE)
+		return FAILURE;
+
+	instance->ClearBackBuffer();
+
+	return SUCCESS;
+}		// StartHeadless
+
+// **************************************************************
+
+ErrorType MyDrawEngine::StartWithBackend(DrawBackend* pBackend)
 {
 	if(instance)		// If an instance already exists
 	{
@@ -22,9 +68,9 @@ ErrorType MyDrawEngine::Start(HWND hwnd, bool bFullScreen)
 	}
 	 
 	// Create the instance
-	instance= new MyDrawEngine(hwnd);
+	instance= new MyDrawEngine(pBackend);
 	// Start the window for Windows
-	if(FAILED(instance->StartWindow()))
+	if(instance->StartWindow() == FAILURE)
 	{
 		ErrorLogger::Writeln(L"Failed to start the MyDrawEngine window");
 		return FAILURE;
@@ -32,17 +78,9 @@ ErrorType MyDrawEngine::Start(HWND hwnd, bool bFullScreen)
 
 	// Start a default font
 	instance->AddFont(L"Ariel", 24, false, false);
-	
-	// If user has requested windowed mode
-	if(!bFullScreen)
-		instance->GoWindowed();
-
-	// Clear everything
-	instance->Flip();
-	instance->ClearBackBuffer();
 
 	return SUCCESS;
-}		// Start
+}		// StartWithBackend
 
 // **************************************************************
 
@@ -70,16 +108,10 @@ ErrorType MyDrawEngine::Terminate()
 // **************************************************************
 
 // Constructor
-// width - screen resolution width
-// height  - screen resolution height
-// hwnd - handle to the Window
-MyDrawEngine::MyDrawEngine(HWND hwnd)
+// pBackend - the backend to draw with
+MyDrawEngine::MyDrawEngine(DrawBackend* pBackend)
 {
-	// Set pointers to NULL
-	m_lpD3D = nullptr;
-	m_lpD3DDevice = nullptr;
-
-	m_Hwnd = hwnd;				   // Remember the window handle
+	m_pBackend = pBackend;		// Remember the backend
 
 	m_bFullScreen = true;		// Start off fullscreen
 
@@ -89,10 +121,25 @@ MyDrawEngine::MyDrawEngine(HWND hwnd)
 	// First image to be created will be at position 1
 	m_NextPictureIndex=1;
 
-	m_lpSprite = nullptr;
-
 	m_CameraActive = true;
 
+	m_ScreenWidth = 0;
+	m_ScreenHeight = 0;
+
+	m_FrameSprites = 0;
+	m_FrameFlushes = 0;
+	m_FrameBatches = 0;
+	m_LastFrameSprites = 0;
+	m_LastFrameFlushes = 0;
+	m_LastFrameBatches = 0;
+
+	m_FramePrimitiveVertices = 0;
+	m_FramePrimitiveFlushes = 0;
+	m_FramePrimitiveDraws = 0;
+	m_LastFramePrimitiveVertices = 0;
+	m_LastFramePrimitiveFlushes = 0;
+	m_LastFramePrimitiveDraws = 0;
+
 }		// Constructor
 
 // *******************************************************************
@@ -108,64 +155,13 @@ MyDrawEngine::~MyDrawEngine()
 // Starts the window
 ErrorType MyDrawEngine::StartWindow()
 {
-	// Connect to direct 3D 9
-	m_lpD3D=Direct3DCreate9(D3D_SDK_VERSION);
-	if (m_lpD3D == nullptr)
-	{
-		ErrorLogger::Writeln(L"Could not connect to Direct3D");
-		return FAILURE;		            // No point going any further
-	}
-
 	// Get native resolution
-	m_NativeScreenWidth=GetSystemMetrics(SM_CXSCREEN);
-	m_NativeScreenHeight = GetSystemMetrics(SM_CYSCREEN);
+	m_pBackend->GetNativeResolution(m_NativeScreenWidth, m_NativeScreenHeight);
 
 	m_ScreenHeight = m_NativeScreenHeight;
 	m_ScreenWidth = m_NativeScreenWidth;
 
-	// Set the presentation parameters options
-	D3DPRESENT_PARAMETERS d3dpp;		         // Order form for options
-	ZeroMemory(&d3dpp, sizeof(d3dpp));	      // Set it all to zero
-
-	d3dpp.Windowed = false;				         // Whatever the user requested
-	d3dpp.SwapEffect = D3DSWAPEFFECT_FLIP;	   // Slightly slower, but allows access to previous back buffer if ever needed.
-	d3dpp.hDeviceWindow = m_Hwnd;			      // Handle to the window
-	d3dpp.BackBufferWidth = m_ScreenWidth;	   // Requested screen width
-	d3dpp.BackBufferHeight = m_ScreenHeight;  // Requested screen height
-	d3dpp.BackBufferFormat = D3DFMT_X8R8G8B8; // Back buffer formattaed to 32 bit XRGB
-
-	// Create the device
-	HRESULT err;			// To store the error result
-	err=m_lpD3D->CreateDevice(D3DADAPTER_DEFAULT,		// Default graphics adapter
-                      D3DDEVTYPE_HAL,			// Requesting hardware abstraction layer
-                      m_Hwnd,					   // Handle to the window. Again.
-                      D3DCREATE_MIXED_VERTEXPROCESSING,	// Process vertices in software !!!!!!
-                      &d3dpp,					   // The presentation parameters
-                      &m_lpD3DDevice);			// Pointer to the device
-
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to create the device");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		m_lpD3D->Release();
-		m_lpD3D=nullptr;
-		return FAILURE;		// No point going any further
-	}
-
-	err = D3DXCreateSprite(m_lpD3DDevice, &m_lpSprite );
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to create sprite");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-
-		m_lpD3D->Release();
-		m_lpD3D=nullptr;
-		m_lpD3DDevice->Release();
-		m_lpD3DDevice = nullptr;
-		return FAILURE;		// No point going any further
-	}
-
-	return SUCCESS;
+	return m_pBackend->Start(m_ScreenWidth, m_ScreenHeight, m_bFullScreen);
 }		// Start window
 
 // ********************************************************************
@@ -173,30 +169,14 @@ ErrorType MyDrawEngine::StartWindow()
 // Release the engine
 ErrorType MyDrawEngine::Release()
 {
-	// Release fonts and bitmaps
-	ReleaseBitmaps();
-	ReleaseFonts();
-
-	// Release the sprite
-	if(m_lpSprite)
-	{
-		m_lpSprite->Release();
-		m_lpSprite = nullptr;
-	}
-
-	// Release Direct3D interface
-	if(m_lpD3D)
-	{
-		m_lpD3D->Release();
-		m_lpD3D = nullptr;
-	}
+	// Anything queued refers to textures which are about to go
+	m_SpriteQueue.clear();
+	m_PrimitiveQueue.clear();
+	m_PrimitiveRuns.clear();
 
-	// Release the graphics device
-	if(m_lpD3DDevice)
-	{
-		m_lpD3DDevice->Release();
-		m_lpD3DDevice = nullptr;
-	}
+	// The backend releases all textures, fonts and its device
+	delete m_pBackend;
+	m_pBackend = nullptr;
 
 	return SUCCESS;
 }	// Release
@@ -209,150 +189,17 @@ ErrorType MyDrawEngine::Release()
 // Resets the device if it goes FUBAR or when switching fullscreen/windowed
 ErrorType MyDrawEngine::ResetDevice()
 {
-// Set the presentation parameters options
-	D3DPRESENT_PARAMETERS d3dpp;			      // Order form
-	ZeroMemory(&d3dpp, sizeof(d3dpp));		   // Set it all to zero
-
-	d3dpp.Windowed = !m_bFullScreen;			   // Whatever the user requested
-	d3dpp.SwapEffect = D3DSWAPEFFECT_FLIP;	   // Slightly slower, but allows access to previous back buffer if ever needed.
-	d3dpp.hDeviceWindow = m_Hwnd;			      // Handle to the window
-	d3dpp.BackBufferWidth = m_ScreenWidth;	   // Requested screen width
-	d3dpp.BackBufferHeight = m_ScreenHeight;	// Requested screen height
-	d3dpp.BackBufferFormat = D3DFMT_X8R8G8B8;	// Format is 32 bit XRGB
-
-	// Need to release all bitmaps and fonts
-	ReleaseBitmaps();
-	ReleaseFonts();
-	if(m_lpSprite)
-		m_lpSprite->Release();
-	m_lpSprite = nullptr;
-
-	// Reset the device
-	HRESULT err = m_lpD3DDevice->Reset(&d3dpp);
+	// Anything queued was meant for the old back buffer
+	m_SpriteQueue.clear();
+	m_PrimitiveQueue.clear();
+	m_PrimitiveRuns.clear();
 
-	// Did it work?
-	if(FAILED(err))
-	{
-		// Big trouble.
-		ErrorLogger::Writeln(L"Failed to reset device.");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-	}
-
-	// Now can reload the bitmaps and fonts.
-	ReloadBitmaps();
-	ReloadFonts();
-
-	HRESULT err2 = D3DXCreateSprite(m_lpD3DDevice, &m_lpSprite );
-	if(FAILED(err2))
-	{
-		ErrorLogger::Writeln(L"Failed to create sprite on device reset");
-		ErrorLogger::Writeln(ERRORSTRING(err2));
-	}
-
-	// Position the window in case needed
-    SetWindowPos(m_Hwnd, HWND_NOTOPMOST,
-                     0, 0,
-                     m_ScreenWidth,
-                     m_ScreenHeight,
-                     SWP_SHOWWINDOW);
-
-	if(FAILED(err))
-		return FAILURE;
-	else
-		return SUCCESS;
+	// The backend keeps its texture and font handles valid across the reset
+	return m_pBackend->Reset(m_ScreenWidth, m_ScreenHeight, m_bFullScreen);
 }		// ResetDevice
 
 // ****************************************************************
 
-
-// Releases all bitmaps. Used on shutdown and when resetting device.
-// Does not delete them from the map!
-void MyDrawEngine::ReleaseBitmaps()
-{
-	// Start at the beginning
-	std::map<PictureIndex, MyPicture>::iterator picit = m_MyPictureList.begin();
-
-	// Loop through all bitmaps
-	for(;picit!=m_MyPictureList.end();picit++)
-	{
-		if(picit->second.lpTheTexture)
-			picit->second.lpTheTexture->Release();
-		picit->second.lpTheTexture = nullptr;
-	}
-}	// Release bitmaps
-
-// *******************************************************
-
-// Reload all bitmaps. Needed after resetting the device
-void MyDrawEngine::ReloadBitmaps()
-{
-	// Start at the beginning
-	std::map<PictureIndex, MyPicture>::iterator it = m_MyPictureList.begin();
-
-	// Loop through all bitmaps
-	for(;it!=m_MyPictureList.end();it++)
-	{
-		// Could be faster by loading in-place, but file loading is much slower anyway
-		ReloadPicture(it->first);
-	}
-}	// ReloadBitmaps
-
-// ******************************************************
-
-// Releases all fonts. Does not delete them from the map.
-// Needed when resetting device or on shutdown
-void MyDrawEngine::ReleaseFonts()
-{
-	// Start at the beginning
-	std::map<FontIndex, MyFont>::iterator fit = m_MyFontList.begin();
-
-	// Loop through all fonts
-	for(;fit!=m_MyFontList.end();fit++)
-	{
-		if(fit->second.m_pFont)
-			fit->second.m_pFont->Release();
-		fit->second.m_pFont = nullptr;
-	}
-}	// ReleaseFonts
-
-// *********************************************************
-
-
-// Reload all fonts. Needed after resetting the device
-void MyDrawEngine::ReloadFonts()
-{
-	// Start at the beginning
-	std::map<FontIndex, MyFont>::iterator fit = m_MyFontList.begin();
-
-	// Loop through fonts
-	for(;fit!=m_MyFontList.end();fit++)
-	{
-		MyFont& currentFont = fit->second;
-
-		// Set requested boldness
-		UINT boldness =FW_MEDIUM;
-		if(fit->second.m_bold == true)
-			boldness = FW_BOLD;
-
-		HRESULT err;
-
-		// Create a font, using recorded parameters from when first loaded
-		err = D3DXCreateFont(m_lpD3DDevice, currentFont.m_height, 0, boldness, 0, currentFont.m_italic, 
-			DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, DEFAULT_QUALITY, 
-			DEFAULT_PITCH | FF_DONTCARE, currentFont.m_fontName.c_str(), &currentFont.m_pFont );
-
-		if(FAILED(err))
-		{
-			ErrorLogger::Write(L"Failed to reload a font - ");
-			ErrorLogger::Writeln(currentFont.m_fontName.c_str());
-			ErrorLogger::Writeln(ERRORSTRING(err));
-		}
-	}
-}	// Reload fonts
-
-
-// **************************************************************
-
 // Switch to windowed mode
 ErrorType MyDrawEngine::GoWindowed()
 {
@@ -366,13 +213,13 @@ ErrorType MyDrawEngine::GoWindowed()
 	m_bFullScreen = false;
 
 	// Reset the device
-	HRESULT err= ResetDevice();
+	ErrorType err= ResetDevice();
 
 	// Clear the screen
 	Flip();
 	ClearBackBuffer();
 
-	if(FAILED(err))
+	if(err == FAILURE)
 	{
 		return FAILURE;
 	}
@@ -401,13 +248,13 @@ ErrorType MyDrawEngine::GoFullScreen()
 
 	// Reset the graphics card
    // This includes reloading everything
-	HRESULT err= ResetDevice();
+	ErrorType err= ResetDevice();
 
 	// Clear screen to get rid of anomalies
 	Flip();
 	ClearBackBuffer();
 
-	if(FAILED(err))
+	if(err == FAILURE)
 		return FAILURE;
 	else
 		return SUCCESS;
@@ -434,7 +281,7 @@ ErrorType MyDrawEngine::ChangeResolution(int width, int height)
 	ErrorType err = ResetDevice();
 
    // It could not reset
-	if(FAILED(err))
+	if(err == FAILURE)
 	{
       // Change back to old configuration
 		m_ScreenWidth = oldWidth;
@@ -456,7 +303,7 @@ ErrorType MyDrawEngine::ChangeToNativeResolution()
 
 	ErrorType err = ResetDevice();
 
-	if(FAILED(err))         // It could not reset
+	if(err == FAILURE)         // It could not reset
 	{
 		m_ScreenWidth = oldWidth;
 		m_ScreenHeight = oldHeight;	
@@ -469,60 +316,15 @@ ErrorType MyDrawEngine::ChangeToNativeResolution()
 
 // *******************************************************************
 
-// Reloads a picture - used when resetting the device
-ErrorType MyDrawEngine::ReloadPicture(PictureIndex pic)
-{
-	// Set the iterator to the row we are looking for in the list of pictures.
-	std::map<PictureIndex, MyPicture>::iterator picit = m_MyPictureList.find(pic);
-
-	// If could not find the picture requested.
-	if(picit==m_MyPictureList.end())
-	{
-		ErrorLogger::Writeln(L"Attempting to reload an invalid PictureIndex in RelocadPicture.");
-		return FAILURE;
-	}
-
-	// Release the old picture if it is present.
-	if(picit->second.lpTheTexture)
-	{
-		picit->second.lpTheTexture->Release();
-		picit->second.lpTheTexture = nullptr;
-	}
-
-	// Reload the picture using mostly default settings
-	HRESULT err = D3DXCreateTextureFromFileEx(m_lpD3DDevice,
-		(picit->second.m_SourceFileName).c_str(), D3DX_DEFAULT, D3DX_DEFAULT, 1, 0, D3DFMT_UNKNOWN, D3DPOOL_DEFAULT,
-		D3DX_FILTER_LINEAR, D3DX_FILTER_LINEAR,
-		0xff000000,				// Colour key is black
-		NULL, NULL,
-		&(picit->second.lpTheTexture) );
-
-	if(FAILED(err))
-	{
-		ErrorLogger::Write(L"Failed to create texture from file in ReloadPicture: ");
-		ErrorLogger::Writeln(picit->second.m_SourceFileName.c_str());
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-
-	return SUCCESS;
-}		// Reload picture
-
-// ***********************************************************************
-
 //Clears the back buffer
 ErrorType MyDrawEngine::ClearBackBuffer()
 {
-	//Clear
-	HRESULT err = m_lpD3DDevice->Clear(0, NULL, D3DCLEAR_TARGET, 0,1.0f,0);
+	// Anything still queued belongs to the frame being cleared
+	FlushSprites();
+	FlushPrimitives();
 
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Could not clear the back buffer.");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-	return SUCCESS;
+	//Clear
+	return m_pBackend->Clear();
 }	// ClearBackBuffer
 
 
@@ -532,31 +334,32 @@ ErrorType MyDrawEngine::ClearBackBuffer()
 // Presents the Back Buffer and starts new scene
 ErrorType MyDrawEngine::Flip()
 {
-	HRESULT err;		// To store error result
-
-	// End the scene
-	m_lpD3DDevice->EndScene();
-	// Present
-	err= m_lpD3DDevice->Present(NULL, NULL, NULL, NULL);
-
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Could not flip.");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
+	// Draw whatever is still queued, and start counting the next frame
+	FlushSprites();
+	FlushPrimitives();
+	m_LastFrameSprites = m_FrameSprites;
+	m_LastFrameFlushes = m_FrameFlushes;
+	m_LastFrameBatches = m_FrameBatches;
+	m_FrameSprites = 0;
+	m_FrameFlushes = 0;
+	m_FrameBatches = 0;
+	m_LastFramePrimitiveVertices = m_FramePrimitiveVertices;
+	m_LastFramePrimitiveFlushes = m_FramePrimitiveFlushes;
+	m_LastFramePrimitiveDraws = m_FramePrimitiveDraws;
+	m_FramePrimitiveVertices = 0;
+	m_FramePrimitiveFlushes = 0;
+	m_FramePrimitiveDraws = 0;
+
+	// Present, and start the next scene
+	return m_pBackend->Present();
+}	// Flip
 
-	// Start the next one
-	m_lpD3DDevice->BeginScene();
+// *****************************************************************
 
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Could not start new scene after flip.");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-	return SUCCESS;
-}	// Flip
+unsigned long long MyDrawEngine::GetFrameChecksum() const
+{
+	return m_pBackend->GetFrameChecksum();
+}
 
 // **************************************************************
 // Camera visibility information
@@ -626,29 +429,27 @@ PictureIndex MyDrawEngine::LoadPicture(wchar_t* filename)
 		MyPicture tempMyPicture;			// To store picture if it ever loads
 		tempMyPicture.m_SourceFileName = filename;	// Remember the filename
 
-		// Load the picture using mostly default settings
-		HRESULT err = D3DXCreateTextureFromFileEx(m_lpD3DDevice,
-			filename, D3DX_DEFAULT, D3DX_DEFAULT, 1, 0, D3DFMT_UNKNOWN, D3DPOOL_DEFAULT,
-			D3DX_FILTER_LINEAR, D3DX_FILTER_LINEAR,
-			0xff000000,				         // Colour key is black
-			NULL, NULL,
-			&tempMyPicture.lpTheTexture);
-
-		if (FAILED(err))		            // Probably a bad filename
+		// Load the picture into the atlas and record the height and width.
+		// If it is in the asset pack, the pixels are already decoded, so they are copied
+		// straight from the pack. Otherwise the file is loaded.
+		// The backend writes the reason to the log file if it fails.
+		AssetPack* pPack = AssetPack::GetInstance();
+		const AssetPackEntry* pEntry = pPack ? pPack->Find(filename) : nullptr;
+		ErrorType loaded;
+		if (pEntry && pEntry->m_Type == ASSET_PICTURE)
+			loaded = m_pBackend->LoadPictureData((const unsigned int*)pPack->GetData(*pEntry), pEntry->m_Width, pEntry->m_Height,
+				tempMyPicture.m_Picture, tempMyPicture.m_Region);
+		else
+			loaded = m_pBackend->LoadPicture(filename, tempMyPicture.m_Picture, tempMyPicture.m_Region);
+
+		if (loaded == FAILURE)
 		{
 			ErrorLogger::Write(L"Failed to create texture from file: ");
 			ErrorLogger::Writeln(filename);
-			ErrorLogger::Writeln(ERRORSTRING(err));
 			return 0;			            // Return zero if couldn't load
 		}
-
-		// Get information from the picture
-		D3DSURFACE_DESC desc;
-		tempMyPicture.lpTheTexture->GetLevelDesc(0, &desc);
-
-		// Record the height and width
-		tempMyPicture.m_height = desc.Height;
-		tempMyPicture.m_width = desc.Width;
+		tempMyPicture.m_width = tempMyPicture.m_Region.width;
+		tempMyPicture.m_height = tempMyPicture.m_Region.height;
 
 		// Set the default centre in the middle of the picture
 		tempMyPicture.m_Centre.set(float(tempMyPicture.m_width / 2), float(tempMyPicture.m_height / 2));
@@ -666,6 +467,173 @@ PictureIndex MyDrawEngine::LoadPicture(wchar_t* filename)
 
 // ****************************************************************
 
+// Loads every picture in a manifest, tallest first. The atlas packs
+// rows of similar height much more tightly than pictures in random order.
+ErrorType MyDrawEngine::LoadPictureManifest(const wchar_t manifest[])
+{
+	// File names are plain ASCII
+	std::string narrowName;
+	for(const wchar_t* p = manifest; *p; p++)
+		narrowName += char(*p);
+
+	std::ifstream file(narrowName.c_str());
+	if(!file)
+	{
+		ErrorLogger::Write(L"Failed to open picture manifest: ");
+		ErrorLogger::Writeln(manifest);
+		return FAILURE;
+	}
+
+	// A picture to load, and its size
+	struct ManifestEntry
+	{
+		std::wstring m_Filename;
+		int m_width;
+		int m_height;
+	};
+	std::vector<ManifestEntry> entries;
+	ErrorType result = SUCCESS;
+
+	// Read the list, and the size of each picture
+	std::string line;
+	while(std::getline(file, line))
+	{
+		// Trim, and skip blanks and comments
+		size_t first = line.find_first_not_of(" \t\r");
+		if(first == std::string::npos || line[first] == '#')
+			continue;
+		size_t last = line.find_last_not_of(" \t\r");
+
+		ManifestEntry entry;
+		entry.m_Filename.assign(line.begin() + first, line.begin() + last + 1);
+
+		// The pack already knows the size
+		AssetPack* pPack = AssetPack::GetInstance();
+		const AssetPackEntry* pEntry = pPack ? pPack->Find(entry.m_Filename.c_str()) : nullptr;
+		if(pEntry && pEntry->m_Type == ASSET_PICTURE)
+		{
+			entry.m_width = pEntry->m_Width;
+			entry.m_height = pEntry->m_Height;
+		}
+		else if(m_pBackend->GetPictureSize(entry.m_Filename.c_str(), entry.m_width, entry.m_height) == FAILURE)
+		{
+			ErrorLogger::Write(L"Could not read picture in manifest: ");
+			ErrorLogger::Writeln(entry.m_Filename.c_str());
+			result = FAILURE;
+			continue;
+		}
+		entries.push_back(entry);
+	}
+
+	std::stable_sort(entries.begin(), entries.end(), [](const ManifestEntry& a, const ManifestEntry& b)
+	{
+		if(a.m_height != b.m_height)
+			return a.m_height > b.m_height;
+		return a.m_width > b.m_width;
+	});
+
+	for(ManifestEntry& entry : entries)
+	{
+		if(LoadPicture(&entry.m_Filename[0]) == 0)
+			result = FAILURE;
+	}
+
+	return result;
+}		// LoadPictureManifest
+
+// ****************************************************************
+
+// Reserves a PictureIndex and has the AssetLoader decode the file
+PictureIndex MyDrawEngine::LoadPictureAsync(const wchar_t filename[])
+{
+	// Already loaded, or already loading
+	std::map<std::wstring, PictureIndex>::iterator picit = m_FilenameList.find(filename);
+	if (picit != m_FilenameList.end())
+	{
+		return picit->second;
+	}
+
+	// Packed pictures need no decoding, so there is nothing to gain from a worker
+	AssetPack* pPack = AssetPack::GetInstance();
+	const AssetPackEntry* pEntry = pPack ? pPack->Find(filename) : nullptr;
+	AssetLoader* pLoader = AssetLoader::GetInstance();
+	if (!pLoader || (pEntry && pEntry->m_Type == ASSET_PICTURE))
+	{
+		return LoadPicture(const_cast<wchar_t*>(filename));
+	}
+
+	// Reserve the index. It is filled in by FinishPicture.
+	MyPicture tempMyPicture;
+	tempMyPicture.m_SourceFileName = filename;
+	tempMyPicture.m_Loading = true;
+
+	PictureIndex pic = m_NextPictureIndex++;
+	m_MyPictureList.insert(std::pair<PictureIndex, MyPicture>(pic, tempMyPicture));
+	m_FilenameList.insert(std::pair<std::wstring, PictureIndex>(filename, pic));
+
+	pLoader->Queue(ASSET_PICTURE, filename, [this, pic](const LoadedAsset& asset)
+	{
+		FinishPicture(pic, asset);
+	});
+
+	return pic;
+}		// LoadPictureAsync
+
+// ****************************************************************
+
+void MyDrawEngine::PrefetchPictures(const wchar_t* const filenames[], int count)
+{
+	for(int i=0;i<count;i++)
+	{
+		LoadPictureAsync(filenames[i]);
+	}
+}		// PrefetchPictures
+
+// ****************************************************************
+
+// Called by AssetLoader::Publish once a worker has decoded the picture
+void MyDrawEngine::FinishPicture(PictureIndex pic, const LoadedAsset& asset)
+{
+	// The picture may have been released while it was loading
+	std::map<PictureIndex, MyPicture>::iterator picit = m_MyPictureList.find(pic);
+	if(picit==m_MyPictureList.end() || !picit->second.m_Loading)
+	{
+		return;
+	}
+
+	MyPicture& thePicture = picit->second;		// Reference to the picture for easy coding
+	thePicture.m_Loading = false;
+
+	// The decoder only reads BMP files. Anything else is left to the backend.
+	ErrorType loaded;
+	if(asset.m_Result == SUCCESS)
+		loaded = m_pBackend->LoadPictureData(asset.m_Pixels.data(), asset.m_Width, asset.m_Height,
+			thePicture.m_Picture, thePicture.m_Region);
+	else
+		loaded = m_pBackend->LoadPicture(asset.m_Filename.c_str(), thePicture.m_Picture, thePicture.m_Region);
+
+	if(loaded == FAILURE)
+	{
+		ErrorLogger::Write(L"Failed to create texture from file: ");
+		ErrorLogger::Writeln(asset.m_Filename.c_str());
+
+		// Forget it, as LoadPicture would have
+		m_FilenameList.erase(thePicture.m_SourceFileName);
+		m_MyPictureList.erase(picit);
+		return;
+	}
+	thePicture.m_width = thePicture.m_Region.width;
+	thePicture.m_height = thePicture.m_Region.height;
+
+	// Set the default centre in the middle of the picture, unless SetCentre was called while it loaded
+	if(thePicture.m_Centre.XValue == 0.0f && thePicture.m_Centre.YValue == 0.0f)
+	{
+		thePicture.m_Centre.set(float(thePicture.m_width / 2), float(thePicture.m_height / 2));
+	}
+}		// FinishPicture
+
+// ****************************************************************
+
 // Request the size of a picture
 void MyDrawEngine::GetDimensions(PictureIndex pic, int& height, int& width)
 {
@@ -720,6 +688,9 @@ ErrorType MyDrawEngine::SetCentre(PictureIndex pic, Vector2D centre)
 // Release a picture from memory
 void MyDrawEngine::ReleasePicture(PictureIndex pic)
 {
+	// The queue may still hold this texture
+	FlushSprites();
+
 	// Find the picture in the map
 	std::map<PictureIndex, MyPicture>::iterator picit = m_MyPictureList.find(pic);
 
@@ -730,12 +701,16 @@ void MyDrawEngine::ReleasePicture(PictureIndex pic)
 		return;
 	}
 
-	// Release it and set to null
-	if(picit->second.lpTheTexture)
-		picit->second.lpTheTexture->Release();
-	picit->second.lpTheTexture = nullptr;
+	// Release it. If it is still loading there is nothing to release yet,
+	// and FinishPicture will find the index gone.
+	if(picit->second.m_Picture)
+	{
+		m_pBackend->ReleasePicture(picit->second.m_Picture);
+	}
+	picit->second.m_Picture = 0;
 
-	// Remove it from the map
+	// Remove it from the maps, so the file can be loaded again
+	m_FilenameList.erase(picit->second.m_SourceFileName);
 	m_MyPictureList.erase(picit);
 
 }		// ReleasePicture
@@ -752,38 +727,17 @@ void MyDrawEngine::ReleasePicture(PictureIndex pic)
 // Add a new font to the engine
 FontIndex MyDrawEngine::AddFont(wchar_t* FontName, int height, bool bold, bool italic)
 {
-	MyFont temp;			// To hold the font being created
-	// Record requested parameters
-	temp.m_bold = bold;
-	temp.m_fontName = FontName;
-	temp.m_height = height;
-	temp.m_italic = italic;
-
-	// Set up the value of "THICKNESS" needed in D3DXCreateFont
-	UINT boldness =FW_MEDIUM;
-	if(bold == true)
-		boldness = FW_BOLD;
-
-	HRESULT err;
+	int font;			// The backend's handle for the font being created
 
 	// Create the font, as requested
-	err = D3DXCreateFont(m_lpD3DDevice, height, 0, boldness, 0, italic, 
-		DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, DEFAULT_QUALITY, 
-		DEFAULT_PITCH | FF_DONTCARE, FontName, &temp.m_pFont );
-
-	if(FAILED(err))
+	if(m_pBackend->LoadFont(FontName, height, bold, italic, font) == FAILURE)
 	{
-		ErrorLogger::Write(L"Failed to create font ");
-		ErrorLogger::Writeln(FontName);
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		if(temp.m_pFont)
-			temp.m_pFont->Release();
 		return 0;
 	}
 	else
 	{
 		// Add it to the map
-		m_MyFontList.insert(std::pair<FontIndex, MyFont>(m_pNextFont, temp));
+		m_MyFontList.insert(std::pair<FontIndex, int>(m_pNextFont, font));
 		return m_pNextFont++;		// Return the number of the font
 	}
 }
@@ -794,8 +748,12 @@ FontIndex MyDrawEngine::AddFont(wchar_t* FontName, int height, bool bold, bool i
 // Writes text to the screen
 ErrorType MyDrawEngine::WriteText(int x, int y, const wchar_t text[], int colour, FontIndex fontIndex )
 {
+	// Text is drawn straight away, so queued sprites and primitives must go first to stay underneath
+	FlushSprites();
+	FlushPrimitives();
+
 	// Find the requested font
-	std::map<FontIndex, MyFont>::iterator fit;	// Iterator to point to the font requested
+	std::map<FontIndex, int>::iterator fit;	// Iterator to point to the font requested
 	fit = m_MyFontList.find(fontIndex);				// Find the font
 	if(fit == m_MyFontList.end())						// If font not found
 	{
@@ -803,26 +761,7 @@ ErrorType MyDrawEngine::WriteText(int x, int y, const wchar_t text[], int colour
 		return FAILURE;
 	}
 
-	// Rect to draw the text inside
-	RECT rect;
-	rect.left =x;
-	rect.top = y;
-	rect.right =x+50;		// Will get expanded when the rect is calculated
-	rect.bottom = y+50;
-
-	// Nonna-Raymond call to DrawText. Calculates the rect, but does not draw
-	fit->second.m_pFont->DrawText(NULL, text, -1, &rect, DT_CALCRECT , colour);
-
-	// Now make the real call.
-	HRESULT err;
-	err = fit->second.m_pFont->DrawText(NULL, text, -1, &rect, 0 , colour);
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"WriteText failed to draw text.");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;		
-	}
-	return SUCCESS;	
+	return m_pBackend->WriteText(fit->second, x, y, text, colour);
 
 }	// End WriteText
 
@@ -832,7 +771,7 @@ ErrorType MyDrawEngine::WriteText(int x, int y, const wchar_t text[], int colour
 ErrorType MyDrawEngine::WriteDouble(int x, int y, double num, int colour, FontIndex fontIndex )
 {
 	wchar_t buffer[32];			// To store the text when converted
-	swprintf_s( buffer, 32, L"%.8g", num );	// Convert the number to text
+	swprintf( buffer, 32, L"%.8g", num );	// Convert the number to text
 
 	// Write it
 	return WriteText(x,y, buffer, colour, fontIndex);
@@ -843,7 +782,7 @@ ErrorType MyDrawEngine::WriteDouble(int x, int y, double num, int colour, FontIn
 ErrorType MyDrawEngine::WriteInt(int x, int y, int num, int colour, FontIndex fontIndex )
 {
 	wchar_t buffer[32];
-	swprintf_s( buffer,32, L"%i", num );
+	swprintf( buffer,32, L"%i", num );
 
 	return WriteText(x,y, buffer, colour, fontIndex);
 }	// WriteInt
@@ -886,6 +825,9 @@ ErrorType MyDrawEngine::WriteDouble(Vector2D position, double num, int colour, F
 // Draw a picture at the requested location
 ErrorType MyDrawEngine::DrawAt(Vector2D position, PictureIndex pic, float scale, float angle, float transparency)
 {
+	// Keep queued primitives underneath
+	FlushPrimitives();
+
 	// Find the picture
 	std::map<PictureIndex, MyPicture>::iterator picit = m_MyPictureList.find(pic);
 
@@ -907,58 +849,85 @@ ErrorType MyDrawEngine::DrawAt(Vector2D position, PictureIndex pic, float scale,
 	
 	MyPicture& thePicture = picit->second;		// Reference to the picture for easy coding
 
-	// Check texture is loaded
-	if(!thePicture.lpTheTexture)
+	// Nothing to draw until the AssetLoader has published it
+	if(thePicture.m_Loading)
 	{
-		ErrorLogger::Writeln(L"Cannot render MyPicture in DrawAt. MyPicture not initialised.");
-		return FAILURE;
+		return SUCCESS;
 	}
 
-	// Start drawing
-	HRESULT err = m_lpSprite->Begin(D3DXSPRITE_ALPHABLEND);		// Alpha Blending requested
-	if(FAILED(err))
+	// Check texture is loaded
+	if(!thePicture.m_Picture)
 	{
-		ErrorLogger::Writeln(L"Failed to begin sprite render in DrawAt");
-		ErrorLogger::Writeln(ERRORSTRING(err));
+		ErrorLogger::Writeln(L"Cannot render MyPicture in DrawAt. MyPicture not initialised.");
 		return FAILURE;
 	}
 
-	// Specify the centre of the sprite - will be (height/2,width/2) unless user has asked for something 
-	// different.
-	D3DXVECTOR2 centre (thePicture.m_Centre.XValue, thePicture.m_Centre.YValue);
-
-	// Create a transformation matrix for the requested scale, rotation and position.
-	D3DXMATRIX transform;
-	D3DXVECTOR2 scaling(scale, scale);
-	D3DXVECTOR2 pos;
-	pos.x = (position - thePicture.m_Centre).XValue;
-	pos.y = (position - thePicture.m_Centre).YValue;
-	D3DXMatrixTransformation2D(&transform, &centre, 0.0, &scaling, &centre, -angle, &pos);
-	
-	// Set the transformation matrix
-	m_lpSprite->SetTransform(&transform);
+	// Create a transformation for the requested scale, rotation and position.
+	// The picture is scaled and rotated about its centre - (height/2,width/2) unless user
+	// has asked for something different - and the centre is placed at the position.
+	// Same as D3DXMatrixTransformation2D with a rotation of -angle.
+	DrawSprite sprite;
+	float cosAngle = cos(angle);
+	float sinAngle = sin(angle);
+	sprite.m11 = scale * cosAngle;
+	sprite.m12 = -scale * sinAngle;
+	sprite.m21 = scale * sinAngle;
+	sprite.m22 = scale * cosAngle;
+	sprite.dx = position.XValue - (thePicture.m_Centre.XValue * sprite.m11 + thePicture.m_Centre.YValue * sprite.m21);
+	sprite.dy = position.YValue - (thePicture.m_Centre.XValue * sprite.m12 + thePicture.m_Centre.YValue * sprite.m22);
 
 	// Modulate the colour to add transparency
 	unsigned int alpha = int(255-255*transparency)%256;
-	unsigned int colour = 0xFFFFFF+(alpha<<24);
+	sprite.colour = 0xFFFFFF+(alpha<<24);
+	sprite.source = thePicture.m_Region;
+
+	// Queue the sprite - it is drawn by the next FlushSprites
+	m_SpriteQueue.push_back(sprite);
+	m_FrameSprites++;
+
+	return SUCCESS;
+}	// DrawAt
+
+// **************************************************************
 
-	// Draw the sprite
-	err = m_lpSprite->Draw(thePicture.lpTheTexture, NULL, NULL, NULL, colour);
+// Draws every queued sprite, grouped by texture
+ErrorType MyDrawEngine::FlushSprites()
+{
+	if(m_SpriteQueue.empty())
+		return SUCCESS;
 
-	if(FAILED(err))
+	// Group sprites by atlas page. The sort is stable, so sprites sharing a page keep the order they were drawn in.
+	std::stable_sort(m_SpriteQueue.begin(), m_SpriteQueue.end(), [](const DrawSprite& a, const DrawSprite& b)
 	{
-		ErrorLogger::Writeln(L"Failed to draw sprite in DrawAt");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-	
-		m_lpSprite->End();
-		return FAILURE;
+		return a.source.texture < b.source.texture;
+	});
+
+	// Count the runs of sprites sharing a page - each can be drawn as a single batch
+	int currentTexture = 0;
+	for(const DrawSprite& sprite : m_SpriteQueue)
+	{
+		if(sprite.source.texture != currentTexture)
+		{
+			currentTexture = sprite.source.texture;
+			m_FrameBatches++;
+		}
 	}
 
-	// Complete the sprite
-	m_lpSprite->End();
+	ErrorType result = m_pBackend->DrawSprites(m_SpriteQueue.data(), (unsigned int)m_SpriteQueue.size());
+	m_FrameFlushes++;
 
-	return SUCCESS;
-}	// DrawAt
+	m_SpriteQueue.clear();
+	return result;
+}	// FlushSprites
+
+// **************************************************************
+
+void MyDrawEngine::GetSpriteStats(int& sprites, int& flushes, int& batches) const
+{
+	sprites = m_LastFrameSprites;
+	flushes = m_LastFrameFlushes;
+	batches = m_LastFrameBatches;
+}
 
 
 
@@ -973,82 +942,41 @@ ErrorType MyDrawEngine::DrawLine( Vector2D start,  Vector2D end, unsigned int co
 		end = theCamera.Transform(end);
 	}
 
-	// Vertex array with two vertices needed
-		MYVERTEX Vertices[] = {
-		{start.XValue, start.YValue, 0.0f, 1.0f, colour,},
-		{end.XValue, end.YValue, 0.0f, 1.0f, colour,},
-	};
-
-	// Pointer to DirectX Vertex buffer
-	LPDIRECT3DVERTEXBUFFER9 vertexBuffer;
-
-	// Create the buffer using my default format
-	HRESULT err =m_lpD3DDevice->CreateVertexBuffer(2*sizeof(MYVERTEX),
-							   0,
-							   MYFVF,
-							   D3DPOOL_MANAGED,
-							   &vertexBuffer,
-							   NULL);
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to create a vertex buffer in DrawLine");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-
-	VOID* pBuff;		// Pointer to the locked buffer 
+	// Two vertices, drawn as part of a line list
+	DrawVertex* pVertices = QueuePrimitive(DRAW_LINELIST, false, 2);
+	pVertices[0] = {start.XValue, start.YValue, 0.0f, 1.0f, colour};
+	pVertices[1] = {end.XValue, end.YValue, 0.0f, 1.0f, colour};
 
-	// Lock the buffer
-	err= vertexBuffer->Lock(0, 0, (void**)&pBuff, 0);    
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to lock vertex buffer in DrawLine");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		vertexBuffer->Release();
-		return FAILURE;
-	}
-
-	// Copy vertices into the buffer
-	memcpy(pBuff, Vertices, sizeof(Vertices));
+	return SUCCESS;
+}	// DrawLine
 
-	// Unlock the buffer
-	err= vertexBuffer->Unlock();
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to unlock vertex buffer in DrawLine");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		vertexBuffer->Release();
-		return FAILURE;
-	}
+// ******************************************************************
 
-	// Set the vertex format
-	err = m_lpD3DDevice->SetFVF(MYFVF);
-	if(FAILED(err))
+ErrorType MyDrawEngine::DrawLineList(Vector2D start[], Vector2D end[], unsigned int colour[], unsigned int numLines)
+{
+	if(numLines<=0)
 	{
-		ErrorLogger::Writeln(L"Failed to set FVF in DrawLine");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		vertexBuffer->Release();
+		ErrorLogger::Writeln(L"Requested less than one line in DrawLineList.");
 		return FAILURE;
 	}
-	// Set a default stream
-	m_lpD3DDevice->SetStreamSource(0, vertexBuffer, 0, sizeof(MYVERTEX));
 
-	// Draw, as a line list, starting at vertex 0.
-	err= m_lpD3DDevice->DrawPrimitive(D3DPT_LINELIST, 0,1);
-	if(FAILED(err))
+	// All the lines go into the same run, so they are drawn with one call
+	DrawVertex* pVertices = QueuePrimitive(DRAW_LINELIST, false, 2*numLines);
+	for(unsigned int i=0;i<numLines;i++)
 	{
-		ErrorLogger::Writeln(L"Failed to draw a primitive in DrawLine");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		vertexBuffer->Release();
-		return FAILURE;
+		Vector2D s = start[i];
+		Vector2D e = end[i];
+		if (m_CameraActive)
+		{
+			s = theCamera.Transform(s);
+			e = theCamera.Transform(e);
+		}
+		pVertices[2*i] = {s.XValue, s.YValue, 0.0f, 1.0f, colour[i]};
+		pVertices[2*i+1] = {e.XValue, e.YValue, 0.0f, 1.0f, colour[i]};
 	}
-	// Release the buffer
-	vertexBuffer->Release();
 
 	return SUCCESS;
-}	// DrawLine
-
-
+}	// DrawLineList
 
 // ******************************************************************
 
@@ -1071,82 +999,23 @@ ErrorType MyDrawEngine::FillCircle( Vector2D centre, float radius, unsigned int
 	// The angle to rotate each vertex by to find the next vertex
 	float angle = -6.285f / (numVertices-2);
 
-	// Create an array of the vertex locations
-	Vector2D* Points = new Vector2D[numVertices];
+	// The circle used to be a triangle fan around the centre. Fans cannot be joined together,
+	// so it is queued as a triangle list instead - one triangle for each edge of the fan.
+	int numTriangles = numVertices-2;
+	DrawVertex* pVertices = QueuePrimitive(DRAW_TRIANGLELIST, false, 3*numTriangles);
 
-	// First vertex in the middle
-	Points[0].XValue = centre.XValue;
-	Points[0].YValue = centre.YValue;
-
-	// Next vertex is directly below it, 2radius" pixels away
+	// First rim vertex is directly below the centre, "radius" pixels away
 	Vector2D bottom = Vector2D(0, radius);
-	// Find the remaining vertex locations - slow
-	for(int i=1;i<numVertices;i++)
-	{
-		Points[i] =bottom.rotatedBy(-angle*i)+centre;
-	}
-
-	// Vertex buffer to hold the vertices
-	LPDIRECT3DVERTEXBUFFER9 vertexBuffer;
-	HRESULT err;
-	// Create a vertex buffer using my format and default values
-	err = m_lpD3DDevice->CreateVertexBuffer(sizeof(MYVERTEX)*numVertices,
-							   0,
-							   MYFVF,
-							   D3DPOOL_MANAGED,
-							   &vertexBuffer,
-							   NULL);
-
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to create a vertex buffer in DrawPointList");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-
-	VOID* pBuff;		// Pointer to the locked buffer 
-	
-	// Lock the buffer for writing
-	err= vertexBuffer->Lock(0, 0, (void**)&pBuff, 0);  
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to lock the vertex buffer in DrawPointList");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-
-	// Copy vertices into the buffer
-	MYVERTEX* pVertices = (MYVERTEX*)pBuff;
-	for( int i=0;i<numVertices;i++)
+	Vector2D previous = bottom.rotatedBy(-angle)+centre;
+	for(int i=0;i<numTriangles;i++)
 	{
-		pVertices[i].x = Points[i].XValue;
-		pVertices[i].y = Points[i].YValue;
-		pVertices[i].z = 0.0f;
-		pVertices[i].rhw=1.0f;
-		pVertices[i].colour = colour;
+		Vector2D next = bottom.rotatedBy(-angle*(i+2))+centre;
+		pVertices[3*i] = {centre.XValue, centre.YValue, 0.0f, 1.0f, colour};
+		pVertices[3*i+1] = {previous.XValue, previous.YValue, 0.0f, 1.0f, colour};
+		pVertices[3*i+2] = {next.XValue, next.YValue, 0.0f, 1.0f, colour};
+		previous = next;
 	}
 
-	// Writing finished - unlock
-	vertexBuffer->Unlock();
-
-	// Set my vertex format and a default stream source
-	m_lpD3DDevice->SetFVF(MYFVF);
-	m_lpD3DDevice->SetStreamSource(0, vertexBuffer, 0, sizeof(MYVERTEX));
-
-	// Draw using a triangle fan
-	err= m_lpD3DDevice->DrawPrimitive(D3DPT_TRIANGLEFAN, 0,numVertices-2);
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to draw primitive in DrawPoint");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		vertexBuffer->Release();
-		delete[] Points;
-		return FAILURE;
-	}
-	// Release the buffer
-	vertexBuffer->Release();
-	// Delete the array
-	delete[] Points;
 	return SUCCESS;
 }	// FillCircle
 
@@ -1157,7 +1026,6 @@ ErrorType MyDrawEngine::FillCircle( Vector2D centre, float radius, unsigned int
 // Fills a rectangle on the screen
 ErrorType MyDrawEngine::FillRect(Rectangle2D destinationRect, unsigned int colour, float angle)
 {
-
 	if (m_CameraActive)
 	{
 		destinationRect = theCamera.Transform(destinationRect);
@@ -1179,63 +1047,7 @@ ErrorType MyDrawEngine::FillRect(Rectangle2D destinationRect, unsigned int colou
 		p3 = destinationRect.GetBottomLeft();
 		p4 = destinationRect.GetTopLeft();
 	}
-	// Put corners into a vertex array - get the order right
-	MYVERTEX Vertices[] = {
-		{p1.XValue, p1.YValue, 0.0f, 1.0f, colour,},
-		{p2.XValue, p2.YValue, 0.0f, 1.0f, colour,},
-		{p3.XValue, p3.YValue, 0.0f, 1.0f, colour,},
-		{p4.XValue, p4.YValue, 0.0f, 1.0f, colour,},
-	};
-
-	// Create a vertex buffer for drawing
-	LPDIRECT3DVERTEXBUFFER9 vertexBuffer;
-	HRESULT err;
-	err = m_lpD3DDevice->CreateVertexBuffer(4*sizeof(MYVERTEX),
-							   0,
-							   MYFVF,
-							   D3DPOOL_MANAGED,
-							   &vertexBuffer,
-							   NULL);
-
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to create a vertex buffer in Fill Rect");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-
-	VOID* pBuff;		// Pointer to the locked buffer 
-
-	// Lock buffer for writing
-	err= vertexBuffer->Lock(0, 0, (void**)&pBuff, 0);  
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to lock the vertex buffer in FillRect");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-
-	// Copy vertices into the buffer
-	memcpy(pBuff, Vertices, sizeof(Vertices));
-
-	// Writing complete - unlock
-	vertexBuffer->Unlock();
-
-	// Set my vertex format and a default stream
-	m_lpD3DDevice->SetFVF(MYFVF);
-	m_lpD3DDevice->SetStreamSource(0, vertexBuffer, 0, sizeof(MYVERTEX));
-
-	// Draw using a triangle strip
-	err= m_lpD3DDevice->DrawPrimitive(D3DPT_TRIANGLESTRIP, 0,2);
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to draw primitive in FillRect");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		vertexBuffer->Release();
-		return FAILURE;
-	}
-	// Release the buffer
-	vertexBuffer->Release();
+	QueueQuad(p1, p2, p3, p4, colour, false);
 
 	return SUCCESS;
 }
@@ -1245,7 +1057,6 @@ ErrorType MyDrawEngine::FillRect(Rectangle2D destinationRect, unsigned int colou
 
 ErrorType MyDrawEngine::BlendRect(Rectangle2D destinationRect, unsigned int colour, float transparency, float angle)
 {
-
 	if (m_CameraActive)
 	{
 		destinationRect = theCamera.Transform(destinationRect);
@@ -1276,69 +1087,8 @@ ErrorType MyDrawEngine::BlendRect(Rectangle2D destinationRect, unsigned int colo
 		p3 = destinationRect.GetTopLeft();
 		p4 = destinationRect.GetBottomLeft();
 	}
-	// Vertex array
-	MYVERTEX Vertices[] = {
-		{p1.XValue, p1.YValue, 0.0f, 1.0f, colour,},
-		{p2.XValue, p2.YValue, 0.0f, 1.0f, colour,},
-		{p3.XValue, p3.YValue, 0.0f, 1.0f, colour,},
-		{p4.XValue, p4.YValue, 0.0f, 1.0f, colour,},
-	};
-
-	// Create a buffer
-	LPDIRECT3DVERTEXBUFFER9 vertexBuffer;
-	HRESULT err;
-	err = m_lpD3DDevice->CreateVertexBuffer(4*sizeof(MYVERTEX),
-							   0,
-							   MYFVF,
-							   D3DPOOL_MANAGED,
-							   &vertexBuffer,
-							   NULL);
-
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to create a vertex buffer in BlendRect");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-
-	VOID* pBuff;		// Pointer to the locked buffer 
-
-	// Lock buffer for writing
-	err= vertexBuffer->Lock(0, 0, (void**)&pBuff, 0);  
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to lock the vertex buffer in BlendRect");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-
-	// Copy vertices into the buffer
-
-	memcpy(pBuff, Vertices, sizeof(Vertices));
-
-	// Unlock, since writing is complete
-	vertexBuffer->Unlock();
-
-	// Set a vertex format and stream source
-	m_lpD3DDevice->SetFVF(MYFVF);
-	m_lpD3DDevice->SetStreamSource(0, vertexBuffer, 0, sizeof(MYVERTEX));
-
-	// Enable alpha blending
-	m_lpD3DDevice->SetRenderState(D3DRS_ALPHABLENDENABLE, TRUE);
-	m_lpD3DDevice->SetRenderState(D3DRS_BLENDOP, D3DBLENDOP_ADD);
-	m_lpD3DDevice->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
-	m_lpD3DDevice->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
-
-	// Draw rectangle as a triangle strip - two triangles, starting at zero.
-	err= m_lpD3DDevice->DrawPrimitive(D3DPT_TRIANGLESTRIP, 0,2);
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to draw primitive in BlendRect");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		vertexBuffer->Release();
-		return FAILURE;
-	}
-	vertexBuffer->Release();
+	// Alpha blended when drawn
+	QueueQuad(p1, p2, p3, p4, colour, true);
 
 	return SUCCESS;
 }	// Blend rectangle
@@ -1348,63 +1098,14 @@ ErrorType MyDrawEngine::BlendRect(Rectangle2D destinationRect, unsigned int colo
 // Draws a single dot
 ErrorType MyDrawEngine::DrawPoint(Vector2D point, unsigned int colour)
 {
-
 	if (m_CameraActive)
 	{
 		point = theCamera.Transform(point);
 	}
-	// An "array" with one entry
-	MYVERTEX Vertices[] = {
-		{point.XValue, point.YValue, 0.0f, 1.0f, colour,},
-	};
-
-	// Create a vertex buffer
-	LPDIRECT3DVERTEXBUFFER9 vertexBuffer;
-	HRESULT err;
-	err = m_lpD3DDevice->CreateVertexBuffer(sizeof(MYVERTEX),
-							   0,
-							   MYFVF,
-							   D3DPOOL_MANAGED,
-							   &vertexBuffer,
-							   NULL);
-
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to create a vertex buffer in DrawPoint");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-
-	VOID* pBuff;		// Pointer to the locked buffer 
-
-	err= vertexBuffer->Lock(0, 0, (void**)&pBuff, 0);  
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to lock the vertex buffer in DrawPoint");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-
-	// Copy vertices into the buffer
-
-	memcpy(pBuff, Vertices, sizeof(Vertices));
 
-	vertexBuffer->Unlock();
+	DrawVertex* pVertices = QueuePrimitive(DRAW_POINTLIST, false, 1);
+	pVertices[0] = {point.XValue, point.YValue, 0.0f, 1.0f, colour};
 
-	// Set a vertex format and stream source
-	m_lpD3DDevice->SetFVF(MYFVF);
-	m_lpD3DDevice->SetStreamSource(0, vertexBuffer, 0, sizeof(MYVERTEX));
-
-	// Draw a point list, with a single entry
-	err= m_lpD3DDevice->DrawPrimitive(D3DPT_POINTLIST, 0,1);
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to draw primitive in DrawPoint");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		vertexBuffer->Release();
-		return FAILURE;
-	}
-	vertexBuffer->Release();
 	return SUCCESS;
 }
 
@@ -1418,36 +1119,8 @@ ErrorType MyDrawEngine::DrawPointList(Vector2D points[], unsigned int colours[],
 		return FAILURE;
 	}
 
-	// Create a vertex buffer
-	LPDIRECT3DVERTEXBUFFER9 vertexBuffer;
-	HRESULT err;
-	err = m_lpD3DDevice->CreateVertexBuffer(sizeof(MYVERTEX)*numPoints,
-							   0,
-							   MYFVF,
-							   D3DPOOL_MANAGED,
-							   &vertexBuffer,
-							   NULL);
-
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to create a vertex buffer in DrawPointList");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-
-	VOID* pBuff;		// Pointer to the locked buffer 
-
-	// Lock buffer for writing
-	err= vertexBuffer->Lock(0, 0, (void**)&pBuff, 0);  
-	if(FAILED(err))
-	{
-		ErrorLogger::Writeln(L"Failed to lock the vertex buffer in DrawPointList");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		return FAILURE;
-	}
-
-	// Copy vertices into the buffer
-	MYVERTEX* pVertices = (MYVERTEX*)pBuff;
+	// Copy vertices into the queue
+	DrawVertex* pVertices = QueuePrimitive(DRAW_POINTLIST, false, numPoints);
 	for(unsigned int i=0;i<numPoints;i++)
 	{
 		Vector2D p = points[i];
@@ -1455,54 +1128,96 @@ ErrorType MyDrawEngine::DrawPointList(Vector2D points[], unsigned int colours[],
 		{
 			p = theCamera.Transform(p);
 		}
-		pVertices[i].x = p.XValue;
-		pVertices[i].y = p.YValue;
-		pVertices[i].z = 0.0f;
-		pVertices[i].rhw=1.0f;
-		pVertices[i].colour = colours[i];
+		pVertices[i] = {p.XValue, p.YValue, 0.0f, 1.0f, colours[i]};
 	}
 
-	// Finished writing
-	vertexBuffer->Unlock();
+	return SUCCESS;
+}	// DrawPointList
+
+// **************************************************************
+
+// Makes room for some vertices at the end of the primitive queue
+DrawVertex* MyDrawEngine::QueuePrimitive(DrawPrimitiveType type, bool blend, unsigned int numVertices)
+{
+	// Keep queued sprites underneath
+	FlushSprites();
 
-	// Set a vertex format and stream source
-	m_lpD3DDevice->SetFVF(MYFVF);
-	m_lpD3DDevice->SetStreamSource(0, vertexBuffer, 0, sizeof(MYVERTEX));
+	unsigned int first = (unsigned int)m_PrimitiveQueue.size();
 
-	// Draw using a point list
-	err= m_lpD3DDevice->DrawPrimitive(D3DPT_POINTLIST, 0,numPoints);
-	if(FAILED(err))
+	// Start a new run unless this can be drawn in the same call as the last one
+	if(m_PrimitiveRuns.empty() || m_PrimitiveRuns.back().m_Type != type || m_PrimitiveRuns.back().m_Blend != blend)
 	{
-		ErrorLogger::Writeln(L"Failed to draw primitive in DrawPoint");
-		ErrorLogger::Writeln(ERRORSTRING(err));
-		vertexBuffer->Release();
-		return FAILURE;
+		PrimitiveRun run = {type, blend, first, 0};
+		m_PrimitiveRuns.push_back(run);
 	}
-	vertexBuffer->Release();
-	return SUCCESS;
-}	// DrawPointList
+	m_PrimitiveRuns.back().m_NumVertices += numVertices;
+
+	m_PrimitiveQueue.resize(first+numVertices);
+	m_FramePrimitiveVertices += numVertices;
 
+	return &m_PrimitiveQueue[first];
+}	// QueuePrimitive
 
+// **************************************************************
 
+// Queues the two triangles that a triangle strip through the four corners would have drawn
+void MyDrawEngine::QueueQuad(Vector2D p1, Vector2D p2, Vector2D p3, Vector2D p4, unsigned int colour, bool blend)
+{
+	DrawVertex* pVertices = QueuePrimitive(DRAW_TRIANGLELIST, blend, 6);
+	pVertices[0] = {p1.XValue, p1.YValue, 0.0f, 1.0f, colour};
+	pVertices[1] = {p2.XValue, p2.YValue, 0.0f, 1.0f, colour};
+	pVertices[2] = {p3.XValue, p3.YValue, 0.0f, 1.0f, colour};
+	// Second triangle of a strip has its first two vertices swapped, to keep the same winding
+	pVertices[3] = {p2.XValue, p2.YValue, 0.0f, 1.0f, colour};
+	pVertices[4] = {p4.XValue, p4.YValue, 0.0f, 1.0f, colour};
+	pVertices[5] = {p3.XValue, p3.YValue, 0.0f, 1.0f, colour};
+}	// QueueQuad
 
 // **************************************************************
-// Inner struct constructors
+
+// Hands each run of queued vertices to the backend
+ErrorType MyDrawEngine::FlushPrimitives()
+{
+	if(m_PrimitiveRuns.empty())
+		return SUCCESS;
+
+	// Each run is drawn with a single call, unless the backend has to split it up
+	ErrorType result = SUCCESS;
+	for(const PrimitiveRun& run : m_PrimitiveRuns)
+	{
+		if(m_pBackend->DrawPrimitives(run.m_Type, run.m_Blend, &m_PrimitiveQueue[run.m_FirstVertex], run.m_NumVertices, m_FramePrimitiveDraws) == FAILURE)
+			result = FAILURE;
+	}
+	m_FramePrimitiveFlushes++;
+
+	m_PrimitiveQueue.clear();
+	m_PrimitiveRuns.clear();
+	return result;
+}	// FlushPrimitives
+
 // **************************************************************
 
-// MyFont constructor - just set pointer to NULL
-MyDrawEngine::MyFont::MyFont()
+void MyDrawEngine::GetPrimitiveStats(int& vertices, int& flushes, int& draws) const
 {
-	m_pFont = nullptr;
+	vertices = m_LastFramePrimitiveVertices;
+	flushes = m_LastFramePrimitiveFlushes;
+	draws = m_LastFramePrimitiveDraws;
 }
 
+
+
+
+// **************************************************************
+// Inner struct constructors
 // **************************************************************
 
-// MyPicture constructor -  set pointer to NULL and dimensions to zero
+// MyPicture constructor -  set picture handle and dimensions to zero
 MyDrawEngine::MyPicture::MyPicture()
 {
-	lpTheTexture = nullptr;
+	m_Picture = 0;
 	m_width =0;
 	m_height=0;
+	m_Loading = false;
 }
 
 
@@ -1,14 +1,21 @@
+// Modified by 16007006
+// DrawAt now queues sprites, which are sorted by texture and submitted together by FlushSprites
+// Primitives are queued too, and submitted through one persistent dynamic vertex buffer by FlushPrimitives
+// The drawing itself is done by a DrawBackend - Direct3D 9, or the headless software rasterizer
+// Pictures are packed into texture atlas pages, and can be preloaded from a manifest with LoadPictureManifest
+// Pictures in the asset pack are copied straight from the mapped pack instead of being loaded from their files
+// LoadPictureAsync decodes pictures on the AssetLoader's worker threads, and PrefetchPictures starts a list of them
+
 // mydrawengine.h
 // Shell engine version 2020
 // Chris Rook
 // Last modified 20/09/2018
 
 #pragma once
-#pragma comment(lib, "d3d9.lib")
-#pragma comment(lib, "d3dx9.lib")
-#pragma comment(lib, "dxguid.lib")  
-#include <d3d9.h>		// directX draw
-#include <d3dx9.h>		// extra directX draw stuff   
+#ifdef _WIN32
+#include <windows.h>		// For HWND
+#endif
+#include "DrawBackend.h"
 #include "errorlogger.h"
 #include "vector2d.h"
 #include "shapes.h"
@@ -18,16 +25,20 @@
 #include "string"
 #include "camera.h"
 
+struct LoadedAsset;
 
 // Macros ***************************************************
 // Colour system
 #define _RGB565(r,g,b)  ((((b>>3)%32)) + (((g>>2)%64)<<5) + (((r>>3)%32)<<11))
 #define _XRGB(r,g,b) ((255<<24)+(r<<16) + (g<<8) +b)
+#define _ARGB(a,r,g,b) ((unsigned int)(((a)<<24)+((r)<<16) + ((g)<<8) +(b)))
 
 // The class spec *******************************************
 
 // This class provides a simple set of graphics functions that
 // use directX for a computer game, using 32-bit graphics.
+// The directX calls are made by D3D9Backend. StartHeadless uses
+// SoftwareBackend instead, which needs no window.
 // The functions are organised in a class for convenience, rather
 // than for OO principles.
 
@@ -47,19 +58,11 @@ class MyDrawEngine
 
 private:
 
-   // Defines the vertex format used in Direct3D
-struct MYVERTEX
-{
-	FLOAT x,y,z,rhw;
-	DWORD colour;
-};
-
-#define MYFVF (D3DFVF_XYZRHW|D3DFVF_DIFFUSE)
-
 	// Inner struct to store information about each picture
 	struct MyPicture
 	{
-		LPDIRECT3DTEXTURE9  lpTheTexture;	// The surface that MyPicture encapsulates
+		int m_Picture;                      // The backend's handle for the picture. Zero if not loaded.
+		DrawRegion m_Region;                // Which atlas page the picture is on, and where
 		std::wstring m_SourceFileName;      // The file name of the loaded image
 		Vector2D m_Centre;                  // Cordinates of the "centre" of the image
                                           // by default this is the centre of the square file
@@ -67,29 +70,23 @@ struct MYVERTEX
                                           // some other centre
 		int m_width;                        // Width of the image in pixels
 		int m_height;                       // Height of the image in pixels
+		bool m_Loading;                     // True while the AssetLoader is decoding the file. Nothing is drawn until it is published.
 
 	   // Public methods
-		//  Internal pointer to the texture is set to NULL
+		//  Handle and dimensions are set to zero
 		MyPicture();
 	};
 
-	// Inner struct to store information about each font
-	struct MyFont
+	// Inner struct to store a run of queued primitive vertices that can be drawn with one call
+	struct PrimitiveRun
 	{
-		LPD3DXFONT m_pFont;		      // Pointer to the font
-		std::wstring m_fontName;		// Name of the font
-		int m_height;			         // Height of the font
-		bool m_bold;			         // If true, font will be bold
-		bool m_italic;			         // If true, font will be italicised
-
-		// Sets the pointer to nullptr
-		MyFont();
+		DrawPrimitiveType m_Type;           // Point list, line list or triangle list
+		bool m_Blend;                       // If true, the run is alpha blended
+		unsigned int m_FirstVertex;         // Index of the first vertex in m_PrimitiveQueue
+		unsigned int m_NumVertices;         // Number of vertices in the run
 	};
 
-	HWND m_Hwnd;								// The handle to the window
-	IDirect3D9* m_lpD3D;					   // Pointer to direct draw
-	IDirect3DDevice9* m_lpD3DDevice;		// Pointer to the D3D device
-	LPD3DXSPRITE m_lpSprite;				// Sprite to draw pictures
+	DrawBackend* m_pBackend;				// Does the actual drawing. Owned by the engine.
 
 	int m_ScreenWidth;						// Height of the screen
 	int m_ScreenHeight;						// Width of the screen
@@ -101,42 +98,57 @@ struct MYVERTEX
 	bool m_bFullScreen;						// True if full screen. False otherwise
 	std::map<PictureIndex, MyPicture> m_MyPictureList;	      // Map of MyPicture objects
 	std::map<std::wstring, PictureIndex> m_FilenameList;		// Map of filenames
-	std::map<FontIndex, MyFont> m_MyFontList;			         // Map of Font objects
+	std::map<FontIndex, int> m_MyFontList;			            // Map of fonts to the backend's handles
 	PictureIndex m_NextPictureIndex;		// The index of the next font to be added	
 	FontIndex m_pNextFont;					// The index of the next font to be added
 
-		// Postcondition:	The primary surface, the buffer, the clipper and DirectDraw have been released.
+	std::vector<DrawSprite> m_SpriteQueue;	// Sprites drawn since the last flush. Kept between frames to avoid reallocating.
+	int m_FrameSprites;						// Sprites queued so far this frame
+	int m_FrameFlushes;						// Times the queue has been submitted so far this frame
+	int m_FrameBatches;						// Runs of sprites sharing a texture submitted so far this frame
+	int m_LastFrameSprites;					// Counters for the last completed frame
+	int m_LastFrameFlushes;
+	int m_LastFrameBatches;
+
+	std::vector<DrawVertex> m_PrimitiveQueue;	// Vertices drawn since the last flush, already in screen space
+	std::vector<PrimitiveRun> m_PrimitiveRuns;	// How m_PrimitiveQueue is split into draw calls
+	int m_FramePrimitiveVertices;			// Vertices queued so far this frame
+	int m_FramePrimitiveFlushes;			// Times the primitive queue has been submitted so far this frame
+	int m_FramePrimitiveDraws;				// DrawPrimitive calls made so far this frame
+	int m_LastFramePrimitiveVertices;		// Counters for the last completed frame
+	int m_LastFramePrimitiveFlushes;
+	int m_LastFramePrimitiveDraws;
+
+		// Postcondition:	The backend and everything loaded into it have been released.
 		// Returns:			SUCCESS
 	ErrorType Release();
 
+		// Postcondition:	A picture reserved by LoadPictureAsync has been loaded into the atlas
+		//					from the decoded pixels, or directly from its file if the decoder could
+		//					not read it. If neither worked, the PictureIndex has been removed.
+		//					Called by AssetLoader::Publish on the main thread.
+	void FinishPicture(PictureIndex pic, const LoadedAsset& asset);
+
 	static MyDrawEngine* instance;
 		// Instance of this singleton
 
 		// Parameters:
-		//		hwnd		The handle to the application's window.
-	MyDrawEngine(HWND hwnd);
+		//		pBackend	The backend to draw with. The engine takes ownership.
+	MyDrawEngine(DrawBackend* pBackend);
 
 		// Singleton destructor - calls "Release()"
 	~MyDrawEngine();	
 
-	// Reloads a specified picture - called within ReloadBitmaps
-   // Parameters:
-   //    pic    The index of the required picture
-	ErrorType ReloadPicture(PictureIndex pic);
-
-	// Releases all Bitmaps. Used when resetting the device or
-	// on destruction.
-	void ReleaseBitmaps();
+		// Creates the instance around the backend, starts it and loads the default font
+	static ErrorType StartWithBackend(DrawBackend* pBackend);
 
-	// Reloads all Bitmaps. Used after resetting the device.
-	void ReloadBitmaps();
+	// Adds space for numVertices vertices to the primitive queue, extending the last run if it has
+	// the same type and blending, and returns a pointer to the first one for the caller to fill in.
+	// The pointer is only valid until the next call. Queued sprites are flushed first so they stay underneath.
+	DrawVertex* QueuePrimitive(DrawPrimitiveType type, bool blend, unsigned int numVertices);
 
-	// Releases all Bitmaps. Used when resetting the device or
-	// on destruction.
-	void ReleaseFonts();
-
-	// Reloads all Fonts. Used after resetting the device.
-	void ReloadFonts();
+	// Queues a filled quad as two triangles. Corners are in triangle strip order.
+	void QueueQuad(Vector2D p1, Vector2D p2, Vector2D p3, Vector2D p4, unsigned int colour, bool blend);
 
 public:
 	Camera theCamera;          // Camera objects is used to translate world coordinates to/from
@@ -144,20 +156,20 @@ public:
 
 	// Some standard colours.
 	static const unsigned int BLACK = 0;
-	static const unsigned int RED = D3DCOLOR_ARGB(255,255,0,0);
-	static const unsigned int GREEN = D3DCOLOR_ARGB(255,0,255,0);
-	static const unsigned int BLUE = D3DCOLOR_ARGB(255,0,0,255);
-	static const unsigned int DARKRED = D3DCOLOR_ARGB(255,128,0,0);
-	static const unsigned int DARKGREEN = D3DCOLOR_ARGB(255,0,128,0);
-	static const unsigned int DARKBLUE = D3DCOLOR_ARGB(255,0,0,128);
-	static const unsigned int LIGHTRED = D3DCOLOR_ARGB(255,255,128,128);
-	static const unsigned int LIGHTGREEN = D3DCOLOR_ARGB(255,128,255,128);
-	static const unsigned int LIGHTBLUE = D3DCOLOR_ARGB(255,128,128,255);
-	static const unsigned int WHITE = D3DCOLOR_ARGB(255,255,255,255);
-	static const unsigned int YELLOW = D3DCOLOR_ARGB(255,255,255,0);
-	static const unsigned int CYAN = D3DCOLOR_ARGB(255,0,255,255);
-	static const unsigned int PURPLE = D3DCOLOR_ARGB(255,255,0,255);
-	static const unsigned int GREY = D3DCOLOR_ARGB(255,128,128,128);
+	static const unsigned int RED = _ARGB(255,255,0,0);
+	static const unsigned int GREEN = _ARGB(255,0,255,0);
+	static const unsigned int BLUE = _ARGB(255,0,0,255);
+	static const unsigned int DARKRED = _ARGB(255,128,0,0);
+	static const unsigned int DARKGREEN = _ARGB(255,0,128,0);
+	static const unsigned int DARKBLUE = _ARGB(255,0,0,128);
+	static const unsigned int LIGHTRED = _ARGB(255,255,128,128);
+	static const unsigned int LIGHTGREEN = _ARGB(255,128,255,128);
+	static const unsigned int LIGHTBLUE = _ARGB(255,128,128,255);
+	static const unsigned int WHITE = _ARGB(255,255,255,255);
+	static const unsigned int YELLOW = _ARGB(255,255,255,0);
+	static const unsigned int CYAN = _ARGB(255,0,255,255);
+	static const unsigned int PURPLE = _ARGB(255,255,0,255);
+	static const unsigned int GREY = _ARGB(255,128,128,128);
 
 	// Public methods ***************************************
 
@@ -175,12 +187,46 @@ public:
 	//	which can be used in other methods to draw the picture.
 	//  Returns zero if file loading fails.
 	// Notes:
-	//	For best results, the file should be 1x1, 2x2, 4x4, 8x8, 16x16
-	//	32x32, 64x64, etc.
+	//	The picture is packed into a shared texture atlas page, so it
+	//	no longer needs to be a power of two in size.
+	//	If an AssetPack has been started and holds a picture packed from
+	//	a file of this name, the picture is taken from the pack instead.
 	//	Transparency is supported on the alpha channel for file formats
 	//	that support it.
 	PictureIndex LoadPicture(wchar_t* filename);
 
+	// Precondition:
+	//	manifest is the name of a text file listing picture files,
+	//	one per line. Blank lines and lines starting with # are ignored.
+	// Postcondition:
+	//	Every picture listed has been loaded, largest first so that
+	//	they pack tightly into the atlas. Later calls to LoadPicture
+	//	with the same file names return the pictures already loaded.
+	// Returns:
+	//	SUCCESS, or FAILURE if the manifest or any of the pictures
+	//	could not be loaded. The rest are still loaded.
+	ErrorType LoadPictureManifest(const wchar_t manifest[]);
+
+	// Postcondition:
+	//	As LoadPicture, but if the AssetLoader has been started the file is
+	//	decoded on one of its worker threads. The PictureIndex is returned
+	//	straight away. Until the next AssetLoader::Publish after decoding
+	//	finishes, DrawAt draws nothing for it and its dimensions are zero.
+	// Returns:
+	//  The PictureIndex. If the picture has already been loaded, or is
+	//	already loading, the same index is returned.
+	// Notes:
+	//	Pictures in the asset pack, or any picture when the AssetLoader has
+	//	not been started, are loaded by LoadPicture as they need no decoding.
+	//	If the picture cannot be loaded, the error is written to the log when
+	//	it is published and the index becomes invalid.
+	PictureIndex LoadPictureAsync(const wchar_t filename[]);
+
+	// Postcondition:
+	//	LoadPictureAsync has been called for each file in the list. Call
+	//	AssetLoader::WaitForAll to block until they have all been loaded.
+	void PrefetchPictures(const wchar_t* const filenames[], int count);
+
 	// Precondition:
 	//	filename is a NULL-terminated w_string
 	// Postcondition:
@@ -276,7 +322,17 @@ public:
 	//		hwnd		The handle to the application's window.
 	// Note you should call this static method using MyDrawEngine::Start() before using
 	// any other methods of this class.
+#ifdef _WIN32
 	static ErrorType Start(HWND hwnd, bool bFullScreen);
+#endif
+
+	// Postcondition:	An instance of MyDrawEngine is created, drawing into an in-memory
+	//					framebuffer of the given size instead of a window.
+	//					If a previous instance already exists, this is terminated first.
+	// Notes:			Works without Windows or a graphics card. Only BMP files can be
+	//					loaded, and text is not drawn. Use GetFrameChecksum after Flip
+	//					to compare frames.
+	static ErrorType StartHeadless(int width, int height);
 
 	// Postcondition:	The instance of MyDrawEngine has been terminated.
 	// Returns:			SUCCESS If the instance of MyDrawEngine had been started using Start()
@@ -310,12 +366,45 @@ public:
 		//					transparency - the transparency of the image. 0.0 is opaque. 1.0 is
 		//						fully transparent. Behaviour for transparency values greater
 		//						than 1.0 or less than 0.0 is undefined.
+		// Notes:			The sprite is queued rather than drawn straight away. Queued sprites
+		//					are sorted by texture and drawn together when FlushSprites is called,
+		//					which happens automatically before Flip, text and any other drawing.
+		//					Within one flush, sprites using the same picture keep their order,
+		//					but sprites using different pictures may be layered differently.
 	ErrorType DrawAt(Vector2D position, PictureIndex pic, float scale=1.0, float angle=0, float transparency=0);
 
+		// Postcondition	All sprites queued by DrawAt have been drawn to the back buffer,
+		//					in as few texture changes as possible, and the queue is empty.
+		// Returns			SUCCESS if all sprites were drawn. FAILURE otherwise.
+		// Notes:			Call this to force sprites to be drawn before something else, e.g.
+		//					to put a background behind later sprites.
+	ErrorType FlushSprites();
+
+		// Postcondition	sprites, flushes and batches are set to the number of sprites drawn,
+		//					the number of times the queue was submitted, and the number of
+		//					runs of sprites sharing a texture, in the last completed frame.
+	void GetSpriteStats(int& sprites, int& flushes, int& batches) const;
+
+		// Postcondition	All points, lines, rectangles and circles queued since the last flush
+		//					have been drawn to the back buffer, and the queue is empty.
+		//					Consecutive primitives of the same kind are drawn with a single call.
+		// Returns			SUCCESS if everything was drawn. FAILURE otherwise.
+		// Notes:			This happens automatically before Flip, text and any sprite drawing.
+	ErrorType FlushPrimitives();
+
+		// Postcondition	vertices, flushes and draws are set to the number of primitive vertices
+		//					queued, the number of times the queue was submitted, and the number of
+		//					DrawPrimitive calls made, in the last completed frame.
+	void GetPrimitiveStats(int& vertices, int& flushes, int& draws) const;
+
+		// Returns			A checksum of the frame shown by the last Flip, or zero if
+		//					the backend cannot read its frames back (Direct3D).
+	unsigned long long GetFrameChecksum() const;
+
 	// Precondition:	A window for the application has been created
 	//					Direct3D has not already been initialised.
-	// Postcondition:	A Direct3D interface has been created.
-	//					The screen has been put into full-screen, exclusive mode.
+	// Postcondition:	The backend has been started - for Direct3D, a Direct3D interface has been created.
+	//					The screen has been put into full-screen, exclusive mode at the native resolution.
 	// Returns: FAILURE if the startup fails for any reason. A message will be written to the log file
 	//			SUCCESS otherwise
 	ErrorType StartWindow();
@@ -382,6 +471,12 @@ public:
 		// Returns			SUCCESS
 	ErrorType DrawLine(Vector2D start, Vector2D end,  unsigned int colour);
 
+		// Precondition		start, end and colour are arrays with size smaller or equal to numLines
+		// Postcondition	numLines lines have been plotted on the back buffer, each from
+		//					start[i] to end[i] in colour[i].
+		// Returns			SUCCESS, or FAILURE if numLines is zero
+	ErrorType DrawLineList(Vector2D start[], Vector2D end[], unsigned int colour[], unsigned int numLines);
+
 
 		// Postcondition	A circle centred on centre with the radius "radius" has been
 		//					filled on the screen with the specified colour
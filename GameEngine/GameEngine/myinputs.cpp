@@ -1,3 +1,7 @@
+// Modified by 16007006
+// SampleKeyboard also packs the keys into an InputSnapshot, which the game reads through GetSnapshot
+// SampleFrame samples every device once per frame, and can record the states to a file or replay them
+
 // myinputs.cpp
 // Shell engine version 2020
 // Chris Rook
@@ -5,6 +9,7 @@
 
 #include "myinputs.h"
 #include "errorlogger.h"
+#include <cstring>
 
 // *************************************************************************************
 // Implementation of the global EnumerateJoystick function 
@@ -99,6 +104,15 @@ MyInputs::MyInputs(HINSTANCE hinst, HWND hwnd)
 	mbMouseRight = false;
 	mbMouseMiddle = false;
 
+	// Devices that are missing are recorded as all zeros
+	memset(&msMousestate, 0, sizeof(msMousestate));
+	memset(&msJoystickState, 0, sizeof(msJoystickState));
+	memset(mrgcKeystate, 0, KEYMAPSIZE);
+	memset(mrgcOldKeystate, 0, KEYMAPSIZE);
+	memset(mrgbFrameState, 0, FRAMESTATESIZE);
+	mdFrameTime = 0.0;
+	mbFramePending = false;
+
 	mrglpdiEffectList[PULL]=nullptr;
 	mrglpdiEffectList[SHAKE]=nullptr;
 	mrglpdiEffectList[CENTRE]=nullptr;
@@ -339,6 +353,7 @@ MyInputs::MyInputs(HINSTANCE hinst, HWND hwnd)
 
 MyInputs::~MyInputs()
 {
+	StopRecording();
 	Release();
 }
 
@@ -375,14 +390,19 @@ void MyInputs::Release()
 
 void MyInputs::SampleMouse()
 {
-	if(!lpdimouse) 
+	bool replaying = mRecorder.GetMode() == InputRecorder::REPLAYING;
+	if(!lpdimouse && !replaying) 
 	{
 		ErrorLogger::Writeln(L"No mouse - cannot sample.");	
 		return;
 	}
 
 	// Get state of mouse from DInput
-	HRESULT err=lpdimouse->GetDeviceState(sizeof(msMousestate), (LPVOID) &msMousestate);
+	HRESULT err = DI_OK;
+	if(replaying)
+		memcpy(&msMousestate, mrgbFrameState + MOUSESTATEOFFSET, sizeof(msMousestate));	// From the recording instead
+	else
+		err=lpdimouse->GetDeviceState(sizeof(msMousestate), (LPVOID) &msMousestate);
 	if(FAILED(err))
 	{	
 		ErrorLogger::Writeln(L"Failed to get mouse state.");
@@ -522,10 +542,15 @@ bool MyInputs::NewKeyPressed(unsigned char key)
 
 void MyInputs::SampleKeyboard()
 {
-	if(lpdikeyboard)			// Can't sample keyboard if it was not created
+	bool replaying = mRecorder.GetMode() == InputRecorder::REPLAYING;
+	if(lpdikeyboard || replaying)			// Can't sample keyboard if it was not created
 	{
 		memcpy(mrgcOldKeystate, mrgcKeystate, KEYMAPSIZE);
-		HRESULT err=lpdikeyboard->GetDeviceState(KEYMAPSIZE, &mrgcKeystate);
+		HRESULT err = DI_OK;
+		if(replaying)
+			memcpy(mrgcKeystate, mrgbFrameState + KEYSTATEOFFSET, KEYMAPSIZE);	// From the recording instead
+		else
+			err=lpdikeyboard->GetDeviceState(KEYMAPSIZE, &mrgcKeystate);
 		if(FAILED(err))
 		{
 			ErrorLogger::Writeln(L"Failed to get keyboard state.");
@@ -542,12 +567,26 @@ void MyInputs::SampleKeyboard()
 			}
 		}
 
+		// Pack the keys once, so readers do not each go through all 256
+		InputSnapshot previous = msSnapshot;
+		msSnapshot.Set(mrgcKeystate, previous);
 	}
 }
 
+const InputSnapshot& MyInputs::GetSnapshot() const
+{
+	return msSnapshot;
+}
+
 
 void MyInputs::SampleJoystick()
 {
+	if(mRecorder.GetMode() == InputRecorder::REPLAYING)
+	{
+		memcpy(&msJoystickState, mrgbFrameState + JOYSTICKSTATEOFFSET, sizeof(msJoystickState));	// From the recording instead
+		return;
+	}
+
 	if(lpdijoystick)			// Can't sample joystick if it was not created
 	{
 		HRESULT err=lpdijoystick->Poll();
@@ -593,6 +632,80 @@ void MyInputs::SampleJoystick()
 
 }
 
+void MyInputs::SampleFrame()
+{
+	// The last frame is finished - it has had its frame time, if it is going to get one
+	if(mbFramePending)
+	{
+		mRecorder.WriteFrame(mrgbFrameState, mdFrameTime);
+		mbFramePending = false;
+	}
+	mdFrameTime = 0.0;
+
+	if(mRecorder.GetMode() == InputRecorder::REPLAYING &&
+		mRecorder.ReadFrame(mrgbFrameState, mdFrameTime) == FAILURE)
+	{
+		// Carries on with the real devices from here
+		ErrorLogger::Write(L"Input replay finished after frames: ");
+		ErrorLogger::Writeln(mRecorder.GetFrameCount());
+	}
+	bool replaying = mRecorder.GetMode() == InputRecorder::REPLAYING;
+
+	SampleKeyboard();
+	if(lpdimouse || replaying)
+		SampleMouse();
+	if(lpdijoystick || replaying)
+		SampleJoystick();
+
+	if(mRecorder.GetMode() == InputRecorder::RECORDING)
+	{
+		memcpy(mrgbFrameState + KEYSTATEOFFSET, mrgcKeystate, KEYMAPSIZE);
+		memcpy(mrgbFrameState + MOUSESTATEOFFSET, &msMousestate, sizeof(msMousestate));
+		memcpy(mrgbFrameState + JOYSTICKSTATEOFFSET, &msJoystickState, sizeof(msJoystickState));
+		mbFramePending = true;
+	}
+}	// SampleFrame
+
+double MyInputs::RecordFrameTime(double frameTime)
+{
+	if(mRecorder.GetMode() == InputRecorder::REPLAYING)
+		return mdFrameTime;
+	mdFrameTime = frameTime;
+	return frameTime;
+}
+
+ErrorType MyInputs::StartRecording(const wchar_t filename[], unsigned int seed)
+{
+	StopRecording();
+	return mRecorder.StartRecording(filename, FRAMESTATESIZE, seed);
+}
+
+ErrorType MyInputs::StartReplay(const wchar_t filename[], unsigned int& seed)
+{
+	StopRecording();
+	return mRecorder.StartReplay(filename, FRAMESTATESIZE, seed);
+}
+
+void MyInputs::StopRecording()
+{
+	if(mbFramePending)
+	{
+		mRecorder.WriteFrame(mrgbFrameState, mdFrameTime);
+		mbFramePending = false;
+	}
+	mRecorder.Stop();
+}
+
+bool MyInputs::IsRecording() const
+{
+	return mRecorder.GetMode() == InputRecorder::RECORDING;
+}
+
+bool MyInputs::IsReplaying() const
+{
+	return mRecorder.GetMode() == InputRecorder::REPLAYING;
+}
+
 int MyInputs::GetJoystickX()
 {
 	return msJoystickState.lX;
@@ -1,3 +1,7 @@
+// Modified by 16007006
+// SampleKeyboard also packs the keys into an InputSnapshot, which the game reads through GetSnapshot
+// SampleFrame samples every device once per frame, and can record the states to a file or replay them
+
 // myinputs.h
 // Shell engine version 2020
 // Chris Rook
@@ -11,6 +15,8 @@
 #define DIRECTINPUT_VERSION 0x0800
 #include <dinput.h>
 #include "errortype.h"
+#include "InputSnapshot.h"
+#include "InputRecorder.h"
 
 
 
@@ -37,6 +43,17 @@ private:
 	char mrgcKeystate[KEYMAPSIZE];			// Array to hold the keyboard state. (Usually 102 keys, but 256 allows
 										            //		for future expansion
 	char mrgcOldKeystate[KEYMAPSIZE];		// Keystate on previous keyboard sample
+	InputSnapshot msSnapshot;				// The last sample packed into bitsets, with the edges since the one before
+
+	// Every device's state for one frame, side by side, as recorded and replayed
+	static const int KEYSTATEOFFSET = 0;
+	static const int MOUSESTATEOFFSET = KEYMAPSIZE;
+	static const int JOYSTICKSTATEOFFSET = MOUSESTATEOFFSET + sizeof(DIMOUSESTATE);
+	static const int FRAMESTATESIZE = JOYSTICKSTATEOFFSET + sizeof(DIJOYSTATE);
+	unsigned char mrgbFrameState[FRAMESTATESIZE];	// This frame, as recorded or replayed
+	double mdFrameTime;							// This frame's time, as recorded or replayed
+	bool mbFramePending;						// mrgbFrameState is recorded, but not yet written out
+	InputRecorder mRecorder;
 
 	DIJOYSTATE msJoystickState;			      // DirectInput object to store state of joystick
 	static LPDIRECTINPUT8 lpdi;				   // DirectInput interface
@@ -161,8 +178,44 @@ public:
 	// ***** Keyboard methods *******************************************************
 
 		// Samples the keyboard. Records the up/down state of all the keys at the time of sampling
+		// The game calls this once per frame - anything else should read GetSnapshot(),
+		// as sampling again would lose the edges seen by NewKeyPressed.
 	void SampleKeyboard();
 
+		// Returns the keys at the last sample, as a snapshot that can be copied and handed
+		// around read-only. Only changes when SampleKeyboard is called.
+	const InputSnapshot& GetSnapshot() const;
+
+	// ***** Recording and replay ******************************************************
+
+		// Samples the keyboard, and the mouse and joystick if they are there. Call once
+		// at the start of each frame.
+		// While recording, the states are stored to be written to the file.
+		// While replaying, the states come from the file rather than DirectInput. At the end
+		// of the file the replay stops, and the real devices are sampled from then on.
+	void SampleFrame();
+
+		// Call once a frame with the measured frame time, for the simulation to use.
+		// While recording, it is stored with the frame. While replaying, the recorded
+		// time is returned instead, so the replay runs the same simulation steps.
+		// Returns: the frame time to simulate
+	double RecordFrameTime(double frameTime);
+
+		// Starts recording each frame's states to the file, delta-encoded against the frame before.
+		// seed is stored in the file, to be given back to the replay.
+		// Returns: SUCCESS, or FAILURE with a message in the log file.
+	ErrorType StartRecording(const wchar_t filename[], unsigned int seed);
+
+		// Starts replaying a file made by StartRecording. seed is set to the seed it was recorded with.
+		// Returns: SUCCESS, or FAILURE with a message in the log file.
+	ErrorType StartReplay(const wchar_t filename[], unsigned int& seed);
+
+		// Ends a recording, writing its last frame, or a replay
+	void StopRecording();
+
+	bool IsRecording() const;
+	bool IsReplaying() const;
+
 		// Returns a pointer to an array describing the state of all keys the at the time
 		// of the last keyboard sampling.
 		//      The integer values for the array position of each key are stored in a series of constants.
@@ -1,71 +1,123 @@
+// Modified by 16007006
+// LoadWav takes sounds from the asset pack when they are in it
+// LoadWavAsync decodes sounds on the AssetLoader's worker threads, and PrefetchSounds starts a list of them
+// Loaded sounds are cached by file name and reference counted, so loading the same file again is a lookup
+// One-shot sounds played again before they finish get a voice from a fixed pool, so they overlap
+// The playing itself is done by a SoundBackend - DirectSound, or the headless software mixer
+// LoadMusic and PlayMusic stream long tracks from their files, kept topped up by the audio thread
+// Play, Stop and the setters queue commands for an audio thread, which also keeps the streams topped up
+
 // mysoundengine.cpp	Version 10		9/5/05
 // The definition file for the methods in MySoundEngine, declared in mysoundengine.h
-#define DSBCAPS_CTRLDEFAULT 0x000000E0
-
 #include "mysoundengine.h"
 #include "errorlogger.h"
+#include "DSoundBackend.h"
+#include "MixerBackend.h"
+#include "AssetPack.h"
+#include "AssetLoader.h"
+#include "WavStream.h"
+#include <chrono>
 
 
 MySoundEngine* MySoundEngine::instance=nullptr;
 
-MySoundEngine::MySoundEngine(HWND hwnd)
+// Passed by reference to std::chrono::milliseconds, so it needs a definition
+const int MySoundEngine::STREAMUPDATEMS;
+
+MySoundEngine::MySoundEngine(SoundBackend* pBackend)
 {
+	m_pBackend = pBackend;		// Remember the backend
+
 	// The first sound loaded will have a SoundIndex value of 1
 	m_NextSoundIndex = 1;
+	m_CacheHits = 0;
+	m_CacheMisses = 0;
+
+	// Every voice slot starts empty
+	for(Voice& voice : m_Voices)
+	{
+		voice.m_Buffer = 0;
+		voice.m_Sound = 0;
+		voice.m_Priority = 0;
+		voice.m_Started = 0;
+	}
+	m_VoiceClock = 0;
+	m_VoicesStolen = 0;
+	m_PlaysDropped = 0;
+	m_VoicesPlaying = 0;
+
+	// The first track loaded will have a MusicIndex value of 1
+	m_NextMusicIndex = 1;
+
+	m_CommandsQueued = 0;
+	m_CountsQueued = 0;
+	m_CommandsDone = 0;
+	m_CommandsCoalesced = 0;
+	m_StopAudio = false;
+	m_AudioSleeping = false;
 
 	// Create an empty sound to be returned when a requested sound
 	// is not found in the map
 	MySound temp;
-	temp.lpSoundBuffer=nullptr;
+	temp.m_Buffer=0;
 	temp.m_sourceFileName=L"Unknown sound";
 	m_MySoundList.insert(std::pair<SoundIndex, MySound>(0, temp));
+}
 
-	// Initialise dsound
-	HRESULT err;
-	if (FAILED(DirectSoundCreate8(&DSDEVID_DefaultPlayback, &lpds, NULL)))
+MySoundEngine::~MySoundEngine()
+{
+	// Finish the queued commands and stop the audio thread, so nothing
+	// else touches the backend from here on
+	WaitForCommands();
 	{
-		ErrorLogger::Writeln(L"Failed to create sound player");
-		lpds=nullptr;
+		std::lock_guard<std::mutex> lock(m_AudioLock);
+		m_StopAudio = true;
 	}
+	m_AudioWake.notify_one();
+	if(m_AudioThread.joinable())
+		m_AudioThread.join();
 
-	// Set cooperative level and check for error
-	err=lpds->SetCooperativeLevel(hwnd, DSSCL_NORMAL);
+	// Unload and release sound buffers
+	UnloadAllSounds();
 
-	if (FAILED(err))	// If failed to set cooperative level
+	for(std::pair<const MusicIndex, MyMusic>& item : m_MyMusicList)
 	{
-		ErrorLogger::Writeln(L"Failed to set cooperative level\n");
-		lpds->Release();
-		lpds=nullptr;
-		ErrorLogger::Writeln(ErrorString(err));
+		m_pBackend->ReleaseStream(item.second.m_Stream);
 	}
+	m_MyMusicList.clear();
+
+	// Release DirectSound, or close the mixer's output
+	delete m_pBackend;
+	m_pBackend = nullptr;
 }
 
-MySoundEngine::~MySoundEngine()
+#ifdef _WIN32
+MySoundEngine* MySoundEngine::Start(HWND hwnd)
 {
-	// Unload and release sound buffers
-	UnloadAllSounds();
-	// Release DirectSound
-	Release();
+	return StartWithBackend(new DSoundBackend(hwnd));
 }
+#endif
 
-ErrorType MySoundEngine::Release()
+MySoundEngine* MySoundEngine::StartHeadless(int samplesPerSec, const wchar_t outputFile[])
 {
-	if (lpds)			// If not already null
-	{
-		lpds->Release();
-		lpds=nullptr;
-		return SUCCESS;
-	}
-	return FAILURE;
+	return StartWithBackend(new MixerBackend(samplesPerSec, outputFile));
 }
 
-MySoundEngine* MySoundEngine::Start(HWND hwnd)
+MySoundEngine* MySoundEngine::StartWithBackend(SoundBackend* pBackend)
 {
 	if(instance)
 	{
 		instance->Terminate();
 	}
-	instance = new MySoundEngine(hwnd);
+	instance = new MySoundEngine(pBackend);
+
+	// Carry on without sound - loads will fail and be logged
+	if(pBackend->Start() == FAILURE)
+	{
+		ErrorLogger::Writeln(L"Failed to start the sound backend");
+	}
+
+	instance->m_AudioThread = std::thread(&MySoundEngine::AudioLoop, instance);
 	return instance;
 }
 
@@ -86,11 +138,13 @@ ErrorType MySoundEngine::Terminate()
 		return FAILURE;
 }
 
+#ifdef _WIN32
 const wchar_t* MySoundEngine::ErrorString(HRESULT err)
 {
 	// Returns an error string from DirectX
 	return ERRORSTRING(err);
 }
+#endif
 
 MySoundEngine::MySound& MySoundEngine::FindSound(SoundIndex sound)
 {
@@ -105,207 +159,218 @@ MySoundEngine::MySound& MySoundEngine::FindSound(SoundIndex sound)
 	return it->second;
 }
 
+// Returns the cached sound for this file with one more reference, or zero if it is not cached
+SoundIndex MySoundEngine::FindCachedSound(const wchar_t filename[])
+{
+	std::unordered_map<std::wstring, SoundIndex>::iterator it = m_SoundCache.find(filename);
+	if(it == m_SoundCache.end())
+	{
+		return 0;
+	}
+	m_MySoundList[it->second].m_References++;
+	m_CacheHits++;
+	return it->second;
+}
+
+// Adds a newly loaded sound to the cache, with one reference
+void MySoundEngine::AddToCache(SoundIndex sound)
+{
+	MySound& sb = m_MySoundList[sound];
+	sb.m_References = 1;
+	m_SoundCache[sb.m_sourceFileName] = sound;
+}
+
 SoundIndex MySoundEngine::LoadWav(wchar_t* filename)
-// CAUTION - Multiple early returns
 {
-	if(!lpds)
+	WaitForCommands();				// The audio thread must not be using the sounds
+	// Loaded before - share it
+	SoundIndex sound = FindCachedSound(filename);
+	if(sound)
+	{
+		return sound;
+	}
+
+	m_CacheMisses++;
+	sound = LoadWavFile(filename);
+	if(sound)
 	{
-		ErrorLogger::Writeln(L"Cannot load a sound wave - No pointer to DirectSound.");
-		return 0;			// Early return  **
+		AddToCache(sound);
+	}
+	return sound;
+}
+
+SoundIndex MySoundEngine::LoadWavFile(wchar_t* filename)
+{
+	// If the sound is in the asset pack, the samples are ready to copy
+	AssetPack* pPack = AssetPack::GetInstance();
+	const AssetPackEntry* pEntry = pPack ? pPack->Find(filename) : nullptr;
+	if (pEntry && pEntry->m_Type == ASSET_SOUND)
+	{
+		return LoadPackedWav(filename, *pEntry);
 	}
 
 	MySound temp;
 
-	temp.lpSoundBuffer=nullptr;
 	temp.m_sourceFileName = filename;
 
-	DSBUFFERDESC dsbd;			// "Order form" for the sound
-	WAVEFORMATEX formatdesc;	// Description of the format	
-	HMMIO hWaveFile;		// Handle to the wave file
-	MMCKINFO parent;		// A parent chunk (wav file data chunks)
-	MMCKINFO child;			// A child chunk (wav file data chunks)
+	// The backend reads the file and logs anything wrong with it
+	if(m_pBackend->LoadWav(filename, temp.m_Buffer) == FAILURE)
+	{
+		return 0;
+	}
 
-	UCHAR *tempBuffer;		// Pointer to a buffer to temporarily store sound
-	UCHAR *tempPtr1;		// Pointer to first part of sound buffer
-	UCHAR *tempPtr2;		// Pointer to second part of sound buffer
-	DWORD length1;			// Length of first part of sound buffer
-	DWORD length2;			// Length of second part of sound buffer
+	m_MySoundList.insert(std::pair<SoundIndex, MySound>(m_NextSoundIndex, temp));
 
-	// ***************************************************************
-	// Most of what follows is some fairly complicated bits that
-	// open a pcm wave file, and read the contents into the
-	// directX buffer.
+	return m_NextSoundIndex++;
+}
 
-	// Chunk info initialised
+// Creates a sound buffer straight from the samples in the mapped asset pack.
+// No file is opened and nothing is copied except into the sound buffer.
+SoundIndex MySoundEngine::LoadPackedWav(wchar_t* filename, const AssetPackEntry& entry)
+{
+	MySound temp;
 
-	parent.ckid			= (FOURCC)0;
-	parent.cksize		= 0;
-	parent.fccType		= (FOURCC)0;
-	parent.dwDataOffset	= 0;
-	parent.dwFlags		= 0;
+	temp.m_sourceFileName = filename;
 
-	child=parent;
+	if(CreateBuffer(temp, entry.m_Channels, entry.m_SamplesPerSec, entry.m_BitsPerSample,
+		(const unsigned char*)AssetPack::GetInstance()->GetData(entry), size_t(entry.m_Size)) == FAILURE)
+	{
+		return 0;
+	}
 
-	// Open the wav file
+	m_MySoundList.insert(std::pair<SoundIndex, MySound>(m_NextSoundIndex, temp));
 
-	hWaveFile = mmioOpen(filename, NULL, MMIO_READ|MMIO_ALLOCBUF);	
+	return m_NextSoundIndex++;
+}
 
-	if (!hWaveFile)			// If file could not open
+// Creates the sound's buffer and copies PCM samples already in memory into it
+ErrorType MySoundEngine::CreateBuffer(MySound& sound, int channels, int samplesPerSec, int bitsPerSample,
+	const unsigned char samples[], size_t size)
+{
+	if(m_pBackend->CreateBuffer(channels, samplesPerSec, bitsPerSample, samples, size, sound.m_Buffer) == FAILURE)
 	{
-		ErrorLogger::Write(L"Failed to open sound file ");
-		ErrorLogger::Writeln(filename);
-		return 0;			// Early return  **
+		sound.m_Buffer=0;
+		ErrorLogger::Write(L"Could not create a sound buffer for ");
+		ErrorLogger::Writeln(sound.m_sourceFileName.c_str());
+		return FAILURE;
 	}
+	return SUCCESS;
+}
 
-	// Find the wave section
-	// What is it with sound engineers? Is is because they are musicians
-	// that they like using meaningless terms like "descend"?
-	parent.fccType=mmioFOURCC('W','A','V','E');
-
-	if (mmioDescend(hWaveFile, &parent, NULL, MMIO_FINDRIFF))
+// Reserves a SoundIndex and has the AssetLoader decode the file
+SoundIndex MySoundEngine::LoadWavAsync(const wchar_t filename[])
+{
+	WaitForCommands();
+	// A sound already loaded, or loading, from this file is shared
+	SoundIndex sound = FindCachedSound(filename);
+	if(sound)
 	{
-		ErrorLogger::Write(L"Couldn't find wave section in wave file ");
-		ErrorLogger::Writeln(filename);
-
-		mmioClose(hWaveFile,0);			// Error - close the wave file
-		return 0;			// Early return  **
+		return sound;
 	}
 
-	// Find the format section
-	child.ckid=mmioFOURCC('f','m','t',' ');
-	if (mmioDescend(hWaveFile, &child,&parent, 0)!=MMSYSERR_NOERROR)
+	// Packed sounds need no decoding, so there is nothing to gain from a worker
+	AssetPack* pPack = AssetPack::GetInstance();
+	const AssetPackEntry* pEntry = pPack ? pPack->Find(filename) : nullptr;
+	AssetLoader* pLoader = AssetLoader::GetInstance();
+	if(!pLoader || (pEntry && pEntry->m_Type == ASSET_SOUND))
 	{
-		ErrorLogger::Write(L"Couldn't find format section in wave file ");
-		ErrorLogger::Writeln(filename);
-
-		mmioClose(hWaveFile,0);			// Error - close the wave file
-		return 0;			// Early return  **
+		return LoadWav(const_cast<wchar_t*>(filename));
 	}
 
-	// Read out the format data
-	if (mmioRead(hWaveFile, (char *)&formatdesc, sizeof(formatdesc))!=sizeof(formatdesc))
-	{
-		ErrorLogger::Write(L"Error in wave format of ");
-		ErrorLogger::Writeln(filename);
+	// Reserve the index. The buffer is created by FinishSound.
+	MySound temp;
+	temp.m_sourceFileName = filename;
+	temp.m_Loading = true;
 
-		mmioClose(hWaveFile,0);
-		return 0;			// Early return  **
-	}
+	m_CacheMisses++;
+	sound = m_NextSoundIndex++;
+	m_MySoundList.insert(std::pair<SoundIndex, MySound>(sound, temp));
+	AddToCache(sound);
 
-	// Check this is a pcm format (a standard wav format)
-	if (formatdesc.wFormatTag!=WAVE_FORMAT_PCM)
+	pLoader->Queue(ASSET_SOUND, filename, [this, sound](const LoadedAsset& asset)
 	{
-		ErrorLogger::Write(L"Error in wave format of ");
-		ErrorLogger::Writeln(filename);
+		FinishSound(sound, asset);
+	});
 
-		mmioClose(hWaveFile,0);
-		return 0;			// Early return  **
-	}
+	return sound;
+}
 
-	// Pop upstairs so we can then get down to data chunk
-	if (mmioAscend(hWaveFile, &child, 0)!=MMSYSERR_NOERROR )
+void MySoundEngine::PrefetchSounds(const wchar_t* const filenames[], int count)
+{
+	for(int i=0;i<count;i++)
 	{
-		ErrorLogger::Write(L"Couldn't ascend to data chunk of ");
-		ErrorLogger::Writeln(filename);
-
-		mmioClose(hWaveFile,0);
-		return 0;			// Early return  **
+		LoadWavAsync(filenames[i]);
 	}
+}
 
-	// Now drop into data chunk
-	child.ckid=mmioFOURCC('d','a','t','a');
-
-	if (mmioDescend(hWaveFile, &child,&parent, MMIO_FINDCHUNK)!=MMSYSERR_NOERROR)
+// Called by AssetLoader::Publish once a worker has decoded the sound
+void MySoundEngine::FinishSound(SoundIndex sound, const LoadedAsset& asset)
+{
+	WaitForCommands();
+	// The sound may have been unloaded while it was loading
+	std::map<SoundIndex, MySound>::iterator it = m_MySoundList.find(sound);
+	if(it == m_MySoundList.end() || !it->second.m_Loading)
 	{
-		ErrorLogger::Write(L"Couldn't find data section in wave file ");
-		ErrorLogger::Writeln(filename);
-
-		mmioClose(hWaveFile,0);			// Error - close the wave file
-		return 0;			// Early return  **
+		return;
 	}
+	it->second.m_Loading = false;
 
-
-	// *************************************************************
-	// Now that the info from the file has been stored, it is possible to
-	// Create a sound buffer ready to hold the data, so it back to directX
-
-	// Set the descriptor for the sound to be created.
-
-	memset(&dsbd,0,sizeof(dsbd));
-	dsbd.dwSize=sizeof(dsbd);
-	dsbd.dwFlags = DSBCAPS_CTRLDEFAULT;				// Default features
-	dsbd.dwBufferBytes=child.cksize;				// Set bytes needed to store
-	dsbd.lpwfxFormat=&formatdesc;					// The format descriptor (got earlier from the file)
-
-	HRESULT err = lpds->CreateSoundBuffer(&dsbd,&(temp.lpSoundBuffer),NULL);
-	if (FAILED(err))
+	if(asset.m_Result == SUCCESS)
 	{
-		temp.lpSoundBuffer=nullptr;
-		ErrorLogger::Writeln(L"Could not create a sound buffer");
-		ErrorLogger::Writeln(MySoundEngine::ErrorString(err));
-		return 0;			// Early return  **
+		if(CreateBuffer(it->second, asset.m_Channels, asset.m_SamplesPerSec, asset.m_BitsPerSample,
+			asset.m_Samples.data(), asset.m_Samples.size()) == FAILURE)
+		{
+			m_SoundCache.erase(it->second.m_sourceFileName);
+			m_MySoundList.erase(it);
+		}
+		return;
 	}
 
-	// ************************************************************
-	// The file is open, the buffer is created. Now to read all the data in.
-
-	// Load data into a buffer
-	tempBuffer = (UCHAR *)malloc(child.cksize);
-	mmioRead(hWaveFile, (char*)tempBuffer, child.cksize);
-
-	// Close the file
-	mmioClose(hWaveFile,0);
-
-	// Locking the Dsound buffer
-
-	err = temp.lpSoundBuffer->Lock(0, child.cksize, (void**) &tempPtr1,
-							&length1, (void**) &tempPtr2,
-							&length2, DSBLOCK_FROMWRITECURSOR);
-	if(FAILED(err))
+	// The decoder could not read it, so let LoadWavFile try and move its buffer across
+	SoundIndex loaded = LoadWavFile(&it->second.m_sourceFileName[0]);
+	if(loaded)
 	{
-		ErrorLogger::Writeln(L"Couldn't lock the sound buffer.");
-		ErrorLogger::Writeln(MySoundEngine::ErrorString(err));
-		free(tempBuffer);
-		temp.lpSoundBuffer->Release();
-		temp.lpSoundBuffer=nullptr;
-		return 0;			// Early return  **
+		it->second.m_Buffer = m_MySoundList[loaded].m_Buffer;
+		m_MySoundList.erase(loaded);
 	}
-
-	// Copy the two bits of the buffer
-	memcpy(tempPtr1, tempBuffer, length1);
-	memcpy(tempPtr2, tempBuffer+length1, length2);
-
-	// Unlock the Dsound buffer
-	err = temp.lpSoundBuffer->Unlock(tempPtr1,
-							length1, tempPtr2,
-							length2);
-	if(FAILED(err))
+	else
 	{
-		ErrorLogger::Writeln(L"Couldn't unlock the sound buffer.");
-		ErrorLogger::Writeln(MySoundEngine::ErrorString(err));
-		free(tempBuffer);
-		temp.lpSoundBuffer->Release();
-		temp.lpSoundBuffer=nullptr;
-		return 0;			// Early return  **
+		m_SoundCache.erase(it->second.m_sourceFileName);
+		m_MySoundList.erase(it);
 	}
-
-	free(tempBuffer);
-
-	m_MySoundList.insert(std::pair<SoundIndex, MySound>(m_NextSoundIndex, temp));
-
-	return m_NextSoundIndex++;
 }
 
 ErrorType MySoundEngine::Unload(SoundIndex sound)
 {
+	WaitForCommands();
 	std::map<SoundIndex, MySound>::iterator it = m_MySoundList.find(sound);
+	if (it == m_MySoundList.end() || it->first == 0)
+	{
+		return FAILURE;
+	}
 	MySound& sb = it->second;
 
-	if (sb.lpSoundBuffer)				// If lpSoundBuffer is not null
+	// Others are still using it
+	if (--sb.m_References > 0)
+	{
+		return SUCCESS;
+	}
+	m_SoundCache.erase(sb.m_sourceFileName);
+
+	// Still loading - FinishSound will find the index gone
+	if (sb.m_Loading)
+	{
+		m_MySoundList.erase(it);
+		return SUCCESS;
+	}
+
+	if (sb.m_Buffer)					// If the buffer was created
 	{
-		sb.lpSoundBuffer->Release();	// Attempt to release it
+		ReleaseVoices(sound);			// Copies first
 
-		sb.lpSoundBuffer=nullptr;
+		m_pBackend->ReleaseBuffer(sb.m_Buffer);
+
+		sb.m_Buffer=0;
 
 		m_MySoundList.erase(it);
 
@@ -316,17 +381,19 @@ ErrorType MySoundEngine::Unload(SoundIndex sound)
 
 ErrorType MySoundEngine::UnloadAllSounds()
 {
+	WaitForCommands();
 	ErrorType answer = SUCCESS;
+	ReleaseVoices(0);
 	std::map<SoundIndex, MySound>::iterator it = m_MySoundList.begin();
 	for(;it!= m_MySoundList.end();it++ )
 	{
 		MySound& sb = it->second;
 
-		if (sb.lpSoundBuffer)				// If lpSoundBuffer is not null
+		if (sb.m_Buffer)					// If the buffer was created
 		{
-			sb.lpSoundBuffer->Release();	// Attempt to release it
+			m_pBackend->ReleaseBuffer(sb.m_Buffer);
 
-			sb.lpSoundBuffer=nullptr;
+			sb.m_Buffer=0;
 		}
 	}
 
@@ -335,118 +402,640 @@ ErrorType MySoundEngine::UnloadAllSounds()
 	it = m_MySoundList.begin();
 	it++;
 	m_MySoundList.erase(it, m_MySoundList.end());
+	m_SoundCache.clear();
 	return answer;
 }
 
-ErrorType MySoundEngine::SetVolume(SoundIndex sound, int volume)
+void MySoundEngine::GetCacheStats(int& hits, int& misses, int& sounds) const
+{
+	hits = m_CacheHits;
+	misses = m_CacheMisses;
+	sounds = int(m_SoundCache.size());
+}
+
+ErrorType MySoundEngine::RunSetVolume(SoundIndex sound, int volume)
 {
 	MySound& sb = FindSound(sound);
-	if(!sb.lpSoundBuffer)
+	if(sb.m_Loading)					// Not published by the AssetLoader yet
+	{
+		return SUCCESS;
+	}
+	if(!sb.m_Buffer)
 	{
 		ErrorLogger::Writeln(L"Sound not found.");
 		return FAILURE;
 	}
-	HRESULT err = sb.lpSoundBuffer->SetVolume(volume);
-	if (FAILED(err))
+	if(sb.m_Volume == volume)			// Already set
+	{
+		m_CommandsCoalesced++;
+		return SUCCESS;
+	}
+	if (m_pBackend->SetVolume(sb.m_Buffer, volume) == FAILURE)
 	{
 		ErrorLogger::Write(L"Failed to set volume for a sound:");
 		ErrorLogger::Writeln(sb.m_sourceFileName.c_str());
-		ErrorLogger::Writeln(MySoundEngine::ErrorString(err));
 		return FAILURE;
 	}
+	sb.m_Volume = volume;
+	// Keep the voices matching the sound
+	for(Voice& voice : m_Voices)
+	{
+		if(voice.m_Buffer && voice.m_Sound == sound)
+			m_pBackend->SetVolume(voice.m_Buffer, volume);
+	}
 	return SUCCESS;
 }
 
-ErrorType MySoundEngine::SetFrequency(SoundIndex sound, int frequency)
+ErrorType MySoundEngine::RunSetFrequency(SoundIndex sound, int frequency)
 {
 	MySound& sb = FindSound(sound);
+	if(sb.m_Loading)					// Not published by the AssetLoader yet
+	{
+		return SUCCESS;
+	}
 
-	if(!sb.lpSoundBuffer)
+	if(!sb.m_Buffer)
 	{
 		ErrorLogger::Writeln(L"Sound not found in SetFrequency.");
 		return FAILURE;
 	}
-	HRESULT err = sb.lpSoundBuffer->SetFrequency(frequency);
-	if (FAILED(err))
+	if(sb.m_Frequency == frequency)		// Already set
+	{
+		m_CommandsCoalesced++;
+		return SUCCESS;
+	}
+	if (m_pBackend->SetFrequency(sb.m_Buffer, frequency) == FAILURE)
 	{
 		ErrorLogger::Write(L"Failed to set frequency for a sound: ");
 		ErrorLogger::Writeln(sb.m_sourceFileName.c_str());
-		ErrorLogger::Writeln(MySoundEngine::ErrorString(err));
 		return FAILURE;
 	}
+	sb.m_Frequency = frequency;
+	// Keep the voices matching the sound
+	for(Voice& voice : m_Voices)
+	{
+		if(voice.m_Buffer && voice.m_Sound == sound)
+			m_pBackend->SetFrequency(voice.m_Buffer, frequency);
+	}
 	return SUCCESS;
 }
 
-ErrorType MySoundEngine::SetPan(SoundIndex sound, int pan)
+ErrorType MySoundEngine::RunSetPan(SoundIndex sound, int pan)
 {
 	MySound& sb = FindSound(sound);
-	if(!sb.lpSoundBuffer)
+	if(sb.m_Loading)					// Not published by the AssetLoader yet
+	{
+		return SUCCESS;
+	}
+	if(!sb.m_Buffer)
 	{
 		ErrorLogger::Writeln(L"Sound buffer not created.");
 		return FAILURE;
 	}
-	HRESULT err = sb.lpSoundBuffer->SetPan(pan);
-	if (FAILED(err))
+	if(sb.m_Pan == pan)					// Already set
+	{
+		m_CommandsCoalesced++;
+		return SUCCESS;
+	}
+	if (m_pBackend->SetPan(sb.m_Buffer, pan) == FAILURE)
 	{
 		ErrorLogger::Write(L"Failed to pan a sound:");
 		ErrorLogger::Writeln(sb.m_sourceFileName.c_str());
-		ErrorLogger::Writeln(MySoundEngine::ErrorString(err));
 		return FAILURE;
 	}
+	sb.m_Pan = pan;
+	// Keep the voices matching the sound
+	for(Voice& voice : m_Voices)
+	{
+		if(voice.m_Buffer && voice.m_Sound == sound)
+			m_pBackend->SetPan(voice.m_Buffer, pan);
+	}
 	return SUCCESS;
 }
 
-ErrorType MySoundEngine::Play(SoundIndex sound, bool looping)
+ErrorType MySoundEngine::RunPlay(SoundIndex sound, bool looping, int priority)
 {
-	// The first two numbers in the Play() functions below
-	// are always zero. The third controls whether to loop,
-	// or just play once.
-
 	MySound& sb = FindSound(sound);
 
-	if(!sb.lpSoundBuffer)
+	if(sb.m_Loading)					// Not published by the AssetLoader yet
+	{
+		return SUCCESS;
+	}
+
+	if(!sb.m_Buffer)
 	{
 		ErrorLogger::Writeln(L"Sound buffer not created.");
 	}
 	else
 	{
+		int buffer = sb.m_Buffer;
+
+		// Already looping - playing it again would change nothing
+		if(looping && sb.m_Looping)
+		{
+			m_CommandsCoalesced++;
+			return SUCCESS;
+		}
 
-		DWORD flag =0;
-		if(looping)
+		// Playing the buffer again would carry on from where it is, so a
+		// one-shot that is still playing is played on a voice instead
+		if(!looping && m_pBackend->IsPlaying(sb.m_Buffer))
 		{
-			flag = DSBPLAY_LOOPING;
+			Voice* pVoice = FindVoice(sound, priority);
+			if(!pVoice)
+			{
+				m_PlaysDropped++;
+				return FAILURE;
+			}
+			pVoice->m_Priority = priority;
+			pVoice->m_Started = m_VoiceClock++;
+			m_pBackend->Rewind(pVoice->m_Buffer);
+			buffer = pVoice->m_Buffer;
 		}
-		HRESULT err = sb.lpSoundBuffer->Play(0,0, flag);
-		if (FAILED(err))
+
+		if (m_pBackend->Play(buffer, looping) == FAILURE)
 		{
 			ErrorLogger::Write(L"Failed to play a sound: ");
 			ErrorLogger::Writeln(sb.m_sourceFileName.c_str());
-			ErrorLogger::Writeln(MySoundEngine::ErrorString(err));
 			return FAILURE;	
 		}
+		if(buffer == sb.m_Buffer)
+			sb.m_Looping = looping;
+		sb.m_Stopped = false;
 		return SUCCESS;
-	}	// if lpSoundBuffer not NULL
+	}	// if buffer created
 	return FAILURE;	
 }
 
-ErrorType MySoundEngine::Stop(SoundIndex sound)
+MySoundEngine::Voice* MySoundEngine::FindVoice(SoundIndex sound, int priority)
+{
+	// Lower priority first, then older
+	auto weaker = [](const Voice& a, const Voice& b)
+	{
+		return a.m_Priority < b.m_Priority || (a.m_Priority == b.m_Priority && a.m_Started < b.m_Started);
+	};
+
+	Voice* pIdleSame = nullptr;			// Idle copy of this sound
+	Voice* pEmpty = nullptr;			// Empty slot
+	Voice* pIdleOther = nullptr;		// Idle copy of another sound
+	Voice* pWeakestSame = nullptr;		// Weakest playing copy of this sound
+	Voice* pWeakest = nullptr;			// Weakest playing voice of any sound
+	int voicesOfSound = 0;
+
+	for(Voice& voice : m_Voices)
+	{
+		if(!voice.m_Buffer)
+		{
+			if(!pEmpty)
+				pEmpty = &voice;
+			continue;
+		}
+
+		bool playing = m_pBackend->IsPlaying(voice.m_Buffer);
+		if(voice.m_Sound == sound)
+		{
+			voicesOfSound++;
+			if(!playing && !pIdleSame)
+				pIdleSame = &voice;
+			if(playing && (!pWeakestSame || weaker(voice, *pWeakestSame)))
+				pWeakestSame = &voice;
+		}
+		else if(!playing && !pIdleOther)
+		{
+			pIdleOther = &voice;
+		}
+		if(playing && (!pWeakest || weaker(voice, *pWeakest)))
+			pWeakest = &voice;
+	}
+
+	if(pIdleSame)
+	{
+		return pIdleSame;
+	}
+
+	Voice* pChosen = nullptr;
+	if(voicesOfSound < MAXVOICESPERSOUND)
+	{
+		pChosen = pEmpty ? pEmpty : pIdleOther;
+		if(!pChosen && pWeakest && pWeakest->m_Priority <= priority)
+		{
+			pChosen = pWeakest;
+			m_VoicesStolen++;
+		}
+	}
+	else if(pWeakestSame && pWeakestSame->m_Priority <= priority)
+	{
+		pChosen = pWeakestSame;
+		m_VoicesStolen++;
+	}
+
+	if(!pChosen)
+	{
+		return nullptr;
+	}
+
+	// Already a copy of this sound - just start it again
+	if(pChosen->m_Buffer && pChosen->m_Sound == sound)
+	{
+		m_pBackend->Stop(pChosen->m_Buffer);
+		return pChosen;
+	}
+
+	// Turn the slot into a copy of this sound
+	if(pChosen->m_Buffer)
+	{
+		m_pBackend->ReleaseBuffer(pChosen->m_Buffer);
+		pChosen->m_Buffer = 0;
+	}
+	if(m_pBackend->DuplicateBuffer(FindSound(sound).m_Buffer, pChosen->m_Buffer) == FAILURE)
+	{
+		pChosen->m_Buffer = 0;
+		ErrorLogger::Writeln(L"Could not create a voice for a sound.");
+		return nullptr;
+	}
+	pChosen->m_Sound = sound;
+	return pChosen;
+}
+
+void MySoundEngine::ReleaseVoices(SoundIndex sound)
+{
+	for(Voice& voice : m_Voices)
+	{
+		if(voice.m_Buffer && (sound == 0 || voice.m_Sound == sound))
+		{
+			m_pBackend->ReleaseBuffer(voice.m_Buffer);
+			voice.m_Buffer = 0;
+		}
+	}
+}
+
+void MySoundEngine::GetVoiceStats(int& playing, int& stolen, int& dropped)
+{
+	playing = m_VoicesPlaying.load(std::memory_order_relaxed);
+	stolen = m_VoicesStolen.load(std::memory_order_relaxed);
+	dropped = m_PlaysDropped.load(std::memory_order_relaxed);
+
+	// Counted again by the next call
+	SoundCommand command;
+	command.m_Type = SoundCommand::COUNTVOICES;
+	command.m_Sound = 0;
+	command.m_Value = 0;
+	command.m_Looping = false;
+	QueueCommand(command);
+	m_CountsQueued++;
+}
+
+void MySoundEngine::RunCountVoices()
+{
+	int playing = 0;
+	for(const Voice& voice : m_Voices)
+	{
+		if(voice.m_Buffer && m_pBackend->IsPlaying(voice.m_Buffer))
+			playing++;
+	}
+	m_VoicesPlaying.store(playing, std::memory_order_relaxed);
+}
+
+ErrorType MySoundEngine::RunStop(SoundIndex sound)
 {
 	MySound& sb = FindSound(sound);
-	if(!sb.lpSoundBuffer)
+	if(sb.m_Loading)					// Not published by the AssetLoader yet
+	{
+		return SUCCESS;
+	}
+	if(!sb.m_Buffer)
 	{
 		ErrorLogger::Writeln(L"Sound buffer not created.");
 		return FAILURE;
 	}
+	if(sb.m_Stopped)					// Nothing has played since the last Stop
+	{
+		m_CommandsCoalesced++;
+		return SUCCESS;
+	}
 
-	HRESULT err = sb.lpSoundBuffer->Stop();
-	if (FAILED(err))
+	if (m_pBackend->Stop(sb.m_Buffer) == FAILURE)
 	{
 		ErrorLogger::Write(L"Failed to stop a sound: ");
 		ErrorLogger::Writeln(sb.m_sourceFileName.c_str());
-		ErrorLogger::Writeln(MySoundEngine::ErrorString(err));
 		return FAILURE;
 	}
+	sb.m_Looping = false;
+	sb.m_Stopped = true;
+
+	for(Voice& voice : m_Voices)
+	{
+		if(voice.m_Buffer && voice.m_Sound == sound)
+			m_pBackend->Stop(voice.m_Buffer);
+	}
+
+	return SUCCESS;
+}
+
+ErrorType MySoundEngine::RenderAudio(int numFrames)
+{
+	// Everything played before this call is heard in this block
+	WaitForCommands();
+	return m_pBackend->Render(numFrames);
+}
+
+unsigned long long MySoundEngine::GetMixChecksum() const
+{
+	WaitForCommands();
+	return m_pBackend->GetMixChecksum();
+}
+
+// *******************************************************************
+
+void MySoundEngine::AudioLoop()
+{
+	std::chrono::steady_clock::time_point lastUpdate;
+	while(!m_StopAudio)
+	{
+		unsigned int ran = 0;
+		SoundCommand command;
+		while(m_Commands.TryPop(command))
+		{
+			switch(command.m_Type)
+			{
+			case SoundCommand::PLAY:
+				RunPlay(command.m_Sound, command.m_Looping, command.m_Value);
+				break;
+			case SoundCommand::STOP:
+				RunStop(command.m_Sound);
+				break;
+			case SoundCommand::SETVOLUME:
+				RunSetVolume(command.m_Sound, command.m_Value);
+				break;
+			case SoundCommand::SETPAN:
+				RunSetPan(command.m_Sound, command.m_Value);
+				break;
+			case SoundCommand::SETFREQUENCY:
+				RunSetFrequency(command.m_Sound, command.m_Value);
+				break;
+			case SoundCommand::COUNTVOICES:
+				RunCountVoices();
+				break;
+			}
+			ran++;
+		}
+
+		// Hand the sounds back, and wake WaitForCommands if it is waiting
+		if(ran > 0)
+		{
+			m_CommandsDone.fetch_add(ran, std::memory_order_release);
+			{
+				std::lock_guard<std::mutex> lock(m_AudioLock);
+			}
+			m_CommandsFinished.notify_all();
+		}
+
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if(now - lastUpdate >= std::chrono::milliseconds(STREAMUPDATEMS))
+		{
+			m_pBackend->UpdateStreams();
+			lastUpdate = now;
+		}
+
+		// Sleep until a command is queued or the streams are next due. The fence pairs with
+		// the one in QueueCommand - either it sees m_AudioSleeping, or the queue is seen not empty.
+		std::unique_lock<std::mutex> lock(m_AudioLock);
+		m_AudioSleeping.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		m_AudioWake.wait_until(lock, lastUpdate + std::chrono::milliseconds(STREAMUPDATEMS), [this]()
+		{
+			return m_StopAudio || !m_Commands.IsEmpty();
+		});
+		m_AudioSleeping.store(false, std::memory_order_relaxed);
+	}
+}	// AudioLoop
+
+// *******************************************************************
+
+void MySoundEngine::QueueCommand(const SoundCommand& command)
+{
+	// Full - the audio thread is behind, so wait for it rather than lose the command
+	while(!m_Commands.TryPush(command))
+	{
+		std::this_thread::yield();
+	}
+	m_CommandsQueued++;
+
+	// Only wake the audio thread if it is asleep - while it is running it will find the command.
+	// Taking the lock means it is either waiting, and is woken, or has yet to check the queue.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(m_AudioSleeping.load(std::memory_order_relaxed))
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_AudioLock);
+		}
+		m_AudioWake.notify_one();
+	}
+}
+
+// *******************************************************************
+
+void MySoundEngine::WaitForCommands() const
+{
+	if(m_CommandsDone.load(std::memory_order_acquire) == m_CommandsQueued)
+		return;
+
+	std::unique_lock<std::mutex> lock(m_AudioLock);
+	m_CommandsFinished.wait(lock, [this]()
+	{
+		return m_CommandsDone.load(std::memory_order_acquire) == m_CommandsQueued;
+	});
+}
+
+// *******************************************************************
+
+ErrorType MySoundEngine::Play(SoundIndex sound, bool looping, int priority)
+{
+	MySound& sb = FindSound(sound);
+	if(sb.m_Loading)					// Not published by the AssetLoader yet
+	{
+		return SUCCESS;
+	}
+	if(!sb.m_Buffer)
+	{
+		ErrorLogger::Writeln(L"Sound buffer not created.");
+		return FAILURE;
+	}
+	SoundCommand command = { SoundCommand::PLAY, sound, priority, looping };
+	QueueCommand(command);
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType MySoundEngine::Stop(SoundIndex sound)
+{
+	MySound& sb = FindSound(sound);
+	if(sb.m_Loading)					// Not published by the AssetLoader yet
+	{
+		return SUCCESS;
+	}
+	if(!sb.m_Buffer)
+	{
+		ErrorLogger::Writeln(L"Sound buffer not created.");
+		return FAILURE;
+	}
+	SoundCommand command = { SoundCommand::STOP, sound, 0, false };
+	QueueCommand(command);
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType MySoundEngine::SetVolume(SoundIndex sound, int volume)
+{
+	MySound& sb = FindSound(sound);
+	if(sb.m_Loading)					// Not published by the AssetLoader yet
+	{
+		return SUCCESS;
+	}
+	if(!sb.m_Buffer)
+	{
+		ErrorLogger::Writeln(L"Sound buffer not created.");
+		return FAILURE;
+	}
+	SoundCommand command = { SoundCommand::SETVOLUME, sound, volume, false };
+	QueueCommand(command);
+	return SUCCESS;
+}
 
+// *******************************************************************
+
+ErrorType MySoundEngine::SetPan(SoundIndex sound, int pan)
+{
+	MySound& sb = FindSound(sound);
+	if(sb.m_Loading)					// Not published by the AssetLoader yet
+	{
+		return SUCCESS;
+	}
+	if(!sb.m_Buffer)
+	{
+		ErrorLogger::Writeln(L"Sound buffer not created.");
+		return FAILURE;
+	}
+	SoundCommand command = { SoundCommand::SETPAN, sound, pan, false };
+	QueueCommand(command);
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+ErrorType MySoundEngine::SetFrequency(SoundIndex sound, int frequency)
+{
+	MySound& sb = FindSound(sound);
+	if(sb.m_Loading)					// Not published by the AssetLoader yet
+	{
+		return SUCCESS;
+	}
+	if(!sb.m_Buffer)
+	{
+		ErrorLogger::Writeln(L"Sound buffer not created.");
+		return FAILURE;
+	}
+	SoundCommand command = { SoundCommand::SETFREQUENCY, sound, frequency, false };
+	QueueCommand(command);
+	return SUCCESS;
+}
+
+// *******************************************************************
+
+void MySoundEngine::GetCommandStats(int& queued, int& coalesced) const
+{
+	queued = int(m_CommandsQueued - m_CountsQueued);
+	coalesced = m_CommandsCoalesced.load(std::memory_order_relaxed);
+}
+
+// *******************************************************************
+
+MusicIndex MySoundEngine::LoadMusic(const wchar_t filename[])
+{
+	WaitForCommands();
+	WavStream* pSource = new WavStream;
+	if(pSource->Open(filename) == FAILURE)
+	{
+		delete pSource;
+		return 0;
+	}
+
+	// The backend takes the source, even if it fails
+	MyMusic newMusic;
+	newMusic.m_sourceFileName = filename;
+	if(m_pBackend->CreateStream(pSource, newMusic.m_Stream) == FAILURE)
+	{
+		ErrorLogger::Write(L"Failed to create a stream for ");
+		ErrorLogger::Writeln(filename);
+		return 0;
+	}
+
+	MusicIndex music = m_NextMusicIndex++;
+	m_MyMusicList[music] = newMusic;
+	return music;
+}	// LoadMusic
+
+// *******************************************************************
+
+ErrorType MySoundEngine::PlayMusic(MusicIndex music, bool looping)
+{
+	std::map<MusicIndex, MyMusic>::iterator it = m_MyMusicList.find(music);
+	if(it == m_MyMusicList.end())
+	{
+		ErrorLogger::Writeln(L"Music not found. Cannot play.");
+		return FAILURE;
+	}
+	return m_pBackend->PlayStream(it->second.m_Stream, looping);
+}
+
+// *******************************************************************
+
+ErrorType MySoundEngine::StopMusic(MusicIndex music)
+{
+	std::map<MusicIndex, MyMusic>::iterator it = m_MyMusicList.find(music);
+	if(it == m_MyMusicList.end())
+	{
+		ErrorLogger::Writeln(L"Music not found. Cannot stop.");
+		return FAILURE;
+	}
+	return m_pBackend->StopStream(it->second.m_Stream);
+}
+
+// *******************************************************************
+
+ErrorType MySoundEngine::SetMusicVolume(MusicIndex music, int volume)
+{
+	std::map<MusicIndex, MyMusic>::iterator it = m_MyMusicList.find(music);
+	if(it == m_MyMusicList.end())
+	{
+		ErrorLogger::Writeln(L"Music not found. Cannot set volume.");
+		return FAILURE;
+	}
+	return m_pBackend->SetStreamVolume(it->second.m_Stream, volume);
+}
+
+// *******************************************************************
+
+bool MySoundEngine::IsMusicPlaying(MusicIndex music)
+{
+	std::map<MusicIndex, MyMusic>::iterator it = m_MyMusicList.find(music);
+	return it != m_MyMusicList.end() && m_pBackend->IsStreamPlaying(it->second.m_Stream);
+}
+
+// *******************************************************************
+
+ErrorType MySoundEngine::UnloadMusic(MusicIndex music)
+{
+	std::map<MusicIndex, MyMusic>::iterator it = m_MyMusicList.find(music);
+	if(it == m_MyMusicList.end())
+	{
+		ErrorLogger::Writeln(L"Music not found. Cannot unload.");
+		return FAILURE;
+	}
+	m_pBackend->ReleaseStream(it->second.m_Stream);
+	m_MyMusicList.erase(it);
 	return SUCCESS;
 }
 
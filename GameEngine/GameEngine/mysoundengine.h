@@ -1,3 +1,12 @@
+// Modified by 16007006
+// Sounds in the asset pack are copied straight from the mapped pack instead of being loaded from their files
+// LoadWavAsync decodes sounds on the AssetLoader's worker threads, and PrefetchSounds starts a list of them
+// Loaded sounds are cached by file name and reference counted, so loading the same file again is a lookup
+// One-shot sounds played again before they finish get a voice from a fixed pool, so they overlap
+// The playing itself is done by a SoundBackend - DirectSound, or the headless software mixer
+// Long music tracks are streamed from their files by LoadMusic and PlayMusic, kept topped up by the audio thread
+// Play, Stop and the setters queue commands for an audio thread instead of calling the backend
+
 // MySoundEngine.cpp
 // Shell engine version 2020
 // Chris Rook
@@ -5,51 +14,199 @@
 
 #pragma once
 
-#include <dsound.h>		// directX draw
+#ifdef _WIN32
+#include <windows.h>		// For HWND
+#endif
+#include "SoundBackend.h"
 #include "errortype.h"
 #include <map>
+#include <unordered_map>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <climits>
+#include "SPSCQueue.h"
+
+struct AssetPackEntry;
+struct LoadedAsset;
 
 typedef unsigned int SoundIndex;
 typedef unsigned int MusicIndex;
 
-#pragma comment(lib, "dsound.lib")
-#pragma comment(lib, "winmm.lib")
-
 // Class to load an play .wav files
+// The DirectSound calls are made by DSoundBackend. StartHeadless uses
+// MixerBackend instead, which needs no window or sound card.
+// Only one thread, the game's, may call the engine. Play, Stop, SetVolume, SetPan and
+// SetFrequency do not wait for the backend - they queue a command for the audio thread.
+// Everything else waits for the queued commands to finish first.
 class MySoundEngine
 {
 	struct MySound
 	{
-		// This is a long pointer to the DSound buffer. DirectX
-		// functions can be called on it, once it it initialised.
-		LPDIRECTSOUNDBUFFER lpSoundBuffer;
+		// The backend's handle for the sound's buffer. Zero if it
+		// has not been created.
+		int m_Buffer;
 		std::wstring m_sourceFileName;
+		bool m_Loading;		// True while the AssetLoader is decoding the file. The sound does nothing until it is published.
+		int m_References;	// Loads not yet matched by an Unload. The buffer is released when this reaches zero.
+
+		// What the audio thread last did to the buffer, so repeated commands can be skipped.
+		// Only used on the audio thread.
+		bool m_Looping;		// Played looping, and not stopped since
+		bool m_Stopped;		// Stopped, or never played, and not played since
+		int m_Volume;		// INT_MIN until set
+		int m_Pan;
+		int m_Frequency;
+
+		MySound() : m_Buffer(0), m_Loading(false), m_References(0), m_Looping(false), m_Stopped(true),
+			m_Volume(INT_MIN), m_Pan(INT_MIN), m_Frequency(INT_MIN) {}
 	};
 	std::map<SoundIndex, MySound> m_MySoundList;	// Map of MyPicture objects
 	SoundIndex m_NextSoundIndex;
+	std::unordered_map<std::wstring, SoundIndex> m_SoundCache;	// Loaded (or loading) sounds, by file name
+	int m_CacheHits;			// Loads answered from m_SoundCache
+	int m_CacheMisses;			// Loads that had to read a file or the asset pack
+
+public:
+	static const int MAXVOICES = 32;			// Extra copies of sounds that can exist at once, across all sounds
+	static const int MAXVOICESPERSOUND = 4;		// Extra copies any one sound can have
+
+private:
+	// An extra copy of a sound, so a one-shot can play again before it has finished.
+	// The copy is made with SoundBackend::DuplicateBuffer, so it shares the sound's samples.
+	struct Voice
+	{
+		int m_Buffer;						// The copy. Zero if the slot is empty.
+		SoundIndex m_Sound;					// The sound it is a copy of
+		int m_Priority;						// Priority of the Play that last started it
+		unsigned int m_Started;				// m_VoiceClock when it was last started, to find the oldest
+	};
+	Voice m_Voices[MAXVOICES];
+	unsigned int m_VoiceClock;		// Counts voices started
+	std::atomic<int> m_VoicesStolen;	// Playing voices cut off to play something else
+	std::atomic<int> m_PlaysDropped;	// Plays with no voice they were allowed to take
+	std::atomic<int> m_VoicesPlaying;	// Playing when the audio thread last counted them
+
+	// A music track, streamed from its file while it plays rather than loaded whole
+	struct MyMusic
+	{
+		int m_Stream;				// The backend's handle for the stream
+		std::wstring m_sourceFileName;
+	};
+	std::map<MusicIndex, MyMusic> m_MyMusicList;
+	MusicIndex m_NextMusicIndex;
+
+	// A call to Play, Stop or a setter, waiting for the audio thread
+	struct SoundCommand
+	{
+		enum Type { PLAY, STOP, SETVOLUME, SETPAN, SETFREQUENCY, COUNTVOICES };
+		Type m_Type;
+		SoundIndex m_Sound;
+		int m_Value;		// Priority for PLAY, or the volume, pan or frequency
+		bool m_Looping;		// PLAY only
+	};
+	static const unsigned int COMMANDQUEUESIZE = 1024;
+	SPSCQueue<SoundCommand, COMMANDQUEUESIZE> m_Commands;	// The game thread pushes, the audio thread pops
+	unsigned int m_CommandsQueued;				// Pushed so far. Only used on the game thread.
+	unsigned int m_CountsQueued;				// The COUNTVOICES commands among them, left out of the stats
+	std::atomic<unsigned int> m_CommandsDone;	// Carried out so far by the audio thread
+	std::atomic<int> m_CommandsCoalesced;		// Carried out by doing nothing, as they would change nothing
+	std::thread m_AudioThread;					// Runs the commands and keeps the streams topped up
+	std::atomic<bool> m_StopAudio;				// Tells m_AudioThread to finish
+	mutable std::mutex m_AudioLock;				// Taken to sleep on, or to wake, the two below
+	std::condition_variable m_AudioWake;		// Signalled when a command is queued while the audio thread sleeps, or on m_StopAudio
+	std::atomic<bool> m_AudioSleeping;			// Set while the audio thread waits on m_AudioWake, so QueueCommand only wakes it then
+	mutable std::condition_variable m_CommandsFinished;	// Signalled when the audio thread finishes a batch
+
+	// How often the streams are topped up. Well inside the time
+	// either backend's ring of samples takes to play.
+	static const int STREAMUPDATEMS = 10;
+
+	// The body of m_AudioThread. Runs commands as they arrive and calls
+	// SoundBackend::UpdateStreams, until m_StopAudio is set. Sleeps on m_AudioWake in between.
+	void AudioLoop();
+
+	// Pushes a command for the audio thread and wakes it. If the queue is full, waits for room.
+	void QueueCommand(const SoundCommand& command);
+
+	// Postcondition:	Every queued command has been carried out, and the audio thread is
+	//					not touching the sounds, voices or backend buffers. Called before the
+	//					game thread changes any of them, or reads the results.
+	void WaitForCommands() const;
+
+	// The work of Play, Stop and the setters, on the audio thread. As the public
+	// versions used to be, but a command that would change nothing is skipped.
+	ErrorType RunPlay(SoundIndex sound, bool looping, int priority);
+	ErrorType RunStop(SoundIndex sound);
+	ErrorType RunSetVolume(SoundIndex sound, int volume);
+	ErrorType RunSetPan(SoundIndex sound, int pan);
+	ErrorType RunSetFrequency(SoundIndex sound, int frequency);
+
+	// Sets m_VoicesPlaying to the voices playing now. Run as a command, as the voices and
+	// backend are only the audio thread's while it has commands the game thread waits on.
+	void RunCountVoices();
 
 private:
+	SoundBackend* m_pBackend;		// Does the actual playing. Owned by the engine.
+
 	// Simply creates a MySoundEngine
-	// hwnd is the handle of the main window
-	// Precondition:
-	//	DirectSound is installed on the computer
-	MySoundEngine(HWND hwnd);
+	// pBackend is the backend to play sounds with. The engine takes ownership of it.
+	MySoundEngine(SoundBackend* pBackend);
 
-	// The destructor for the MyInstrument. Calls Release().
+	// The destructor for the MyInstrument. Stops the audio thread, unloads every
+	// sound and music track and deletes the backend.
 	~MySoundEngine();
 
-	// Releases the memory and COM objects=. Needs to be called
-	// before closing the program. (Gets called by the constructor,
-	// but best to call it explicitly as well.)
-	// Returns FAILURE if the COM object was not NULL already
-	// Returns SUCCESS otherwise
-	ErrorType Release();
+	// Creates the singleton instance with the given backend, starts the backend
+	// and starts the audio thread.
+	// If the backend fails to start, the error is logged and the engine still runs,
+	// but no sound will load.
+	static MySoundEngine* StartWithBackend(SoundBackend* pBackend);
 
 	// Finds a reference to the specified MySound in the SoundIndex map.
 	// If not found, will return a reference to the empty MySound 
 	MySound& FindSound(SoundIndex);
 
-	IDirectSound8 *lpds;
+	// If a sound from this file is cached, adds a reference and returns it.
+	// Returns: The SoundIndex, or zero if the file has not been loaded.
+	SoundIndex FindCachedSound(const wchar_t filename[]);
+
+	// Adds a sound that has just been loaded to the cache, with one reference
+	void AddToCache(SoundIndex sound);
+
+	// Loads a wave file into a new sound, without looking in the cache.
+	// Returns: A SoundIndex to the loaded file or zero, as LoadWav.
+	SoundIndex LoadWavFile(wchar_t* filename);
+
+	// Finds a voice to play the sound on, in this order of preference:
+	//	An idle voice that is already a copy of the sound
+	//	If the sound has fewer than MAXVOICESPERSOUND voices, an empty slot, then an idle
+	//	voice of another sound, then the playing voice with the lowest priority
+	//	Otherwise, the sound's own playing voice with the lowest priority
+	// A playing voice is only taken if its priority is no higher than the new one,
+	// and of equal priorities the oldest is taken.
+	// Returns: The voice, stopped and holding a copy of the sound, or nullptr if none can be taken.
+	Voice* FindVoice(SoundIndex sound, int priority);
+
+	// Releases the voices copied from a sound. If sound is zero, releases every voice.
+	void ReleaseVoices(SoundIndex sound);
+
+	// Creates a sound from the samples of an entry in the asset pack.
+	// Returns: A SoundIndex to the sound or zero, as LoadWav.
+	SoundIndex LoadPackedWav(wchar_t* filename, const AssetPackEntry& entry);
+
+	// Creates the sound buffer for a sound and fills it with PCM samples.
+	// Returns: SUCCESS, or FAILURE with the reason in the log file.
+	ErrorType CreateBuffer(MySound& sound, int channels, int samplesPerSec, int bitsPerSample,
+		const unsigned char samples[], size_t size);
+
+	// Creates the buffer for a sound reserved by LoadWavAsync, from the decoded samples,
+	// or loads it with LoadWav if the decoder could not read it. If neither worked, the
+	// SoundIndex is removed. Called by AssetLoader::Publish on the main thread.
+	void FinishSound(SoundIndex sound, const LoadedAsset& asset);
+
 	static MySoundEngine* instance;
 
 public:
@@ -60,7 +217,16 @@ public:
 	// Note this function should be called once at the start of the game before using 
 	// "MySoundEngine::Start()"
 	// before using any other methods.
+#ifdef _WIN32
 	static MySoundEngine* Start(HWND hwnd);
+#endif
+
+	// Creates the static singleton MySoundEngine instance on the software mixer.
+	// No window or sound card is needed. Nothing is heard - the mix is written to
+	// outputFile as a 16-bit stereo WAV file, or thrown away if outputFile is nullptr.
+	// Sound is only mixed when RenderAudio is called.
+	// Parameters: samplesPerSec - the output rate
+	static MySoundEngine* StartHeadless(int samplesPerSec = 44100, const wchar_t outputFile[] = nullptr);
 
 		// Postcondition:	A pointer to the instance of MyDrawEngine has been returned.
 	// Call this using "MySoundEngine enginePtr = MySoundEngine::GetInstance();"
@@ -72,25 +238,61 @@ public:
 	// Note that you should call this at the end of your game to avoid a memory leak.
 	static ErrorType Terminate();
 
+#ifdef _WIN32
 	// Returns a string describing the directDraw error for most HRESULTs sent to it
 	static const wchar_t* ErrorString(HRESULT err);
+#endif
 
 	// Loads a wave file and returns a SoundIndex that can be used to
 	// use that sound in other methods.
 	// If the file fails to load (bad format or not found), returns 0.
+	// If an AssetPack has been started and holds a sound packed from a
+	// file of this name, the sound is taken from the pack instead.
+	// If the file has been loaded already, the same SoundIndex is returned
+	// and the sound gains a reference - nothing is read.
 	// Returns: A SoundIndex to the loaded file or zero.
 	// Parameters: filename - Null terminated string with the filename of the file to load
 	SoundIndex LoadWav(wchar_t* filename);
 
-	// Unloads the specified sound from memory
+	// As LoadWav, but if the AssetLoader has been started the file is decoded on one
+	// of its worker threads. The SoundIndex is returned straight away. Playing it does
+	// nothing until the next AssetLoader::Publish after decoding finishes.
+	// If a sound from the same file is already loaded or loading, its index is returned
+	// with another reference, as LoadWav.
+	// Returns: A SoundIndex. If the sound cannot be loaded, the error is written to the
+	//			log when it is published and the index becomes invalid.
+	SoundIndex LoadWavAsync(const wchar_t filename[]);
+
+	// Calls LoadWavAsync for each file in the list. Call AssetLoader::WaitForAll
+	// to block until they have all been loaded.
+	void PrefetchSounds(const wchar_t* const filenames[], int count);
+
+	// Removes one reference to the specified sound. Once every load of the
+	// sound has been matched by an Unload, it is released from memory.
 	// Returns SUCCESS if the sound was found. FAILURE otherwise
 	// Parameters: sound - the PictureIndex of the sound to unload
 	ErrorType Unload(SoundIndex sound);
 
-	// Unloads all sounds from memory
+	// Unloads all sounds from memory, however many references they have
 	// Returns SUCCESS always
 	ErrorType UnloadAllSounds();
 
+	// Postcondition: hits and misses are set to the number of loads answered from the
+	// cache, and the number that had to load a file, since the engine started.
+	// sounds is set to the number of different files loaded now.
+	void GetCacheStats(int& hits, int& misses, int& sounds) const;
+
+	// Postcondition: playing is set to the number of voices playing as of the last call, stolen
+	// to the number of playing voices cut off for another sound, and dropped to the number of
+	// plays that found no voice, since the engine started. Does not wait for the audio thread -
+	// it is asked to count the voices again for the next call.
+	void GetVoiceStats(int& playing, int& stolen, int& dropped);
+
+	// Postcondition: queued is set to the number of commands queued for the audio thread,
+	// and coalesced to the number it skipped because they would change nothing, such as
+	// playing a sound that is already looping, since the engine started.
+	void GetCommandStats(int& queued, int& coalesced) const;
+
 	// Sets the volume of the specified sound. 
 	// 0 is full volume -10000 is silent
 	// Returns SUCCESS if the sound was found. FAILURE otherwise
@@ -113,16 +315,61 @@ public:
 	ErrorType SetPan(SoundIndex sound, int pan);
 
 	// Plays the specified sound.
-	// Returns SUCCESS if the sound was found and can play. FAILURE otherwise
+	// If the sound is already playing and is not looping, it plays again on a voice
+	// from the pool, over the top of itself. See FindVoice for how voices are chosen.
+	// The sound starts on the audio thread shortly after this returns.
+	// Returns SUCCESS if the sound was found. FAILURE otherwise. A play that finds no
+	// voice it can take is dropped on the audio thread, and counted by GetVoiceStats.
 	// Parameters: sound - the PictureIndex of the sound to set
 	// looping - if true, this will cause the sound to loop repeatedly until told to stop
-	ErrorType Play(SoundIndex sound, bool looping=false);
+	// priority - when voices run out, a sound may only cut off voices of the same or lower priority
+	ErrorType Play(SoundIndex sound, bool looping=false, int priority=0);
 
-	// Stops playing the specified sound.
+	// Stops playing the specified sound, and any voices playing copies of it.
 	// Returns SUCCESS if the sound was found. FAILURE otherwise
 	// Parameters: sound - the PictureIndex of the sound to set
 	ErrorType Stop(SoundIndex sound);
 
+	// Opens a wave file to be streamed as music. Only the format is read now - the
+	// samples are read a little at a time while it plays, so long tracks take
+	// almost no memory. Music is separate from sounds, and is not cached.
+	// The file may also be in the AssetPack.
+	// Returns: A MusicIndex to the track, or zero with the reason in the log file.
+	// Parameters: filename - Null terminated string with the filename of the file to stream
+	MusicIndex LoadMusic(const wchar_t filename[]);
+
+	// Plays the specified track from the start.
+	// Returns SUCCESS if the track was found. FAILURE otherwise
+	// Parameters: music - the MusicIndex of the track
+	// looping - if true, the track goes back to the start with no gap until told to stop
+	ErrorType PlayMusic(MusicIndex music, bool looping = true);
+
+	// Stops playing the specified track.
+	// Returns SUCCESS if the track was found. FAILURE otherwise
+	ErrorType StopMusic(MusicIndex music);
+
+	// Sets the volume of the specified track.
+	// 0 is full volume -10000 is silent
+	// Returns SUCCESS if the track was found. FAILURE otherwise
+	ErrorType SetMusicVolume(MusicIndex music, int volume);
+
+	// Returns true if the specified track is playing. A track that is not looping
+	// stops by itself at its end.
+	bool IsMusicPlaying(MusicIndex music);
+
+	// Stops the specified track and closes its file.
+	// Returns SUCCESS if the track was found. FAILURE otherwise
+	ErrorType UnloadMusic(MusicIndex music);
+
+	// Mixes the next numFrames frames of output from the sounds playing now.
+	// Only needed on the headless mixer - DirectSound mixes by itself.
+	// Returns SUCCESS, or FAILURE if the output file could not be written
+	ErrorType RenderAudio(int numFrames);
+
+	// Returns a checksum of all the output mixed so far on the headless mixer,
+	// so a run can be checked against a known result. Zero on DirectSound.
+	unsigned long long GetMixChecksum() const;
+
 };
 
 
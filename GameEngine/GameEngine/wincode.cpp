@@ -1,3 +1,6 @@
+// Modified by 16007006
+// The "record" and "replay" command line flags record the session's input, or replay it
+
 // camera.h
 // Shell engine version 2020
 // Chris Rook
@@ -162,6 +165,12 @@ int WINAPI WinMain(HINSTANCE hInstance,			// A number that registers the instanc
 		
 		g_WindowClosed=false;
 		int gameError=Game::instance.Setup(bFullScreen, g_hWnd, g_hInstance);			// Initialise the game
+
+		// "record" saves the session's input to session.rec, and "replay" plays it back
+		if(gameError != FAILURE && CheckCommandLineFor("record", lpCmdLine)==true)
+			Game::instance.StartRecording(L"session.rec");
+		else if(gameError != FAILURE && CheckCommandLineFor("replay", lpCmdLine)==true)
+			gameError = Game::instance.StartReplay(L"session.rec");
 		g_ApplicationActive=true;							// Window is now foreground
 
 		if (gameError == FAILURE)							// If game failed to initialise